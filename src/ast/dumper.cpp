@@ -0,0 +1,331 @@
+#include "dumper.hpp"
+
+#include "expr.hpp"
+#include "literal.hpp"
+#include "printer.hpp"
+#include "stmt.hpp"
+#include "visit.hpp"
+
+#include "../support/json.hpp"
+
+#include <cstring>
+
+namespace perun {
+namespace ast {
+
+namespace {
+
+template <typename T> void putLittleEndian(char* dst, T value) {
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        dst[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+template <typename T>
+void writeLittleEndian(support::OutputBuffer& out, T value) {
+    char bytes[sizeof(T)];
+    putLittleEndian(bytes, value);
+    out.write(bytes, sizeof(bytes));
+}
+
+// name or value of the node which is stored in the strings section
+const std::string* getNodeString(const Node& node) {
+    if (node.is(Node::Kind::Identifier)) {
+        return &static_cast<const Identifier&>(node).getName();
+    }
+    if (node.is(Node::Kind::LiteralString)) {
+        return &static_cast<const LiteralString&>(node).getValue();
+    }
+    return nullptr;
+}
+
+} // namespace
+
+void JsonDumper::dumpRoot(const Root& root) {
+    out << "{\"kind\":\"Root\",\"first\":" << root.firstTokenIndex()
+        << ",\"last\":" << root.lastTokenIndex() << ",\"children\":[\n";
+
+    bool first = true;
+    for (auto&& decl : root.getDecls()) {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+        dumpNode(*decl);
+    }
+
+    out << "]}\n";
+}
+
+void JsonDumper::dumpTokens(const std::vector<parser::Token>& tokens) {
+    out << "[\n";
+
+    bool first = true;
+    for (auto&& token : tokens) {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+
+        const char* name = token.getName();
+        out << "{\"kind\":"
+            << static_cast<uint64_t>(static_cast<int>(token.getKind()))
+            << ",\"name\":";
+        dumpString(name, std::strlen(name));
+        out << ",\"start\":" << token.start << ",\"end\":" << token.end
+            << '}';
+    }
+
+    out << "]\n";
+}
+
+void JsonDumper::dumpNode(const Node& node) {
+    out << "{\"kind\":\"" << getNodeKindName(node.getKind())
+        << "\",\"first\":" << node.firstTokenIndex()
+        << ",\"last\":" << node.lastTokenIndex();
+
+    dumpAttributes(node);
+
+    bool first = true;
+    forEachChild(node, [&](const Node& child) {
+        out << (first ? ",\"children\":[" : ",");
+        first = false;
+        dumpNode(child);
+    });
+    if (!first) {
+        out << ']';
+    }
+
+    out << '}';
+}
+
+void JsonDumper::dumpAttributes(const Node& node) {
+    // op symbols are shared with the pretty printer
+    Printer printer(out, 0);
+
+    // TODO: use llvm RTTI
+    switch (node.getKind()) {
+    case Node::Kind::Block: {
+        auto&& block = static_cast<const Block&>(node);
+        if (block.isLabeled()) {
+            out << ",\"label\":" << block.getLabelToken();
+        }
+        break;
+    }
+    case Node::Kind::VarDecl: {
+        auto&& varDecl = static_cast<const VarDecl&>(node);
+        out << ",\"const\":" << (varDecl.isConst() ? "true" : "false")
+            << ",\"hasType\":"
+            << (varDecl.getType() != nullptr ? "true" : "false")
+            << ",\"hasInit\":"
+            << (varDecl.getExpr() != nullptr ? "true" : "false");
+        break;
+    }
+    case Node::Kind::FnDecl: {
+        auto&& fnDecl = static_cast<const FnDecl&>(node);
+        out << ",\"pub\":" << (fnDecl.isPub() ? "true" : "false")
+            << ",\"extern\":" << (fnDecl.isExtern() ? "true" : "false")
+            << ",\"export\":" << (fnDecl.isExport() ? "true" : "false");
+        break;
+    }
+    case Node::Kind::AssignStmt: {
+        out << ",\"op\":\"";
+        printer.printAssignOp(static_cast<const AssignStmt&>(node).getOp());
+        out << '"';
+        break;
+    }
+    case Node::Kind::Identifier: {
+        auto&& name = static_cast<const Identifier&>(node).getName();
+        out << ",\"name\":";
+        dumpString(name.data(), name.size());
+        break;
+    }
+    case Node::Kind::PrefixExpr: {
+        out << ",\"op\":\"";
+        printer.printPrefixOp(static_cast<const PrefixExpr&>(node).getOp());
+        out << '"';
+        break;
+    }
+    case Node::Kind::InfixExpr: {
+        out << ",\"op\":\"";
+        printer.printInfixOp(static_cast<const InfixExpr&>(node).getOp());
+        out << '"';
+        break;
+    }
+    case Node::Kind::SuffixExpr: {
+        out << ",\"op\":\"";
+        printer.printSuffixOp(static_cast<const SuffixExpr&>(node).getOp());
+        out << '"';
+        break;
+    }
+    case Node::Kind::LiteralInteger: {
+        out << ",\"value\":"
+            << static_cast<const LiteralInteger&>(node).getValue();
+        break;
+    }
+    case Node::Kind::LiteralString: {
+        auto&& lit = static_cast<const LiteralString&>(node);
+        out << ",\"value\":";
+        dumpString(lit.getValue().data(), lit.getValue().size());
+        out << ",\"c\":" << (lit.isC() ? "true" : "false")
+            << ",\"raw\":" << (lit.isRaw() ? "true" : "false");
+        break;
+    }
+    case Node::Kind::LiteralBoolean: {
+        out << ",\"value\":"
+            << (static_cast<const LiteralBoolean&>(node).getValue()
+                    ? "true"
+                    : "false");
+        break;
+    }
+    default: {
+        // no attributes
+        break;
+    }
+    }
+}
+
+void JsonDumper::dumpString(const char* str, size_t size) {
+    support::writeJSONString(out, support::StringRef(str, size));
+}
+
+constexpr uint32_t BinaryDumper::version;
+constexpr uint32_t BinaryDumper::noParent;
+constexpr uint8_t BinaryDumper::noOp;
+constexpr uint32_t BinaryDumper::recordSize;
+
+void BinaryDumper::dumpRoot(const Root& root) {
+    nodeCount = 0;
+    stringsSize = 0;
+
+    dumpHeader("PRNA", recordSize);
+    dumpNode(root, noParent);
+    dumpStrings(root);
+
+    writeLittleEndian<uint64_t>(out, nodeCount);
+    writeLittleEndian<uint64_t>(out, stringsSize);
+}
+
+void BinaryDumper::dumpTokens(const std::vector<parser::Token>& tokens) {
+    constexpr uint32_t tokenRecordSize = 12;
+    dumpHeader("PRNT", tokenRecordSize);
+
+    for (auto&& token : tokens) {
+        char record[tokenRecordSize];
+        putLittleEndian<uint32_t>(record, token.start);
+        putLittleEndian<uint32_t>(record + 4, token.end);
+        putLittleEndian<uint16_t>(record + 8,
+                                  static_cast<int>(token.getKind()));
+        putLittleEndian<uint16_t>(record + 10, 0);
+        out.write(record, sizeof(record));
+    }
+
+    writeLittleEndian<uint64_t>(out, tokens.size());
+}
+
+void BinaryDumper::dumpNode(const Node& node, uint32_t parent) {
+    Record record{};
+    record.parent = parent;
+    record.firstToken = node.firstTokenIndex();
+    record.lastToken = node.lastTokenIndex();
+    record.kind = static_cast<uint8_t>(node.getKind());
+    record.op = noOp;
+
+    // TODO: use llvm RTTI
+    switch (node.getKind()) {
+    case Node::Kind::Block: {
+        auto&& block = static_cast<const Block&>(node);
+        if (block.isLabeled()) {
+            record.flags |= Labeled;
+            record.value = block.getLabelToken();
+        }
+        break;
+    }
+    case Node::Kind::VarDecl: {
+        auto&& varDecl = static_cast<const VarDecl&>(node);
+        record.flags |= varDecl.isConst() ? Const : 0;
+        record.flags |= varDecl.getType() != nullptr ? HasType : 0;
+        record.flags |= varDecl.getExpr() != nullptr ? HasInit : 0;
+        break;
+    }
+    case Node::Kind::FnDecl: {
+        auto&& fnDecl = static_cast<const FnDecl&>(node);
+        record.flags |= fnDecl.isPub() ? Pub : 0;
+        record.flags |= fnDecl.isExtern() ? Extern : 0;
+        record.flags |= fnDecl.isExport() ? Export : 0;
+        break;
+    }
+    case Node::Kind::AssignStmt: {
+        record.op = static_cast<uint8_t>(
+            static_cast<const AssignStmt&>(node).getOp());
+        break;
+    }
+    case Node::Kind::PrefixExpr: {
+        record.op = static_cast<uint8_t>(
+            static_cast<const PrefixExpr&>(node).getOp());
+        break;
+    }
+    case Node::Kind::InfixExpr: {
+        record.op =
+            static_cast<uint8_t>(static_cast<const InfixExpr&>(node).getOp());
+        break;
+    }
+    case Node::Kind::SuffixExpr: {
+        record.op = static_cast<uint8_t>(
+            static_cast<const SuffixExpr&>(node).getOp());
+        break;
+    }
+    case Node::Kind::LiteralInteger: {
+        record.value = static_cast<const LiteralInteger&>(node).getValue();
+        break;
+    }
+    case Node::Kind::LiteralString: {
+        auto&& lit = static_cast<const LiteralString&>(node);
+        record.flags |= lit.isC() ? CString : 0;
+        record.flags |= lit.isRaw() ? RawString : 0;
+        break;
+    }
+    case Node::Kind::LiteralBoolean: {
+        record.value = static_cast<const LiteralBoolean&>(node).getValue();
+        break;
+    }
+    default: {
+        // no attributes
+        break;
+    }
+    }
+
+    if (auto&& str = getNodeString(node)) {
+        record.value = static_cast<uint64_t>(str->size()) << 32 | stringsSize;
+        stringsSize += str->size();
+    }
+
+    char bytes[recordSize];
+    putLittleEndian(bytes, record.parent);
+    putLittleEndian(bytes + 4, record.firstToken);
+    putLittleEndian(bytes + 8, record.lastToken);
+    putLittleEndian(bytes + 12, record.kind);
+    putLittleEndian(bytes + 13, record.op);
+    putLittleEndian(bytes + 14, record.flags);
+    putLittleEndian(bytes + 16, record.value);
+    out.write(bytes, sizeof(bytes));
+
+    uint32_t index = nodeCount++;
+    forEachChild(node, [&](const Node& child) { dumpNode(child, index); });
+}
+
+void BinaryDumper::dumpStrings(const Node& node) {
+    if (auto&& str = getNodeString(node)) {
+        out << *str;
+    }
+    forEachChild(node, [&](const Node& child) { dumpStrings(child); });
+}
+
+void BinaryDumper::dumpHeader(const char* magic, uint32_t recordSize) {
+    out.write(magic, 4);
+    writeLittleEndian<uint32_t>(out, version);
+    writeLittleEndian<uint32_t>(out, recordSize);
+}
+
+} // namespace ast
+} // namespace perun
@@ -0,0 +1,107 @@
+#ifndef PERUN_AST_DUMPER_HPP
+#define PERUN_AST_DUMPER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "node.hpp"
+
+#include "../parser/token.hpp"
+
+#include "../support/output.hpp"
+
+namespace perun {
+namespace ast {
+
+/// Streams an AST as JSON
+///
+/// Every node is an object with its "kind", "first" and "last" token
+/// indices, kind specific attributes and its non-null "children"
+/// in source order. Nodes are written as they are visited,
+/// nothing is built in memory. The output is compact, with every
+/// top-level declaration on its own line.
+class JsonDumper {
+public:
+    explicit JsonDumper(support::OutputBuffer& out) : out(out) {}
+
+    void dumpRoot(const Root& root);
+
+    /// Writes an array of {"kind", "name", "start", "end"} objects
+    void dumpTokens(const std::vector<parser::Token>& tokens);
+
+private:
+    void dumpNode(const Node& node);
+    void dumpAttributes(const Node& node);
+    void dumpString(const char* str, size_t size);
+
+    support::OutputBuffer& out;
+};
+
+/// Streams an AST as fixed-size little-endian binary records
+///
+/// Layout:
+///   header:  "PRNA", u32 version, u32 record size
+///   records: one per node in preorder, see 'Record'
+///   strings: identifier names and string literal values, concatenated
+///   footer:  u64 node count, u64 strings size
+///
+/// All records have the same size, so the record section can be read
+/// directly into columns. Strings are written by a second walk of the
+/// tree, so the only memory used is the output buffer itself.
+class BinaryDumper {
+public:
+    static constexpr uint32_t version = 1;
+    static constexpr uint32_t noParent = UINT32_MAX;
+    static constexpr uint8_t noOp = UINT8_MAX;
+
+    /// Node flags
+    enum Flags : uint16_t {
+        Const = 1 << 0,
+        Pub = 1 << 1,
+        Extern = 1 << 2,
+        Export = 1 << 3,
+        Labeled = 1 << 4,
+        CString = 1 << 5,
+        RawString = 1 << 6,
+        HasType = 1 << 7,
+        HasInit = 1 << 8,
+    };
+
+    /// Fields of a node record, in the order they are written
+    struct Record {
+        uint32_t parent;     // record index or 'noParent'
+        uint32_t firstToken; // token indices
+        uint32_t lastToken;
+        uint8_t kind; // Node::Kind
+        uint8_t op;   // Assign/Prefix/Infix/SuffixOp or 'noOp'
+        uint16_t flags;
+        // integer or boolean literal value, label token of a Block,
+        // (size << 32 | offset) into the strings for names and strings
+        uint64_t value;
+    };
+    static constexpr uint32_t recordSize = 24;
+
+    explicit BinaryDumper(support::OutputBuffer& out) : out(out) {}
+
+    void dumpRoot(const Root& root);
+
+    /// Writes "PRNT", u32 version, u32 record size (12),
+    /// u32 start, u32 end, u16 kind, u16 padding for every token
+    /// and u64 token count
+    void dumpTokens(const std::vector<parser::Token>& tokens);
+
+private:
+    void dumpNode(const Node& node, uint32_t parent);
+    void dumpStrings(const Node& node);
+    void dumpHeader(const char* magic, uint32_t recordSize);
+
+    support::OutputBuffer& out;
+    uint32_t nodeCount = 0;
+    uint64_t stringsSize = 0;
+};
+
+} // namespace ast
+} // namespace perun
+
+#endif // PERUN_AST_DUMPER_HPP
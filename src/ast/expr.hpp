@@ -16,6 +16,7 @@ public:
 
     virtual size_t firstTokenIndex() const = 0;
     virtual size_t lastTokenIndex() const = 0;
+    virtual void shiftTokens(size_t from, std::ptrdiff_t delta) = 0;
 };
 
 class Identifier : public Expr {
@@ -27,6 +28,9 @@ public:
 
     size_t firstTokenIndex() const override { return idToken; }
     size_t lastTokenIndex() const override { return idToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        shiftToken(idToken, from, delta);
+    }
 
 private:
     std::string name;
@@ -46,6 +50,11 @@ public:
 
     size_t firstTokenIndex() const override { return lParenToken; }
     size_t lastTokenIndex() const override { return rParenToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        expr->shiftTokens(from, delta);
+        shiftToken(lParenToken, from, delta);
+        shiftToken(rParenToken, from, delta);
+    }
 
 private:
     std::unique_ptr<Expr> expr;
@@ -83,8 +92,13 @@ public:
 
     const Expr* getRHS() const { return rhs.get(); }
     Op getOp() const { return op; }
+    size_t getOpToken() const { return opToken; }
     size_t firstTokenIndex() const override { return opToken; }
     size_t lastTokenIndex() const override { return rhs->lastTokenIndex(); }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        rhs->shiftTokens(from, delta);
+        shiftToken(opToken, from, delta);
+    }
 
 private:
     std::unique_ptr<Expr> rhs;
@@ -143,8 +157,14 @@ public:
     const Expr* getLHS() const { return lhs.get(); }
     const Expr* getRHS() const { return rhs.get(); }
     Op getOp() const { return op; }
+    size_t getOpToken() const { return opToken; }
     size_t firstTokenIndex() const override { return lhs->firstTokenIndex(); }
     size_t lastTokenIndex() const override { return rhs->lastTokenIndex(); }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        lhs->shiftTokens(from, delta);
+        rhs->shiftTokens(from, delta);
+        shiftToken(opToken, from, delta);
+    }
 
 private:
     std::unique_ptr<Expr> lhs;
@@ -178,8 +198,13 @@ public:
 
     const Expr* getLHS() const { return lhs.get(); }
     Op getOp() const { return op; }
+    size_t getOpToken() const { return opToken; }
     size_t firstTokenIndex() const override { return lhs->firstTokenIndex(); }
     size_t lastTokenIndex() const override { return opToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        lhs->shiftTokens(from, delta);
+        shiftToken(opToken, from, delta);
+    }
 
 private:
     std::unique_ptr<Expr> lhs;
@@ -189,15 +214,14 @@ private:
 
 class CallExpr : public Expr {
 public:
-    CallExpr(std::unique_ptr<Expr>&& fn,
-             std::vector<std::unique_ptr<Expr>>&& args, size_t leftParenToken,
-             size_t rightParenToken)
+    CallExpr(std::unique_ptr<Expr>&& fn, NodeList<Expr>&& args,
+             size_t leftParenToken, size_t rightParenToken)
         : Expr(Node::Kind::CallExpr), fn(std::move(fn)), args(std::move(args)),
           leftParenToken(leftParenToken), rightParenToken(rightParenToken) {}
 
     const Expr* getFn() const { return fn.get(); }
 
-    const std::vector<std::unique_ptr<Expr>>& getArgs() const { return args; }
+    const NodeList<Expr>& getArgs() const { return args; }
 
     size_t getArgsSize() const { return args.size(); }
 
@@ -208,12 +232,21 @@ public:
 
     void addArg(std::unique_ptr<Expr>&& arg) { args.push_back(std::move(arg)); }
 
+    size_t getLeftParenToken() const { return leftParenToken; }
+    size_t getRightParenToken() const { return rightParenToken; }
+
     size_t firstTokenIndex() const override { return fn->firstTokenIndex(); }
     size_t lastTokenIndex() const override { return rightParenToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        fn->shiftTokens(from, delta);
+        shiftListTokens(args, from, delta);
+        shiftToken(leftParenToken, from, delta);
+        shiftToken(rightParenToken, from, delta);
+    }
 
 private:
     std::unique_ptr<Expr> fn;
-    std::vector<std::unique_ptr<Expr>> args;
+    NodeList<Expr> args;
 
     size_t leftParenToken;
     size_t rightParenToken;
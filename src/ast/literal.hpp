@@ -17,6 +17,7 @@ public:
 
     virtual size_t firstTokenIndex() const = 0;
     virtual size_t lastTokenIndex() const = 0;
+    virtual void shiftTokens(size_t from, std::ptrdiff_t delta) = 0;
 };
 
 class LiteralInteger : public Literal {
@@ -29,6 +30,9 @@ public:
 
     size_t firstTokenIndex() const override { return intToken; }
     size_t lastTokenIndex() const override { return intToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        shiftToken(intToken, from, delta);
+    }
 
 private:
     // TODO: use infinite precision integer
@@ -49,6 +53,9 @@ public:
 
     size_t firstTokenIndex() const override { return strToken; }
     size_t lastTokenIndex() const override { return strToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        shiftToken(strToken, from, delta);
+    }
 
 private:
     const std::string str;
@@ -69,6 +76,9 @@ public:
 
     size_t firstTokenIndex() const override { return boolToken; }
     size_t lastTokenIndex() const override { return boolToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        shiftToken(boolToken, from, delta);
+    }
 
 private:
     const bool value;
@@ -83,6 +93,9 @@ public:
 
     size_t firstTokenIndex() const override { return nilToken; }
     size_t lastTokenIndex() const override { return nilToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        shiftToken(nilToken, from, delta);
+    }
 
 private:
     size_t nilToken;
@@ -96,6 +109,9 @@ public:
 
     size_t firstTokenIndex() const override { return undefinedToken; }
     size_t lastTokenIndex() const override { return undefinedToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override {
+        shiftToken(undefinedToken, from, delta);
+    }
 
 private:
     size_t undefinedToken;
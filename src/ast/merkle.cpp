@@ -0,0 +1,193 @@
+#include "merkle.hpp"
+
+#include <algorithm>
+
+#include "expr.hpp"
+#include "literal.hpp"
+#include "stmt.hpp"
+#include "tree.hpp"
+#include "visit.hpp"
+
+namespace perun {
+namespace ast {
+
+namespace {
+
+/// Hashes nodes bottom-up, every node hashes the words
+/// of its payload followed by the hashes of its children
+class Hasher {
+public:
+    explicit Hasher(const Tree& tree) : tree(tree) {}
+
+    support::Hash128 hash(const Node& node) {
+        // the words of the parents stay below 'mark'
+        const size_t mark = words.size();
+        words.push_back(static_cast<uint64_t>(node.getKind()));
+        addPayload(node);
+
+        forEachChild(node, [this](const Node& child) {
+            const support::Hash128 childHash = hash(child);
+            words.push_back(childHash.low);
+            words.push_back(childHash.high);
+        });
+
+        const support::Hash128 result = support::hash128(
+            words.data() + mark, (words.size() - mark) * sizeof(uint64_t));
+        words.resize(mark);
+        return result;
+    }
+
+private:
+    const Tree& tree;
+    std::vector<uint64_t> words;
+
+    void addString(support::StringRef str) {
+        const support::Hash128 strHash =
+            support::hash128(str.data(), str.size());
+        words.push_back(strHash.low);
+        words.push_back(strHash.high);
+    }
+
+    /// Adds everything but the children, whose presence is added
+    /// where a child is optional
+    void addPayload(const Node& node) {
+        switch (node.getKind()) {
+        case Node::Kind::Root: {
+            break;
+        }
+        case Node::Kind::Block: {
+            auto&& block = static_cast<const Block&>(node);
+            words.push_back(block.isLabeled());
+            if (block.isLabeled()) {
+                auto&& label = tree.getTokens()[block.getLabelToken()];
+                addString(tree.getSource().substr(label.start,
+                                                  label.length()));
+            }
+            break;
+        }
+        case Node::Kind::VarDecl: {
+            auto&& varDecl = static_cast<const VarDecl&>(node);
+            words.push_back(varDecl.isConst());
+            words.push_back(varDecl.getType() != nullptr);
+            words.push_back(varDecl.getExpr() != nullptr);
+            break;
+        }
+        case Node::Kind::ParamDecl: {
+            auto&& paramDecl = static_cast<const ParamDecl&>(node);
+            words.push_back(paramDecl.getIdentifier() != nullptr);
+            break;
+        }
+        case Node::Kind::FnDecl: {
+            auto&& fnDecl = static_cast<const FnDecl&>(node);
+            words.push_back(fnDecl.isPub() * 4 + fnDecl.isExtern() * 2 +
+                            fnDecl.isExport());
+            words.push_back(fnDecl.getParamsSize());
+            words.push_back(fnDecl.getReturnType() != nullptr);
+            words.push_back(fnDecl.getBody() != nullptr);
+            break;
+        }
+        case Node::Kind::Return: {
+            auto&& ret = static_cast<const Return&>(node);
+            words.push_back(ret.getExpr() != nullptr);
+            break;
+        }
+        case Node::Kind::IfStmt: {
+            auto&& ifStmt = static_cast<const IfStmt&>(node);
+            words.push_back(ifStmt.getElseBlock() != nullptr);
+            break;
+        }
+        case Node::Kind::AssignStmt: {
+            auto&& assign = static_cast<const AssignStmt&>(node);
+            words.push_back(static_cast<uint64_t>(assign.getOp()));
+            break;
+        }
+        case Node::Kind::Identifier: {
+            addString(static_cast<const Identifier&>(node).getName());
+            break;
+        }
+        case Node::Kind::GroupedExpr: {
+            break;
+        }
+        case Node::Kind::PrefixExpr: {
+            auto&& expr = static_cast<const PrefixExpr&>(node);
+            words.push_back(static_cast<uint64_t>(expr.getOp()));
+            break;
+        }
+        case Node::Kind::InfixExpr: {
+            auto&& expr = static_cast<const InfixExpr&>(node);
+            words.push_back(static_cast<uint64_t>(expr.getOp()));
+            break;
+        }
+        case Node::Kind::SuffixExpr: {
+            auto&& expr = static_cast<const SuffixExpr&>(node);
+            words.push_back(static_cast<uint64_t>(expr.getOp()));
+            break;
+        }
+        case Node::Kind::CallExpr: {
+            auto&& expr = static_cast<const CallExpr&>(node);
+            words.push_back(expr.getArgsSize());
+            break;
+        }
+        case Node::Kind::LiteralInteger: {
+            auto&& lit = static_cast<const LiteralInteger&>(node);
+            words.push_back(lit.getValue());
+            break;
+        }
+        case Node::Kind::LiteralString: {
+            auto&& lit = static_cast<const LiteralString&>(node);
+            addString(lit.getValue());
+            words.push_back(lit.isC() * 2 + lit.isRaw());
+            break;
+        }
+        case Node::Kind::LiteralBoolean: {
+            auto&& lit = static_cast<const LiteralBoolean&>(node);
+            words.push_back(lit.getValue());
+            break;
+        }
+        case Node::Kind::LiteralNil:
+        case Node::Kind::LiteralUndefined: {
+            break;
+        }
+        }
+    }
+};
+
+} // namespace
+
+MerkleHashes::MerkleHashes(const Tree& tree) {
+    const Root* root = tree.getRoot();
+    if (root == nullptr) {
+        return;
+    }
+
+    Hasher hasher(tree);
+    declHashes.reserve(root->getDecls().size());
+    for (auto&& decl : root->getDecls()) {
+        declHashes.push_back(hasher.hash(*decl));
+    }
+    rootHash = support::hash128(declHashes.data(),
+                                declHashes.size() * sizeof(support::Hash128));
+}
+
+std::vector<size_t>
+MerkleHashes::getChangedDecls(const MerkleHashes& previous,
+                              const MerkleHashes& current) {
+    std::vector<support::Hash128> known = previous.declHashes;
+    std::sort(known.begin(), known.end());
+
+    std::vector<size_t> changed{};
+    for (size_t i = 0; i < current.declHashes.size(); ++i) {
+        if (!std::binary_search(known.begin(), known.end(),
+                                current.declHashes[i])) {
+            changed.push_back(i);
+        }
+    }
+    return changed;
+}
+
+support::Hash128 MerkleHashes::hashNode(const Tree& tree, const Node& node) {
+    return Hasher(tree).hash(node);
+}
+
+} // namespace ast
+} // namespace perun
@@ -0,0 +1,51 @@
+#ifndef PERUN_AST_MERKLE_HPP
+#define PERUN_AST_MERKLE_HPP
+
+#include <vector>
+
+#include "../support/hash.hpp"
+
+#include "node.hpp"
+
+namespace perun {
+namespace ast {
+
+class Tree;
+
+/// Structural (Merkle) hashes of the declarations of a tree
+///
+/// The hash of a node covers its kind, its payload (names, values,
+/// ops, flags) and the hashes of its children, so it is computed
+/// bottom-up. Positions don't take part, which makes whitespace and
+/// comment edits invisible and keeps the hash of a declaration the same
+/// wherever it moves in the file. The hashes are stable between runs.
+class MerkleHashes {
+public:
+    /// Hashes every declaration of 'tree', which needs its tokens
+    explicit MerkleHashes(const Tree& tree);
+
+    /// One per entry of Root::decls, in order
+    const std::vector<support::Hash128>& getDeclHashes() const {
+        return declHashes;
+    }
+
+    /// Hash of the declaration hashes, zero if the tree has no root
+    const support::Hash128& getRootHash() const { return rootHash; }
+
+    /// Returns the indices of the declarations of 'current'
+    /// which have no equal declaration in 'previous'
+    static std::vector<size_t> getChangedDecls(const MerkleHashes& previous,
+                                               const MerkleHashes& current);
+
+    /// Returns the hash of a single node of 'tree'
+    static support::Hash128 hashNode(const Tree& tree, const Node& node);
+
+private:
+    std::vector<support::Hash128> declHashes;
+    support::Hash128 rootHash;
+};
+
+} // namespace ast
+} // namespace perun
+
+#endif // PERUN_AST_MERKLE_HPP
@@ -12,7 +12,8 @@ bool Node::isStmt() const {
     case Kind::ParamDecl:
     case Kind::FnDecl:
     case Kind::Return:
-    case Kind::IfStmt: {
+    case Kind::IfStmt:
+    case Kind::AssignStmt: {
         return true;
     }
     default: { return false; }
@@ -22,7 +23,11 @@ bool Node::isStmt() const {
 bool Node::isExpr() const {
     switch (kind) {
     case Kind::Identifier:
-    case Kind::GroupedExpr: {
+    case Kind::GroupedExpr:
+    case Kind::PrefixExpr:
+    case Kind::InfixExpr:
+    case Kind::SuffixExpr:
+    case Kind::CallExpr: {
         return true;
     }
     default: {
@@ -45,17 +50,152 @@ bool Node::isLiteral() const {
     }
 }
 
+const char* getNodeKindName(Node::Kind kind) {
+    switch (kind) {
+    case Node::Kind::Root: {
+        return "Root";
+    }
+    case Node::Kind::Block: {
+        return "Block";
+    }
+    case Node::Kind::VarDecl: {
+        return "VarDecl";
+    }
+    case Node::Kind::ParamDecl: {
+        return "ParamDecl";
+    }
+    case Node::Kind::FnDecl: {
+        return "FnDecl";
+    }
+    case Node::Kind::Return: {
+        return "Return";
+    }
+    case Node::Kind::IfStmt: {
+        return "IfStmt";
+    }
+    case Node::Kind::AssignStmt: {
+        return "AssignStmt";
+    }
+    case Node::Kind::Identifier: {
+        return "Identifier";
+    }
+    case Node::Kind::GroupedExpr: {
+        return "GroupedExpr";
+    }
+    case Node::Kind::PrefixExpr: {
+        return "PrefixExpr";
+    }
+    case Node::Kind::InfixExpr: {
+        return "InfixExpr";
+    }
+    case Node::Kind::SuffixExpr: {
+        return "SuffixExpr";
+    }
+    case Node::Kind::CallExpr: {
+        return "CallExpr";
+    }
+    case Node::Kind::LiteralInteger: {
+        return "LiteralInteger";
+    }
+    case Node::Kind::LiteralString: {
+        return "LiteralString";
+    }
+    case Node::Kind::LiteralBoolean: {
+        return "LiteralBoolean";
+    }
+    case Node::Kind::LiteralNil: {
+        return "LiteralNil";
+    }
+    case Node::Kind::LiteralUndefined: {
+        return "LiteralUndefined";
+    }
+    }
+    assert(false);
+    return "";
+}
+
 Root::Root()
-    : Node(Node::Kind::Root), decls(std::vector<std::unique_ptr<Stmt>>{}),
-      eofToken(0), hasEofToken(false) {}
+    : Node(Node::Kind::Root), decls(), eofToken(0), hasEofToken(false),
+      hasPendingShift(false) {}
 
 void Root::addDecl(std::unique_ptr<Stmt>&& decl) {
     decls.push_back(std::move(decl));
 }
 
+const NodeList<Stmt>& Root::getDecls() const {
+    if (hasPendingShift.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        applyPendingShift(decls.size());
+    }
+    return decls;
+}
+
+void Root::replaceDecls(size_t begin, size_t end,
+                        NodeList<Stmt>&& replacement) {
+    assert(!hasPendingShift || end <= pendingDecl);
+    const size_t added = replacement.size();
+    replaceListNodes(decls, begin, end, std::move(replacement));
+    if (hasPendingShift) {
+        pendingDecl = pendingDecl + added - (end - begin);
+    }
+}
+
+size_t Root::getDeclFirstToken(size_t i) const {
+    assert(i < decls.size());
+    const size_t first = decls[i]->firstTokenIndex();
+    return hasPendingShift && i >= pendingDecl ? first + pendingShift : first;
+}
+
+Stmt& Root::getShiftedDecl(size_t i) {
+    assert(i < decls.size());
+    applyPendingShift(i + 1);
+    return *decls[i];
+}
+
+void Root::shiftDeclsLazily(size_t decl, size_t from, std::ptrdiff_t delta) {
+    assert(decl <= decls.size());
+    shiftToken(eofToken, from, delta);
+    if (!hasPendingShift) {
+        if (delta == 0) {
+            return;
+        }
+        pendingDecl = decl;
+        pendingFrom = from;
+        pendingShift = delta;
+        hasPendingShift.store(decl < decls.size(), std::memory_order_release);
+        return;
+    }
+
+    if (decl >= pendingDecl) {
+        applyPendingShift(decl);
+    } else if (delta != 0) {
+        // the declarations in between are the only ones not waiting
+        for (size_t i = decl; i < pendingDecl; ++i) {
+            decls[i]->shiftTokens(from, delta);
+        }
+    }
+    pendingShift += delta;
+    hasPendingShift.store(pendingShift != 0 && pendingDecl < decls.size(),
+                          std::memory_order_release);
+}
+
+void Root::applyPendingShift(size_t end) const {
+    if (!hasPendingShift) {
+        return;
+    }
+
+    for (size_t i = pendingDecl; i < end; ++i) {
+        decls[i]->shiftTokens(pendingFrom, pendingShift);
+    }
+    pendingDecl = std::max(pendingDecl, end);
+    if (pendingDecl >= decls.size()) {
+        hasPendingShift.store(false, std::memory_order_release);
+    }
+}
+
 size_t Root::firstTokenIndex() const {
     if (!decls.empty()) {
-        return decls[0]->firstTokenIndex();
+        return getDeclFirstToken(0);
     }
 
     assert(hasEofToken);
@@ -67,5 +207,11 @@ size_t Root::lastTokenIndex() const {
     return eofToken;
 }
 
+void Root::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    applyPendingShift(decls.size());
+    shiftListTokens(decls, from, delta);
+    shiftToken(eofToken, from, delta);
+}
+
 } // namespace ast
 } // namespace perun
@@ -1,17 +1,27 @@
 #ifndef PERUN_AST_NODE_HPP
 #define PERUN_AST_NODE_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+#include "../support/smallvector.hpp"
+
 namespace perun {
 namespace ast {
 
 // pre-declared as opaque to avoid unnecessary include
 class Stmt;
 
+/// Children of a node, most nodes have only a few of them
+template <typename T>
+using NodeList = support::SmallVector<std::unique_ptr<T>, 4>;
+
 class Node {
 public:
     /// Node kinds (end nodes only)
@@ -64,10 +74,113 @@ public:
     virtual size_t firstTokenIndex() const = 0;
     virtual size_t lastTokenIndex() const = 0;
 
+    /// Adds 'delta' to every token index from 'from' on, in this node and
+    /// its children, after the tokens in front of them were replaced
+    virtual void shiftTokens(size_t from, std::ptrdiff_t delta) = 0;
+
+protected:
+    static void shiftToken(size_t& token, size_t from, std::ptrdiff_t delta) {
+        if (token >= from) {
+            token += delta;
+        }
+    }
+
+    /// Shifts the nodes of 'list', which are in source order,
+    /// skipping the ones which end before 'from'
+    template <typename T>
+    static void shiftListTokens(NodeList<T>& list, size_t from,
+                                std::ptrdiff_t delta) {
+        auto&& it = std::partition_point(
+            list.begin(), list.end(), [&](const std::unique_ptr<T>& node) {
+                return node->lastTokenIndex() < from;
+            });
+        for (; it != list.end(); ++it) {
+            (*it)->shiftTokens(from, delta);
+        }
+    }
+
+    /// Replaces the nodes [begin, end) of 'list' by 'replacement'
+    template <typename T>
+    static void replaceListNodes(NodeList<T>& list, size_t begin, size_t end,
+                                 NodeList<T>&& replacement) {
+        assert(begin <= end && end <= list.size());
+        if (replacement.size() == end - begin) {
+            // the rest of the list stays where it is
+            std::move(replacement.begin(), replacement.end(),
+                      list.begin() + begin);
+            return;
+        }
+
+        NodeList<T> result{};
+        for (size_t i = 0; i < begin; ++i) {
+            result.push_back(std::move(list[i]));
+        }
+        for (auto&& node : replacement) {
+            result.push_back(std::move(node));
+        }
+        for (size_t i = end; i < list.size(); ++i) {
+            result.push_back(std::move(list[i]));
+        }
+        list = std::move(result);
+    }
+
 private:
     Kind kind;
 };
 
+/// Returns the name of a node kind, e.g. "InfixExpr"
+const char* getNodeKindName(Node::Kind kind);
+
+class Root;
+class Block;
+class VarDecl;
+class ParamDecl;
+class FnDecl;
+class Return;
+class IfStmt;
+class AssignStmt;
+class Identifier;
+class GroupedExpr;
+class PrefixExpr;
+class InfixExpr;
+class SuffixExpr;
+class CallExpr;
+class LiteralInteger;
+class LiteralString;
+class LiteralBoolean;
+class LiteralNil;
+class LiteralUndefined;
+
+/// Maps a node class to its kind, e.g. NodeKindOf<Block>::value
+template <typename T> struct NodeKindOf;
+
+#define PERUN_NODE_KIND_OF(NAME)                                               \
+    template <> struct NodeKindOf<NAME> {                                      \
+        static constexpr Node::Kind value = Node::Kind::NAME;                  \
+    };
+
+PERUN_NODE_KIND_OF(Root)
+PERUN_NODE_KIND_OF(Block)
+PERUN_NODE_KIND_OF(VarDecl)
+PERUN_NODE_KIND_OF(ParamDecl)
+PERUN_NODE_KIND_OF(FnDecl)
+PERUN_NODE_KIND_OF(Return)
+PERUN_NODE_KIND_OF(IfStmt)
+PERUN_NODE_KIND_OF(AssignStmt)
+PERUN_NODE_KIND_OF(Identifier)
+PERUN_NODE_KIND_OF(GroupedExpr)
+PERUN_NODE_KIND_OF(PrefixExpr)
+PERUN_NODE_KIND_OF(InfixExpr)
+PERUN_NODE_KIND_OF(SuffixExpr)
+PERUN_NODE_KIND_OF(CallExpr)
+PERUN_NODE_KIND_OF(LiteralInteger)
+PERUN_NODE_KIND_OF(LiteralString)
+PERUN_NODE_KIND_OF(LiteralBoolean)
+PERUN_NODE_KIND_OF(LiteralNil)
+PERUN_NODE_KIND_OF(LiteralUndefined)
+
+#undef PERUN_NODE_KIND_OF
+
 class Root : public Node {
 public:
     explicit Root(); // ctor defined in 'node.cpp'
@@ -78,15 +191,53 @@ public:
         hasEofToken = true;
     }
 
-    const std::vector<std::unique_ptr<Stmt>>& getDecls() const { return decls; }
+    /// Declarations, a pending shift (see shiftDeclsLazily) is applied
+    const NodeList<Stmt>& getDecls() const;
+
+    /// Replaces the declarations [begin, end) by 'replacement'
+    /// A pending shift must not be waiting for any of them.
+    void replaceDecls(size_t begin, size_t end, NodeList<Stmt>&& replacement);
+
+    // for ast::Tree::reparse, which owns the root, the declarations
+    // waiting for a shift are only shifted once they are needed
+
+    size_t getDeclsSize() const { return decls.size(); }
+
+    /// Index of the first token of the declaration 'i'
+    size_t getDeclFirstToken(size_t i) const;
+
+    /// Applies the pending shift to the declarations up to 'i',
+    /// returns the declaration 'i'
+    Stmt& getShiftedDecl(size_t i);
+
+    /// Adds 'delta' to the token indices of the declarations from 'decl'
+    /// on, which are all at or after 'from', and to the end of file
+    /// The declarations are only shifted once they are accessed next,
+    /// then the ones between 'decl' and those of an earlier pending
+    /// shift are shifted right away.
+    void shiftDeclsLazily(size_t decl, size_t from, std::ptrdiff_t delta);
 
     size_t firstTokenIndex() const override;
     size_t lastTokenIndex() const override;
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
-    std::vector<std::unique_ptr<Stmt>> decls;
+    /// Shifts the declarations [pendingDecl, end) by the pending shift
+    void applyPendingShift(size_t end) const;
+
+    NodeList<Stmt> decls;
     size_t eofToken;
     bool hasEofToken;
+
+    // the declarations from 'pendingDecl' on still have to be shifted by
+    // 'pendingShift', their token indices are all at or after
+    // 'pendingFrom'; 'getDecls' is const, the tree can be shared
+    // between threads
+    mutable std::atomic<bool> hasPendingShift;
+    mutable std::mutex pendingMutex;
+    mutable size_t pendingDecl = 0;
+    mutable size_t pendingFrom = 0;
+    mutable std::ptrdiff_t pendingShift = 0;
 };
 
 } // namespace ast
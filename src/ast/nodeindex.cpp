@@ -0,0 +1,107 @@
+#include "nodeindex.hpp"
+
+#include <algorithm>
+
+#include "tree.hpp"
+#include "visit.hpp"
+
+namespace perun {
+namespace ast {
+
+constexpr NodeIndex::Id NodeIndex::none;
+
+NodeIndex::NodeIndex(const Tree& tree) {
+    const Root* root = tree.getRoot();
+    if (root == nullptr) {
+        return;
+    }
+
+    addNode(tree, *root, none);
+    std::sort(ids.begin(), ids.end());
+
+    // the root also covers the trivia around the declarations
+    starts[0] = 0;
+    ends[0] = static_cast<uint32_t>(tree.getSource().size());
+}
+
+void NodeIndex::addNode(const Tree& tree, const Node& node, Id parent) {
+    const Id id = static_cast<Id>(nodes.size());
+    auto&& tokens = tree.getTokens();
+
+    uint32_t start = UINT32_MAX;
+    uint32_t end = 0;
+    if (node.isNot(Node::Kind::Root)) {
+        start = static_cast<uint32_t>(tokens[node.firstTokenIndex()].start);
+        end = static_cast<uint32_t>(tokens[node.lastTokenIndex()].end);
+    }
+
+    starts.push_back(start);
+    ends.push_back(end);
+    parents.push_back(parent);
+    nodes.push_back(&node);
+    ids.emplace_back(&node, id);
+
+    forEachChild(node, [&](const Node& child) {
+        const Id childId = static_cast<Id>(nodes.size());
+        addNode(tree, child, id);
+
+        // some nodes start after their first child, e.g. PrefixExpr
+        starts[id] = std::min(starts[id], starts[childId]);
+        ends[id] = std::max(ends[id], ends[childId]);
+    });
+}
+
+NodeIndex::Id NodeIndex::getId(const Node& node) const {
+    auto&& it = std::lower_bound(ids.begin(), ids.end(),
+                                 std::make_pair(&node, Id(0)));
+    return it != ids.end() && it->first == &node ? it->second : none;
+}
+
+const Node* NodeIndex::getParent(const Node& node) const {
+    const Id id = getId(node);
+    assert(id != none && "node is not in the tree");
+    const Id parent = parents[id];
+    return parent != none ? nodes[parent] : nullptr;
+}
+
+NodeIndex::Id NodeIndex::findAt(size_t pos) const {
+    if (nodes.empty() || pos >= ends[0]) {
+        return none;
+    }
+
+    // the last node starting at or before 'pos' is either the answer,
+    // or the answer is one of its ancestors (it ended before 'pos')
+    auto&& it = std::upper_bound(starts.begin(), starts.end(), pos);
+    Id id = static_cast<Id>(it - starts.begin()) - 1;
+    while (ends[id] <= pos) {
+        id = parents[id];
+    }
+    return id;
+}
+
+std::vector<NodeIndex::Id> NodeIndex::findInRange(size_t begin,
+                                                  size_t end) const {
+    std::vector<Id> result{};
+    if (begin >= end) {
+        return result;
+    }
+
+    // the nodes starting before 'begin' overlap only if they contain it
+    const Id first = findAt(begin);
+    for (Id id = first; id != none; id = parents[id]) {
+        result.push_back(id);
+    }
+    std::reverse(result.begin(), result.end());
+
+    // all the others start inside of the range
+    auto&& from = std::upper_bound(starts.begin(), starts.end(), begin);
+    auto&& to = std::lower_bound(from, starts.end(), end);
+    for (auto&& it = from; it != to; ++it) {
+        result.push_back(static_cast<Id>(it - starts.begin()));
+    }
+
+    return result;
+}
+
+} // namespace ast
+} // namespace perun
@@ -0,0 +1,78 @@
+#ifndef PERUN_AST_NODEINDEX_HPP
+#define PERUN_AST_NODEINDEX_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "node.hpp"
+
+namespace perun {
+namespace ast {
+
+class Tree;
+
+/// Interval index of the nodes of a tree by their position in the source
+///
+/// The nodes are kept in pre-order in flat arrays: the byte span of each
+/// (from the start of its first token to the end of its last one,
+/// widened to cover its children) and its parent. Spans of siblings
+/// don't overlap, so the starts are sorted and the innermost node at
+/// a position is a binary search followed by a few steps up the parents.
+/// The root spans the whole file.
+class NodeIndex {
+public:
+    using Id = uint32_t;
+
+    /// Id of no node, e.g. the parent of the root
+    static constexpr Id none = UINT32_MAX;
+
+    /// Indexes the root of 'tree' and its tokens, which must be there
+    explicit NodeIndex(const Tree& tree);
+
+    /// Number of indexed nodes, the root has id 0
+    size_t size() const { return nodes.size(); }
+
+    const Node& getNode(Id id) const {
+        assert(id < nodes.size());
+        return *nodes[id];
+    }
+
+    /// Byte span of a node
+    size_t getStart(Id id) const { return starts[id]; }
+    size_t getEnd(Id id) const { return ends[id]; }
+
+    Id getParent(Id id) const { return parents[id]; }
+
+    /// Returns the id of 'node', 'none' if it is not in the tree
+    Id getId(const Node& node) const;
+
+    /// Returns the parent of 'node', null for the root
+    /// Asserts that 'node' is in the tree.
+    const Node* getParent(const Node& node) const;
+
+    /// Returns the innermost node whose span contains 'pos',
+    /// 'none' if 'pos' is past the end of the file
+    Id findAt(size_t pos) const;
+
+    /// Returns the nodes whose spans overlap [begin, end), in pre-order
+    std::vector<Id> findInRange(size_t begin, size_t end) const;
+
+private:
+    // indexed by id, in pre-order
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> ends;
+    std::vector<Id> parents;
+    std::vector<const Node*> nodes;
+
+    // sorted by the node, for the parents of nodes
+    std::vector<std::pair<const Node*, Id>> ids;
+
+    void addNode(const Tree& tree, const Node& node, Id parent);
+};
+
+} // namespace ast
+} // namespace perun
+
+#endif // PERUN_AST_NODEINDEX_HPP
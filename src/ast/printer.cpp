@@ -10,17 +10,13 @@
 namespace perun {
 namespace ast {
 
-void Printer::printIndent() {
-    for (size_t i = 0; i < indent; ++i) {
-        os << ' ';
-    }
-}
+void Printer::printIndent() { out.writeSpaces(indent); }
 
 void Printer::printRoot(const Root& root) {
     for (auto&& decl : root.getDecls()) {
         printIndent();
         printStmt(*decl);
-        os << '\n';
+        out << '\n';
     }
 }
 
@@ -65,47 +61,47 @@ void Printer::printStmt(const Stmt& stmt) {
 void Printer::printBlock(const Block& block) {
     auto&& stmts = block.getStmts();
     if (stmts.empty()) {
-        os << "{}";
+        out << "{}";
         return;
     }
 
-    os << "{\n";
+    out << "{\n";
     indent += 4;
     for (auto&& stmt : stmts) {
         printIndent();
         printStmt(*stmt);
-        os << '\n';
+        out << '\n';
     }
 
     indent -= 4;
     printIndent();
-    os << "}";
+    out << "}";
 }
 
 void Printer::printVarDecl(const VarDecl& varDecl) {
     auto&& mutabilityStr = varDecl.isConst() ? "const" : "var";
-    os << mutabilityStr << ' ' << varDecl.getIdentifier()->getName();
+    out << mutabilityStr << ' ' << varDecl.getIdentifier()->getName();
 
     auto&& type = varDecl.getType();
     if (type != nullptr) {
-        os << ": ";
+        out << ": ";
         printExpr(*type);
     }
 
     auto&& expr = varDecl.getExpr();
     if (expr != nullptr) {
-        os << " = ";
+        out << " = ";
         printExpr(*expr);
     }
 
-    os << ";";
+    out << ";";
 }
 
 void Printer::printParamDecl(const ParamDecl& paramDecl) {
     auto&& identifier = paramDecl.getIdentifier();
     if (identifier != nullptr) {
         printIdentifier(*identifier);
-        os << ": ";
+        out << ": ";
     }
 
     auto&& typeExpr = paramDecl.getType();
@@ -114,16 +110,16 @@ void Printer::printParamDecl(const ParamDecl& paramDecl) {
 
 void Printer::printFnDecl(const FnDecl& fnDecl) {
     if (fnDecl.isPub()) {
-        os << "pub ";
+        out << "pub ";
     }
 
     if (fnDecl.isExtern()) {
-        os << "extern ";
+        out << "extern ";
     } else if (fnDecl.isExport()) {
-        os << "export ";
+        out << "export ";
     }
 
-    os << "fn ";
+    out << "fn ";
 
     auto&& identifier = fnDecl.getIdentifier();
     if (identifier != nullptr) {
@@ -131,7 +127,7 @@ void Printer::printFnDecl(const FnDecl& fnDecl) {
     }
 
     { // params
-        os << "(";
+        out << "(";
 
         size_t paramsSize = fnDecl.getParamsSize();
         for (size_t i = 0; i < paramsSize; ++i) {
@@ -139,54 +135,54 @@ void Printer::printFnDecl(const FnDecl& fnDecl) {
             printParamDecl(*param);
 
             if (i + 1 < paramsSize) {
-                os << ", ";
+                out << ", ";
             }
         }
 
-        os << ")";
+        out << ")";
     }
 
     auto&& returnType = fnDecl.getReturnType();
     if (returnType != nullptr) {
-        os << " -> ";
+        out << " -> ";
         printExpr(*returnType);
     }
 
     auto&& body = fnDecl.getBody();
     if (body != nullptr) {
-        os << " ";
+        out << " ";
         printBlock(*body);
     } else {
-        os << ";\n";
+        out << ";\n";
     }
 }
 
 void Printer::printReturn(const Return& ret) {
-    os << "return";
+    out << "return";
 
     auto&& expr = ret.getExpr();
     if (expr != nullptr) {
-        os << ' ';
+        out << ' ';
         printExpr(*expr);
     }
 
-    os << ";";
+    out << ";";
 }
 
 void Printer::printIfStmt(const IfStmt& ifStmt) {
-    os << "if ";
+    out << "if ";
 
     auto&& condition = ifStmt.getCondition();
     printExpr(*condition);
 
-    os << ' ';
+    out << ' ';
 
     auto&& then = ifStmt.getThenBlock();
     printBlock(*then);
 
     auto&& otherwise = ifStmt.getElseBlock();
     if (otherwise != nullptr) {
-        os << " else ";
+        out << " else ";
         printBlock(*otherwise);
     }
 }
@@ -200,16 +196,16 @@ void Printer::printAssignStmt(const AssignStmt& assign) {
     if (lhs != nullptr) {
         printExpr(*lhs);
     } else /* is it a discarding assignment (has underscore as LHS) */ {
-        os << '_';
+        out << '_';
 
         assert(assign.is(AssignOp::Assign)); // sanity check
     }
-    os << ' ';
+    out << ' ';
     printAssignOp(assign.getOp());
-    os << ' ';
+    out << ' ';
     printExpr(*rhs);
 
-    os << ';';
+    out << ';';
 }
 
 void Printer::printExpr(const Expr& expr) {
@@ -254,16 +250,16 @@ void Printer::printExpr(const Expr& expr) {
     }
 }
 
-void Printer::printIdentifier(const Identifier& id) { os << id.getName(); }
+void Printer::printIdentifier(const Identifier& id) { out << id.getName(); }
 
 void Printer::printGroupedExpr(const GroupedExpr& grouped) {
-    os << '(';
+    out << '(';
 
     auto&& inner = grouped.getExpr();
     assert(inner != nullptr);
     printExpr(*inner);
 
-    os << ')';
+    out << ')';
 }
 
 void Printer::printPrefixExpr(const PrefixExpr& expr) {
@@ -282,9 +278,9 @@ void Printer::printInfixExpr(const InfixExpr& expr) {
     assert(lhs != nullptr && rhs != nullptr);
 
     printExpr(*lhs);
-    os << ' ';
+    out << ' ';
     printInfixOp(expr.getOp());
-    os << ' ';
+    out << ' ';
     printExpr(*rhs);
 }
 
@@ -305,7 +301,7 @@ void Printer::printCallExpr(const CallExpr& expr) {
     printExpr(*fn);
 
     { // args
-        os << '(';
+        out << '(';
 
         size_t argsSize = expr.getArgsSize();
         for (size_t i = 0; i < argsSize; ++i) {
@@ -314,10 +310,10 @@ void Printer::printCallExpr(const CallExpr& expr) {
             printExpr(*arg);
 
             if (i + 1 < argsSize) {
-                os << ", ";
+                out << ", ";
             }
         }
-        os << ')';
+        out << ')';
     }
 }
 
@@ -352,65 +348,65 @@ void Printer::printLiteral(const Literal& lit) {
 }
 
 void Printer::printLiteralInteger(const LiteralInteger& lit) {
-    os << lit.getValue();
+    out.writeUnsigned(lit.getValue());
 }
 
 void Printer::printLiteralString(const LiteralString& lit) {
     // TODO: handle escapes, raw strings, c strings
-    os << "\"" << lit.getValue() << "\"";
+    out << "\"" << lit.getValue() << "\"";
 }
 
 void Printer::printLiteralBoolean(const LiteralBoolean& lit) {
     auto&& boolStr = lit.getValue() ? "true" : "false";
-    os << boolStr;
+    out << boolStr;
 }
 
-void Printer::printLiteralNil(const LiteralNil& lit) { os << "nil"; }
+void Printer::printLiteralNil(const LiteralNil& lit) { out << "nil"; }
 
 void Printer::printLiteralUndefined(const LiteralUndefined& lit) {
-    os << "undefined";
+    out << "undefined";
 }
 
 void Printer::printAssignOp(const AssignOp& op) {
     switch (op) {
     case AssignOp::Assign: {
-        os << "=";
+        out << "=";
         return;
     }
     case AssignOp::AssignAdd: {
-        os << "+=";
+        out << "+=";
         return;
     }
     case AssignOp::AssignBitAnd: {
-        os << "&=";
+        out << "&=";
         return;
     }
     case AssignOp::AssignBitOr: {
-        os << "|=";
+        out << "|=";
         return;
     }
     case AssignOp::AssignBitSHL: {
-        os << "<<=";
+        out << "<<=";
         return;
     }
     case AssignOp::AssignBitSHR: {
-        os << ">>=";
+        out << ">>=";
         return;
     }
     case AssignOp::AssignDiv: {
-        os << "/=";
+        out << "/=";
         return;
     }
     case AssignOp::AssignMod: {
-        os << "%=";
+        out << "%=";
         return;
     }
     case AssignOp::AssignMul: {
-        os << "*=";
+        out << "*=";
         return;
     }
     case AssignOp::AssignSub: {
-        os << "-=";
+        out << "-=";
         return;
     }
     default: { assert(false); }
@@ -420,23 +416,23 @@ void Printer::printAssignOp(const AssignOp& op) {
 void Printer::printPrefixOp(const PrefixOp& op) {
     switch (op) {
     case PrefixOp::Address: {
-        os << '&';
+        out << '&';
         return;
     }
     case PrefixOp::BitNot: {
-        os << '~';
+        out << '~';
         return;
     }
     case PrefixOp::BoolNot: {
-        os << '!';
+        out << '!';
         return;
     }
     case PrefixOp::Negate: {
-        os << '-';
+        out << '-';
         return;
     }
     case PrefixOp::OptionalType: {
-        os << '?';
+        out << '?';
         return;
     }
     default: { assert(false); }
@@ -446,71 +442,71 @@ void Printer::printPrefixOp(const PrefixOp& op) {
 void Printer::printInfixOp(const InfixOp& op) {
     switch (op) {
     case InfixOp::BitAnd: {
-        os << "&";
+        out << "&";
         return;
     }
     case InfixOp::BitOr: {
-        os << "|";
+        out << "|";
         return;
     }
     case InfixOp::BitSHL: {
-        os << "<<";
+        out << "<<";
         return;
     }
     case InfixOp::BitSHR: {
-        os << ">>";
+        out << ">>";
         return;
     }
     case InfixOp::BoolAnd: {
-        os << "and";
+        out << "and";
         return;
     }
     case InfixOp::BoolOr: {
-        os << "or";
+        out << "or";
         return;
     }
     case InfixOp::EqualEqual: {
-        os << "==";
+        out << "==";
         return;
     }
     case InfixOp::Greater: {
-        os << ">";
+        out << ">";
         return;
     }
     case InfixOp::GreaterEqual: {
-        os << ">=";
+        out << ">=";
         return;
     }
     case InfixOp::Less: {
-        os << "<";
+        out << "<";
         return;
     }
     case InfixOp::LessEqual: {
-        os << "<=";
+        out << "<=";
         return;
     }
     case InfixOp::NotEqual: {
-        os << "!=";
+        out << "!=";
         return;
     }
     case InfixOp::Div: {
-        os << "/";
+        out << "/";
         return;
     }
     case InfixOp::Mod: {
-        os << "%";
+        out << "%";
         return;
     }
     case InfixOp::Mul: {
-        os << "*";
+        out << "*";
         return;
     }
     case InfixOp::Add: {
-        os << "+";
+        out << "+";
         return;
     }
     case InfixOp::Sub: {
-        os << "-";
+        out << "-";
         return;
     }
     default: { assert(false); }
@@ -520,11 +516,11 @@ void Printer::printInfixOp(const InfixOp& op) {
 void Printer::printSuffixOp(const SuffixOp& op) {
     switch (op) {
     case SuffixOp::Deref: {
-        os << "^";
+        out << "^";
         return;
     }
     case SuffixOp::Unwrap: {
-        os << "?";
+        out << "?";
         return;
     }
     default: { assert(false); }
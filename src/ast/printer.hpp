@@ -1,7 +1,9 @@
 #ifndef PERUN_AST_PRINTER_HPP
 #define PERUN_AST_PRINTER_HPP
 
-#include <ostream>
+#include <cstddef>
+
+#include "../support/output.hpp"
 
 namespace perun {
 namespace ast {
@@ -41,7 +43,8 @@ enum class SuffixOp : short;
 // TODO: generalize this into a proper recursive AST visitor
 class Printer {
 public:
-    Printer(std::ostream& os, size_t indent) : os(os), indent(indent) {}
+    Printer(support::OutputBuffer& out, size_t indent)
+        : out(out), indent(indent) {}
 
     void printRoot(const Root& root);
 
@@ -78,7 +81,7 @@ public:
 private:
     void printIndent();
 
-    std::ostream& os;
+    support::OutputBuffer& out;
     size_t indent;
 };
 
@@ -0,0 +1,429 @@
+#include "serializer.hpp"
+
+#include "expr.hpp"
+#include "literal.hpp"
+#include "stmt.hpp"
+
+namespace perun {
+namespace ast {
+
+namespace {
+
+// kind checks for Deserializer::readAs
+bool matches(const Node& node, const Stmt*) { return node.isStmt(); }
+bool matches(const Node& node, const Expr*) { return node.isExpr(); }
+bool matches(const Node& node, const Identifier*) {
+    return node.is(Node::Kind::Identifier);
+}
+bool matches(const Node& node, const Block*) {
+    return node.is(Node::Kind::Block);
+}
+bool matches(const Node& node, const ParamDecl*) {
+    return node.is(Node::Kind::ParamDecl);
+}
+
+} // namespace
+
+void Serializer::writeRoot(const Root& root) {
+    auto&& decls = root.getDecls();
+    writer.writeVarint(decls.size());
+    for (auto&& decl : decls) {
+        writeNode(decl.get());
+    }
+    writer.writeVarint(root.lastTokenIndex());
+}
+
+void Serializer::writeNode(const Node* node) {
+    if (node == nullptr) {
+        writer.writeVarint(0);
+        return;
+    }
+
+    writer.writeVarint(static_cast<uint64_t>(node->getKind()) + 1);
+
+    // TODO: use llvm RTTI
+    switch (node->getKind()) {
+    case Node::Kind::Root: {
+        // roots are never nested
+        assert(false);
+        break;
+    }
+    case Node::Kind::Block: {
+        auto&& block = static_cast<const Block&>(*node);
+        writer.writeVarint(block.firstTokenIndex());
+        writer.writeVarint(block.lastTokenIndex());
+        writer.writeBool(block.isLabeled());
+        if (block.isLabeled()) {
+            writer.writeVarint(block.getLabelToken());
+        }
+        writer.writeVarint(block.getStmts().size());
+        for (auto&& stmt : block.getStmts()) {
+            writeNode(stmt.get());
+        }
+        break;
+    }
+    case Node::Kind::VarDecl: {
+        auto&& varDecl = static_cast<const VarDecl&>(*node);
+        writer.writeBool(varDecl.isConst());
+        writer.writeVarint(varDecl.firstTokenIndex());
+        writer.writeVarint(varDecl.lastTokenIndex());
+        writeNode(varDecl.getIdentifier());
+        writeNode(varDecl.getType());
+        writeNode(varDecl.getExpr());
+        break;
+    }
+    case Node::Kind::ParamDecl: {
+        auto&& paramDecl = static_cast<const ParamDecl&>(*node);
+        writeNode(paramDecl.getIdentifier());
+        writeNode(paramDecl.getType());
+        break;
+    }
+    case Node::Kind::FnDecl: {
+        auto&& fnDecl = static_cast<const FnDecl&>(*node);
+        writer.writeBool(fnDecl.isPub());
+        writer.writeBool(fnDecl.isExtern());
+        writer.writeBool(fnDecl.isExport());
+        writer.writeVarint(fnDecl.getFnToken());
+        writer.writeVarint(fnDecl.getPubToken());
+        writer.writeVarint(fnDecl.getModifierToken());
+        writer.writeVarint(fnDecl.getSemicolonToken());
+        writeNode(fnDecl.getIdentifier());
+        writer.writeVarint(fnDecl.getParamsSize());
+        for (auto&& param : fnDecl.getParams()) {
+            writeNode(param.get());
+        }
+        writeNode(fnDecl.getReturnType());
+        writeNode(fnDecl.getBody());
+        break;
+    }
+    case Node::Kind::Return: {
+        auto&& ret = static_cast<const Return&>(*node);
+        writer.writeVarint(ret.firstTokenIndex());
+        writer.writeVarint(ret.lastTokenIndex());
+        writeNode(ret.getExpr());
+        break;
+    }
+    case Node::Kind::IfStmt: {
+        auto&& ifStmt = static_cast<const IfStmt&>(*node);
+        writer.writeVarint(ifStmt.firstTokenIndex());
+        writer.writeVarint(ifStmt.getElseToken());
+        writeNode(ifStmt.getCondition());
+        writeNode(ifStmt.getThenBlock());
+        writeNode(ifStmt.getElseBlock());
+        break;
+    }
+    case Node::Kind::AssignStmt: {
+        auto&& assign = static_cast<const AssignStmt&>(*node);
+        writer.writeVarint(static_cast<uint64_t>(assign.getOp()));
+        writer.writeVarint(assign.getOpToken());
+        writer.writeVarint(assign.lastTokenIndex());
+        writeNode(assign.getLHS());
+        writeNode(assign.getRHS());
+        break;
+    }
+    case Node::Kind::Identifier: {
+        auto&& id = static_cast<const Identifier&>(*node);
+        writer.writeString(id.getName());
+        writer.writeVarint(id.firstTokenIndex());
+        break;
+    }
+    case Node::Kind::GroupedExpr: {
+        auto&& grouped = static_cast<const GroupedExpr&>(*node);
+        writer.writeVarint(grouped.firstTokenIndex());
+        writer.writeVarint(grouped.lastTokenIndex());
+        writeNode(grouped.getExpr());
+        break;
+    }
+    case Node::Kind::PrefixExpr: {
+        auto&& expr = static_cast<const PrefixExpr&>(*node);
+        writer.writeVarint(static_cast<uint64_t>(expr.getOp()));
+        writer.writeVarint(expr.getOpToken());
+        writeNode(expr.getRHS());
+        break;
+    }
+    case Node::Kind::InfixExpr: {
+        auto&& expr = static_cast<const InfixExpr&>(*node);
+        writer.writeVarint(static_cast<uint64_t>(expr.getOp()));
+        writer.writeVarint(expr.getOpToken());
+        writeNode(expr.getLHS());
+        writeNode(expr.getRHS());
+        break;
+    }
+    case Node::Kind::SuffixExpr: {
+        auto&& expr = static_cast<const SuffixExpr&>(*node);
+        writer.writeVarint(static_cast<uint64_t>(expr.getOp()));
+        writer.writeVarint(expr.getOpToken());
+        writeNode(expr.getLHS());
+        break;
+    }
+    case Node::Kind::CallExpr: {
+        auto&& expr = static_cast<const CallExpr&>(*node);
+        writer.writeVarint(expr.getLeftParenToken());
+        writer.writeVarint(expr.getRightParenToken());
+        writeNode(expr.getFn());
+        writer.writeVarint(expr.getArgsSize());
+        for (auto&& arg : expr.getArgs()) {
+            writeNode(arg.get());
+        }
+        break;
+    }
+    case Node::Kind::LiteralInteger: {
+        auto&& lit = static_cast<const LiteralInteger&>(*node);
+        writer.writeVarint(lit.getValue());
+        writer.writeVarint(lit.firstTokenIndex());
+        break;
+    }
+    case Node::Kind::LiteralString: {
+        auto&& lit = static_cast<const LiteralString&>(*node);
+        writer.writeString(lit.getValue());
+        writer.writeBool(lit.isC());
+        writer.writeBool(lit.isRaw());
+        writer.writeVarint(lit.firstTokenIndex());
+        break;
+    }
+    case Node::Kind::LiteralBoolean: {
+        auto&& lit = static_cast<const LiteralBoolean&>(*node);
+        writer.writeBool(lit.getValue());
+        writer.writeVarint(lit.firstTokenIndex());
+        break;
+    }
+    case Node::Kind::LiteralNil:
+    case Node::Kind::LiteralUndefined: {
+        writer.writeVarint(node->firstTokenIndex());
+        break;
+    }
+    }
+}
+
+std::unique_ptr<Root> Deserializer::readRoot() {
+    auto root = std::make_unique<Root>();
+
+    uint64_t declsSize = reader.readVarint();
+    for (uint64_t i = 0; i < declsSize && !failed && !reader.failed(); ++i) {
+        root->addDecl(readAs<Stmt>(false));
+    }
+    root->setEOFToken(readToken());
+
+    if (failed || reader.failed()) {
+        return nullptr;
+    }
+
+    return root;
+}
+
+template <typename T> std::unique_ptr<T> Deserializer::readAs(bool nullable) {
+    auto&& node = readNode();
+    if (node == nullptr) {
+        if (!nullable) {
+            failed = true;
+        }
+        return nullptr;
+    }
+
+    if (!matches(*node, static_cast<const T*>(nullptr))) {
+        failed = true;
+        return nullptr;
+    }
+
+    return std::unique_ptr<T>(static_cast<T*>(node.release()));
+}
+
+template <typename Op> Op Deserializer::readOp(Op last) {
+    uint64_t value = reader.readVarint();
+    if (value > static_cast<uint64_t>(last)) {
+        failed = true;
+        return Op::Invalid;
+    }
+    return static_cast<Op>(value);
+}
+
+size_t Deserializer::readToken() {
+    uint64_t index = reader.readVarint();
+    if (index >= tokensSize) {
+        failed = true;
+        return 0;
+    }
+    return static_cast<size_t>(index);
+}
+
+std::unique_ptr<Node> Deserializer::readNode() {
+    uint64_t tag = reader.readVarint();
+    if (tag == 0 || failed || reader.failed()) {
+        return nullptr;
+    }
+    if (tag - 1 > static_cast<uint64_t>(Node::Kind::LiteralUndefined)) {
+        failed = true;
+        return nullptr;
+    }
+
+    auto kind = static_cast<Node::Kind>(tag - 1);
+    switch (kind) {
+    case Node::Kind::Root: {
+        break;
+    }
+    case Node::Kind::Block: {
+        size_t lBraceToken = readToken();
+        size_t rBraceToken = readToken();
+        bool labeled = reader.readBool();
+        size_t labelToken = labeled ? readToken() : 0;
+
+        NodeList<Stmt> stmts{};
+        uint64_t stmtsSize = reader.readVarint();
+        for (uint64_t i = 0; i < stmtsSize && !failed && !reader.failed();
+             ++i) {
+            stmts.push_back(readAs<Stmt>(false));
+        }
+
+        if (labeled) {
+            return std::make_unique<Block>(lBraceToken, rBraceToken,
+                                           std::move(stmts), labelToken);
+        }
+        return std::make_unique<Block>(lBraceToken, rBraceToken,
+                                       std::move(stmts));
+    }
+    case Node::Kind::VarDecl: {
+        bool constant = reader.readBool();
+        size_t varToken = readToken();
+        size_t semicolonToken = readToken();
+        auto&& identifier = readAs<Identifier>(false);
+        auto&& typeExpr = readAs<Expr>(true);
+        auto&& expr = readAs<Expr>(true);
+        return std::make_unique<VarDecl>(constant, std::move(identifier),
+                                         std::move(typeExpr), std::move(expr),
+                                         varToken, semicolonToken);
+    }
+    case Node::Kind::ParamDecl: {
+        auto&& identifier = readAs<Identifier>(true);
+        auto&& type = readAs<Expr>(false);
+        return std::make_unique<ParamDecl>(std::move(identifier),
+                                           std::move(type));
+    }
+    case Node::Kind::FnDecl: {
+        bool pub = reader.readBool();
+        bool _extern = reader.readBool();
+        bool _export = reader.readBool();
+        size_t fnToken = readToken();
+        size_t pubToken = readToken();
+        size_t modifierToken = readToken();
+        size_t semicolonToken = readToken();
+        auto&& identifier = readAs<Identifier>(true);
+
+        NodeList<ParamDecl> params{};
+        uint64_t paramsSize = reader.readVarint();
+        for (uint64_t i = 0; i < paramsSize && !failed && !reader.failed();
+             ++i) {
+            params.push_back(readAs<ParamDecl>(false));
+        }
+
+        auto&& returnType = readAs<Expr>(true);
+        auto&& body = readAs<Block>(true);
+        return std::make_unique<FnDecl>(
+            std::move(identifier), std::move(params), std::move(returnType),
+            std::move(body), pub, _extern, _export, fnToken, pubToken,
+            modifierToken, semicolonToken);
+    }
+    case Node::Kind::Return: {
+        size_t returnToken = readToken();
+        size_t semicolonToken = readToken();
+        auto&& expr = readAs<Expr>(true);
+        return std::make_unique<Return>(std::move(expr), returnToken,
+                                        semicolonToken);
+    }
+    case Node::Kind::IfStmt: {
+        size_t ifToken = readToken();
+        size_t elseToken = readToken();
+        auto&& condition = readAs<Expr>(false);
+        auto&& then = readAs<Block>(false);
+        auto&& otherwise = readAs<Block>(true);
+        return std::make_unique<IfStmt>(std::move(condition), std::move(then),
+                                        std::move(otherwise), ifToken,
+                                        elseToken);
+    }
+    case Node::Kind::AssignStmt: {
+        auto op = readOp(AssignOp::AssignSub);
+        size_t opToken = readToken();
+        size_t semicolonToken = readToken();
+        auto&& lhs = readAs<Expr>(true);
+        auto&& rhs = readAs<Expr>(false);
+        return std::make_unique<AssignStmt>(std::move(lhs), std::move(rhs), op,
+                                            opToken, semicolonToken);
+    }
+    case Node::Kind::Identifier: {
+        std::string name = reader.readString();
+        size_t idToken = readToken();
+        return std::make_unique<Identifier>(std::move(name), idToken);
+    }
+    case Node::Kind::GroupedExpr: {
+        size_t lParenToken = readToken();
+        size_t rParenToken = readToken();
+        auto&& expr = readAs<Expr>(false);
+        return std::make_unique<GroupedExpr>(std::move(expr), lParenToken,
+                                             rParenToken);
+    }
+    case Node::Kind::PrefixExpr: {
+        auto op = readOp(PrefixOp::OptionalType);
+        size_t opToken = readToken();
+        auto&& rhs = readAs<Expr>(false);
+        return std::make_unique<PrefixExpr>(std::move(rhs), op, opToken);
+    }
+    case Node::Kind::InfixExpr: {
+        auto op = readOp(InfixOp::Sub);
+        size_t opToken = readToken();
+        auto&& lhs = readAs<Expr>(false);
+        auto&& rhs = readAs<Expr>(false);
+        return std::make_unique<InfixExpr>(std::move(lhs), std::move(rhs), op,
+                                           opToken);
+    }
+    case Node::Kind::SuffixExpr: {
+        auto op = readOp(SuffixOp::Unwrap);
+        size_t opToken = readToken();
+        auto&& lhs = readAs<Expr>(false);
+        return std::make_unique<SuffixExpr>(std::move(lhs), op, opToken);
+    }
+    case Node::Kind::CallExpr: {
+        size_t leftParenToken = readToken();
+        size_t rightParenToken = readToken();
+        auto&& fn = readAs<Expr>(false);
+
+        NodeList<Expr> args{};
+        uint64_t argsSize = reader.readVarint();
+        for (uint64_t i = 0; i < argsSize && !failed && !reader.failed(); ++i) {
+            args.push_back(readAs<Expr>(false));
+        }
+
+        return std::make_unique<CallExpr>(std::move(fn), std::move(args),
+                                          leftParenToken, rightParenToken);
+    }
+    case Node::Kind::LiteralInteger: {
+        uint64_t value = reader.readVarint();
+        size_t intToken = readToken();
+        return std::make_unique<LiteralInteger>(value, intToken);
+    }
+    case Node::Kind::LiteralString: {
+        std::string str = reader.readString();
+        bool c = reader.readBool();
+        bool raw = reader.readBool();
+        size_t strToken = readToken();
+        return std::make_unique<LiteralString>(std::move(str), c, raw,
+                                               strToken);
+    }
+    case Node::Kind::LiteralBoolean: {
+        bool value = reader.readBool();
+        size_t boolToken = readToken();
+        return std::make_unique<LiteralBoolean>(value, boolToken);
+    }
+    case Node::Kind::LiteralNil: {
+        return std::make_unique<LiteralNil>(readToken());
+    }
+    case Node::Kind::LiteralUndefined: {
+        return std::make_unique<LiteralUndefined>(readToken());
+    }
+    }
+
+    // unknown or misplaced kind
+    failed = true;
+    return nullptr;
+}
+
+} // namespace ast
+} // namespace perun
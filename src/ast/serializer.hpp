@@ -0,0 +1,64 @@
+#ifndef PERUN_AST_SERIALIZER_HPP
+#define PERUN_AST_SERIALIZER_HPP
+
+#include <memory>
+
+#include "node.hpp"
+
+#include "../support/bytes.hpp"
+
+namespace perun {
+namespace ast {
+
+class Stmt;
+class Expr;
+
+/// Writes a compact binary encoding of an AST
+/// Nodes are written in preorder as a kind tag followed by their fields,
+/// all integers are varints. A tag of 0 stands for a null child.
+class Serializer {
+public:
+    explicit Serializer(support::ByteWriter& writer) : writer(writer) {}
+
+    void writeRoot(const Root& root);
+
+private:
+    // 'node' can be null
+    void writeNode(const Node* node);
+
+    support::ByteWriter& writer;
+};
+
+/// Reads an AST written by ast::Serializer
+/// The nodes refer to the 'tokensSize' tokens of their tree.
+class Deserializer {
+public:
+    Deserializer(support::ByteReader& reader, size_t tokensSize)
+        : reader(reader), tokensSize(tokensSize) {}
+
+    /// Returns nullptr if the input is malformed
+    std::unique_ptr<Root> readRoot();
+
+private:
+    // can return null either for a null child or on error
+    std::unique_ptr<Node> readNode();
+
+    /// Reads a node and checks that it is a 'T' (or null if 'nullable')
+    template <typename T> std::unique_ptr<T> readAs(bool nullable);
+
+    /// Reads an operator, values past 'last' mark the input as malformed
+    template <typename Op> Op readOp(Op last);
+
+    /// Reads a token index, indices past the tokens mark the input
+    /// as malformed
+    size_t readToken();
+
+    support::ByteReader& reader;
+    const size_t tokensSize;
+    bool failed = false;
+};
+
+} // namespace ast
+} // namespace perun
+
+#endif // PERUN_AST_SERIALIZER_HPP
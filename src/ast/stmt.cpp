@@ -5,6 +5,15 @@
 namespace perun {
 namespace ast {
 
+void Block::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    shiftListTokens(stmts, from, delta);
+    shiftToken(lBraceToken, from, delta);
+    shiftToken(rBraceToken, from, delta);
+    if (hasLabel) {
+        shiftToken(labelToken, from, delta);
+    }
+}
+
 VarDecl::VarDecl(bool constant, std::unique_ptr<Identifier>&& identifier,
                  std::unique_ptr<Expr>&& typeExpr, std::unique_ptr<Expr>&& expr,
                  size_t varToken, size_t semicolonToken)
@@ -13,6 +22,18 @@ VarDecl::VarDecl(bool constant, std::unique_ptr<Identifier>&& identifier,
       expr(std::move(expr)), varToken(varToken),
       semicolonToken(semicolonToken) {}
 
+void VarDecl::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    identifier->shiftTokens(from, delta);
+    if (typeExpr != nullptr) {
+        typeExpr->shiftTokens(from, delta);
+    }
+    if (expr != nullptr) {
+        expr->shiftTokens(from, delta);
+    }
+    shiftToken(varToken, from, delta);
+    shiftToken(semicolonToken, from, delta);
+}
+
 ParamDecl::ParamDecl(std::unique_ptr<Identifier>&& identifier,
                      std::unique_ptr<Expr>&& type)
     : Stmt(Node::Kind::ParamDecl), identifier(std::move(identifier)),
@@ -27,9 +48,15 @@ size_t ParamDecl::firstTokenIndex() const {
 
 size_t ParamDecl::lastTokenIndex() const { return type->firstTokenIndex(); }
 
+void ParamDecl::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    if (identifier != nullptr) {
+        identifier->shiftTokens(from, delta);
+    }
+    type->shiftTokens(from, delta);
+}
+
 FnDecl::FnDecl(std::unique_ptr<Identifier>&& identifier,
-               std::vector<std::unique_ptr<ParamDecl>>&& params,
-               std::unique_ptr<Expr>&& returnType,
+               NodeList<ParamDecl>&& params, std::unique_ptr<Expr>&& returnType,
                std::unique_ptr<Block>&& body, bool pub, bool _extern,
                bool _export, size_t fnToken, size_t pubToken,
                size_t modifierToken, size_t semicolonToken)
@@ -59,11 +86,37 @@ size_t FnDecl::lastTokenIndex() const {
     return semicolonToken;
 }
 
+void FnDecl::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    if (identifier != nullptr) {
+        identifier->shiftTokens(from, delta);
+    }
+    shiftListTokens(params, from, delta);
+    if (returnType != nullptr) {
+        returnType->shiftTokens(from, delta);
+    }
+    if (body != nullptr) {
+        body->shiftTokens(from, delta);
+    }
+    // the missing ones are 0, which is never shifted
+    shiftToken(fnToken, from, delta);
+    shiftToken(pubToken, from, delta);
+    shiftToken(modifierToken, from, delta);
+    shiftToken(semicolonToken, from, delta);
+}
+
 Return::Return(std::unique_ptr<Expr>&& expr, size_t returnToken,
                size_t semicolonToken)
     : Stmt(Node::Kind::Return), expr(std::move(expr)), returnToken(returnToken),
       semicolonToken(semicolonToken) {}
 
+void Return::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    if (expr != nullptr) {
+        expr->shiftTokens(from, delta);
+    }
+    shiftToken(returnToken, from, delta);
+    shiftToken(semicolonToken, from, delta);
+}
+
 IfStmt::IfStmt(std::unique_ptr<Expr>&& condition, std::unique_ptr<Block>&& then,
                std::unique_ptr<Block>&& otherwise, size_t ifToken,
                size_t elseToken)
@@ -71,13 +124,38 @@ IfStmt::IfStmt(std::unique_ptr<Expr>&& condition, std::unique_ptr<Block>&& then,
       then(std::move(then)), otherwise(std::move(otherwise)), ifToken(ifToken),
       elseToken(elseToken) {}
 
+void IfStmt::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    condition->shiftTokens(from, delta);
+    then->shiftTokens(from, delta);
+    if (otherwise != nullptr) {
+        otherwise->shiftTokens(from, delta);
+        shiftToken(elseToken, from, delta);
+    }
+    shiftToken(ifToken, from, delta);
+}
+
 AssignStmt::AssignStmt(std::unique_ptr<Expr>&& lhs, std::unique_ptr<Expr>&& rhs,
                        Op op, size_t opToken, size_t semicolonToken)
     : Stmt(Node::Kind::AssignStmt), lhs(std::move(lhs)), rhs(std::move(rhs)),
       op(op), opToken(opToken), semicolonToken(semicolonToken) {}
 
-size_t AssignStmt::firstTokenIndex() const { return lhs->firstTokenIndex(); }
+size_t AssignStmt::firstTokenIndex() const {
+    if (lhs == nullptr) {
+        // discarded, '_' is right before the op
+        return opToken - 1;
+    }
+    return lhs->firstTokenIndex();
+}
 size_t AssignStmt::lastTokenIndex() const { return semicolonToken; }
 
+void AssignStmt::shiftTokens(size_t from, std::ptrdiff_t delta) {
+    if (lhs != nullptr) {
+        lhs->shiftTokens(from, delta);
+    }
+    rhs->shiftTokens(from, delta);
+    shiftToken(opToken, from, delta);
+    shiftToken(semicolonToken, from, delta);
+}
+
 } // namespace ast
 } // namespace perun
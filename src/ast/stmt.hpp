@@ -20,35 +20,47 @@ public:
 
     virtual size_t firstTokenIndex() const = 0;
     virtual size_t lastTokenIndex() const = 0;
+    virtual void shiftTokens(size_t from, std::ptrdiff_t delta) = 0;
 };
 
 class Block : public Stmt {
 public:
-    Block(size_t lBraceToken, size_t rBraceToken,
-          std::vector<std::unique_ptr<Stmt>>&& stmts)
+    Block(size_t lBraceToken, size_t rBraceToken, NodeList<Stmt>&& stmts)
         : Stmt(Node::Kind::Block), lBraceToken(lBraceToken),
           rBraceToken(rBraceToken), stmts(std::move(stmts)), labelToken(0),
           hasLabel(false) {}
-    Block(size_t lBraceToken, size_t rBraceToken,
-          std::vector<std::unique_ptr<Stmt>>&& stmts, size_t labelToken)
+    Block(size_t lBraceToken, size_t rBraceToken, NodeList<Stmt>&& stmts,
+          size_t labelToken)
         : Stmt(Node::Kind::Block), lBraceToken(lBraceToken),
           rBraceToken(rBraceToken), stmts(std::move(stmts)),
           labelToken(labelToken), hasLabel(true) {}
 
-    const std::vector<std::unique_ptr<Stmt>>& getStmts() const { return stmts; }
+    const NodeList<Stmt>& getStmts() const { return stmts; }
 
     void addStmt(std::unique_ptr<Stmt>&& stmt) {
         stmts.push_back(std::move(stmt));
     }
 
+    /// Replaces the statements [begin, end) by 'replacement'
+    void replaceStmts(size_t begin, size_t end, NodeList<Stmt>&& replacement) {
+        replaceListNodes(stmts, begin, end, std::move(replacement));
+    }
+
+    bool isLabeled() const { return hasLabel; }
+    size_t getLabelToken() const {
+        assert(hasLabel);
+        return labelToken;
+    }
+
     size_t firstTokenIndex() const override { return lBraceToken; }
     size_t lastTokenIndex() const override { return rBraceToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
     size_t lBraceToken;
     size_t rBraceToken;
 
-    std::vector<std::unique_ptr<Stmt>> stmts;
+    NodeList<Stmt> stmts;
 
     // TODO: use an optional type (?)
     size_t labelToken;
@@ -74,6 +86,7 @@ public:
 
     size_t firstTokenIndex() const override { return varToken; }
     size_t lastTokenIndex() const override { return semicolonToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
     /// true if the vardecl is const
@@ -97,6 +110,7 @@ public:
 
     size_t firstTokenIndex() const override;
     size_t lastTokenIndex() const override;
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
     std::unique_ptr<Identifier> identifier; // can be null
@@ -106,16 +120,14 @@ private:
 class FnDecl : public Stmt {
 public:
     FnDecl(std::unique_ptr<Identifier>&& identifier,
-           std::vector<std::unique_ptr<ParamDecl>>&& params,
-           std::unique_ptr<Expr>&& returnType, std::unique_ptr<Block>&& body,
-           bool pub, bool _extern, bool _export, size_t fnToken,
-           size_t pubToken, size_t modifierToken, size_t semicolonToken);
+           NodeList<ParamDecl>&& params, std::unique_ptr<Expr>&& returnType,
+           std::unique_ptr<Block>&& body, bool pub, bool _extern,
+           bool _export, size_t fnToken, size_t pubToken,
+           size_t modifierToken, size_t semicolonToken);
 
     const Identifier* getIdentifier() const { return identifier.get(); }
 
-    const std::vector<std::unique_ptr<ParamDecl>>& getParams() const {
-        return params;
-    }
+    const NodeList<ParamDecl>& getParams() const { return params; }
 
     size_t getParamsSize() const { return params.size(); }
 
@@ -134,13 +146,19 @@ public:
     bool isExtern() const { return _extern; }
     bool isExport() const { return _export; }
 
+    size_t getFnToken() const { return fnToken; }
+    size_t getPubToken() const { return pubToken; }
+    size_t getModifierToken() const { return modifierToken; }
+    size_t getSemicolonToken() const { return semicolonToken; }
+
     size_t firstTokenIndex() const override;
     size_t lastTokenIndex() const override;
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
     std::unique_ptr<Identifier> identifier; // can be null
 
-    std::vector<std::unique_ptr<ParamDecl>> params;
+    NodeList<ParamDecl> params;
 
     std::unique_ptr<Expr> returnType; // can be null
     std::unique_ptr<Block> body;      // can be null
@@ -166,6 +184,7 @@ public:
 
     size_t firstTokenIndex() const override { return returnToken; }
     size_t lastTokenIndex() const override { return semicolonToken; }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
     std::unique_ptr<Expr> expr; // can be null
@@ -186,6 +205,8 @@ public:
     // can be null
     const Block* getElseBlock() const { return otherwise.get(); }
 
+    size_t getElseToken() const { return elseToken; }
+
     size_t firstTokenIndex() const override { return ifToken; }
     size_t lastTokenIndex() const override {
         if (otherwise != nullptr) {
@@ -193,6 +214,7 @@ public:
         }
         return then->lastTokenIndex();
     }
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
     std::unique_ptr<Expr> condition;
@@ -235,8 +257,10 @@ public:
     const Expr* getLHS() const { return lhs.get(); }
     const Expr* getRHS() const { return rhs.get(); }
     Op getOp() const { return op; }
+    size_t getOpToken() const { return opToken; }
     size_t firstTokenIndex() const override;
     size_t lastTokenIndex() const override;
+    void shiftTokens(size_t from, std::ptrdiff_t delta) override;
 
 private:
     std::unique_ptr<Expr> lhs; // can be null if it is discarded
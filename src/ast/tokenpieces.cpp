@@ -0,0 +1,172 @@
+#include "tokenpieces.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace perun {
+namespace ast {
+
+namespace {
+
+/// More pieces make edits slower than storing the tokens in order again
+constexpr size_t maxPieces = 256;
+
+} // namespace
+
+TokenPieces::TokenPieces(std::vector<parser::Token>&& tokens,
+                         std::unordered_map<size_t, DocComment>&& docComments)
+    : tokens(std::move(tokens)), added(), docComments(std::move(docComments)),
+      pieces(), count(this->tokens.size()) {
+    if (count != 0) {
+        pieces.push_back(Piece{0, 0, count, 0});
+    }
+}
+
+parser::Token TokenPieces::get(size_t index) const {
+    assert(index < count);
+    const Piece& piece = pieces[findPiece(index)];
+    parser::Token token = getStored(piece.stored + (index - piece.start));
+    token.start += piece.shift;
+    token.end += piece.shift;
+    return token;
+}
+
+size_t TokenPieces::findPiece(size_t index) const {
+    auto&& it = std::partition_point(
+        pieces.begin(), pieces.end(),
+        [index](const Piece& piece) { return piece.start <= index; });
+    assert(it != pieces.begin());
+    return (it - pieces.begin()) - 1;
+}
+
+size_t TokenPieces::split(size_t index) {
+    if (index == count) {
+        return pieces.size();
+    }
+
+    const size_t i = findPiece(index);
+    Piece& piece = pieces[i];
+    if (piece.start == index) {
+        return i;
+    }
+
+    const size_t offset = index - piece.start;
+    const Piece tail{index, piece.stored + offset, piece.count - offset,
+                     piece.shift};
+    piece.count = offset;
+    pieces.insert(pieces.begin() + i + 1, tail);
+    return i + 1;
+}
+
+void TokenPieces::replace(
+    size_t first, size_t end, const std::vector<parser::Token>& newTokens,
+    const std::vector<std::pair<size_t, parser::Token>>& newDocComments,
+    std::ptrdiff_t byteDelta) {
+    assert(first <= end && end <= count);
+    const size_t begin = split(first);
+    const size_t last = split(end);
+
+    // the doc comments of the replaced tokens and of the one after them
+    // were lexed again
+    for (size_t i = begin; i < last; ++i) {
+        for (size_t j = 0; j < pieces[i].count; ++j) {
+            docComments.erase(pieces[i].stored + j);
+        }
+    }
+    if (last < pieces.size()) {
+        docComments.erase(pieces[last].stored);
+    }
+
+    const std::ptrdiff_t tokenDelta =
+        static_cast<std::ptrdiff_t>(newTokens.size()) -
+        static_cast<std::ptrdiff_t>(end - first);
+    for (size_t i = last; i < pieces.size(); ++i) {
+        pieces[i].start += tokenDelta;
+        pieces[i].shift += byteDelta;
+    }
+
+    const size_t stored = tokens.size() + added.size();
+    added.insert(added.end(), newTokens.begin(), newTokens.end());
+    pieces.erase(pieces.begin() + begin, pieces.begin() + last);
+    if (!newTokens.empty()) {
+        pieces.insert(pieces.begin() + begin,
+                      Piece{first, stored, newTokens.size(), 0});
+    }
+    count += tokenDelta;
+
+    for (auto&& entry : newDocComments) {
+        size_t key = stored + entry.first;
+        std::ptrdiff_t shift = 0;
+        if (entry.first == newTokens.size()) {
+            // in front of the token after the new ones
+            const Piece& piece = pieces[findPiece(first + newTokens.size())];
+            key = piece.stored;
+            shift = piece.shift;
+        }
+
+        const DocComment comment{entry.second.start - shift,
+                                 entry.second.end - shift};
+        auto&& result = docComments.emplace(key, comment);
+        if (!result.second) {
+            result.first->second.end = comment.end;
+        }
+    }
+}
+
+bool TokenPieces::isFragmented() const {
+    return pieces.size() > maxPieces || added.size() > tokens.size();
+}
+
+void TokenPieces::copy(
+    size_t end, std::vector<parser::Token>& result,
+    std::unordered_map<size_t, DocComment>& resultDocComments) const {
+    assert(end <= count);
+    result.reserve(result.size() + end);
+    for (auto&& piece : pieces) {
+        if (piece.start >= end) {
+            break;
+        }
+        const size_t n = std::min(piece.count, end - piece.start);
+        for (size_t j = 0; j < n; ++j) {
+            parser::Token token = getStored(piece.stored + j);
+            token.start += piece.shift;
+            token.end += piece.shift;
+            result.push_back(token);
+        }
+    }
+
+    if (docComments.empty()) {
+        return;
+    }
+
+    // the piece of a doc comment is found by where its token is stored,
+    // the ones of tokens which were replaced have none
+    std::vector<const Piece*> byStored{};
+    byStored.reserve(pieces.size());
+    for (auto&& piece : pieces) {
+        byStored.push_back(&piece);
+    }
+    std::sort(byStored.begin(), byStored.end(),
+              [](const Piece* a, const Piece* b) {
+                  return a->stored < b->stored;
+              });
+    for (auto&& entry : docComments) {
+        auto&& it = std::partition_point(
+            byStored.begin(), byStored.end(),
+            [&](const Piece* piece) { return piece->stored <= entry.first; });
+        if (it == byStored.begin()) {
+            continue;
+        }
+        const Piece& piece = **(it - 1);
+        const size_t offset = entry.first - piece.stored;
+        if (offset < piece.count && piece.start + offset < end) {
+            resultDocComments.emplace(
+                piece.start + offset,
+                DocComment{entry.second.start + piece.shift,
+                           entry.second.end + piece.shift});
+        }
+    }
+}
+
+} // namespace ast
+} // namespace perun
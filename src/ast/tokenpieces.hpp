@@ -0,0 +1,96 @@
+#ifndef PERUN_AST_TOKENPIECES_HPP
+#define PERUN_AST_TOKENPIECES_HPP
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../parser/token.hpp"
+
+namespace perun {
+namespace ast {
+
+/// Doc comments ('///') in front of a token, from the start of the first
+/// one to the end of the last one
+struct DocComment {
+    size_t start;
+    size_t end;
+};
+
+/// Tokens and doc comments of a tree while ast::Tree::reparse edits them
+///
+/// The tokens are never moved once stored: the ones of an edit are
+/// appended and the pieces list which stored tokens make up the tokens
+/// in order, each moving its tokens by a number of bytes. So an edit
+/// costs its new tokens and the number of pieces, however many tokens
+/// follow it. Doc comments are keyed by where the token after them
+/// is stored and move with it.
+class TokenPieces {
+public:
+    /// Takes the tokens of a tree, the doc comments keyed by token index
+    TokenPieces(std::vector<parser::Token>&& tokens,
+                std::unordered_map<size_t, DocComment>&& docComments);
+
+    size_t size() const { return count; }
+
+    /// Returns the token 'index'
+    parser::Token get(size_t index) const;
+
+    /// Replaces the tokens [first, end) by 'tokens', which were lexed
+    /// together with 'docComments' (keyed by the index in 'tokens' of the
+    /// token after them), and moves the tokens after them by 'byteDelta'
+    /// The doc comments in front of the token 'end' are replaced too,
+    /// they are the ones with the key 'tokens.size()'.
+    void replace(size_t first, size_t end,
+                 const std::vector<parser::Token>& tokens,
+                 const std::vector<std::pair<size_t, parser::Token>>& docComments,
+                 std::ptrdiff_t byteDelta);
+
+    /// True if the pieces or the unused stored tokens cost more
+    /// than storing the tokens in order again
+    bool isFragmented() const;
+
+    /// Appends the tokens before 'end' to 'tokens' and adds their
+    /// doc comments to 'docComments', keyed by token index
+    void copy(size_t end, std::vector<parser::Token>& tokens,
+              std::unordered_map<size_t, DocComment>& docComments) const;
+
+private:
+    /// The tokens [start, start + count), stored from 'stored' on
+    /// and 'shift' bytes off
+    struct Piece {
+        size_t start;
+        size_t stored;
+        size_t count;
+        std::ptrdiff_t shift;
+    };
+
+    /// Index of the piece holding the token 'index'
+    size_t findPiece(size_t index) const;
+
+    /// Splits the piece holding the token 'index' so that a piece starts
+    /// with it, returns the index of that piece (the number of pieces
+    /// for the end)
+    size_t split(size_t index);
+
+    const parser::Token& getStored(size_t stored) const {
+        return stored < tokens.size() ? tokens[stored]
+                                      : added[stored - tokens.size()];
+    }
+
+    // the tokens at the start, followed by the ones of the edits
+    std::vector<parser::Token> tokens;
+    std::vector<parser::Token> added;
+
+    // keyed by where the following token is stored, in its frame
+    std::unordered_map<size_t, DocComment> docComments;
+
+    std::vector<Piece> pieces;
+    size_t count;
+};
+
+} // namespace ast
+} // namespace perun
+
+#endif // PERUN_AST_TOKENPIECES_HPP
@@ -1,65 +1,316 @@
 #include "tree.hpp"
 
+#include <algorithm>
+#include <utility>
+
+#include "../parser/tokenizer.hpp"
+#include "../support/memory.hpp"
+
 namespace perun {
 namespace ast {
 
-/// Returns a relative location from a position
-Loc Tree::getLocFromPos(const size_t pos, const size_t start) const {
-    assert(pos < source.size());
+namespace {
 
-    size_t line = 0;
-    size_t column = 0;
-    size_t line_start_pos = start;
+/// Part of a tree parsed again after an edit: the statements
+/// [firstStmt, endStmt) of 'block', or the declarations of the root
+/// if it is null, and their tokens [firstToken, endToken)
+/// 'decl' is the top-level declaration holding 'block'.
+struct ReparseRange {
+    const Block* block;
+    size_t decl;
+    size_t firstStmt;
+    size_t endStmt;
+    size_t firstToken;
+    size_t endToken;
+};
 
-    // find line, column, line_start_pos
-    for (size_t i = start; i < pos; ++i) {
-        auto&& c = source[i];
-        column++;
+/// The first index in [0, count) for which 'pred' is false,
+/// it has to be true for all indices before it
+template <typename Pred> size_t partitionIndex(size_t count, Pred pred) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (pred(mid)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/// The block of 'stmt' whose braces are outside of the tokens [lo, hi),
+/// null if there is none
+const Block* findEnclosingBlock(const Stmt& stmt, size_t lo, size_t hi) {
+    const Block* blocks[2] = {nullptr, nullptr};
+    if (stmt.is(Node::Kind::FnDecl)) {
+        blocks[0] = static_cast<const FnDecl&>(stmt).getBody();
+    } else if (stmt.is(Node::Kind::IfStmt)) {
+        blocks[0] = static_cast<const IfStmt&>(stmt).getThenBlock();
+        blocks[1] = static_cast<const IfStmt&>(stmt).getElseBlock();
+    }
 
-        if (c == '\n') {
-            line++;
-            column = 0;
-            line_start_pos = i + 1;
+    for (const Block* block : blocks) {
+        if (block != nullptr && block->firstTokenIndex() < lo &&
+            block->lastTokenIndex() >= hi) {
+            return block;
         }
     }
+    return nullptr;
+}
+
+/// True if the parser ended 'stmt', whose last token is 'last',
+/// without looking at the token after it
+/// A missing ';' is only noticed there, an 'if' looks for an 'else'.
+bool endsOnItsOwn(const Stmt* stmt, const parser::Token& last) {
+    if (stmt != nullptr && stmt->is(Node::Kind::IfStmt) &&
+        static_cast<const IfStmt*>(stmt)->getElseBlock() == nullptr) {
+        return false;
+    }
+    return last.isOneOf(parser::Token::Kind::Semicolon,
+                        parser::Token::Kind::RBrace);
+}
 
-    size_t line_end_pos = source.size() - 1;
+/// Finds the statements to parse again after the tokens [lo, hi) changed
+/// Blocks are the only nodes which end the same whatever their insides
+/// are, so the innermost one around the edit is taken. Statements and
+/// declarations end at their last token, so only the ones the edit
+/// touches are replaced, and the one in front of them if it looked
+/// at the token after it (see endsOnItsOwn).
+/// Only the top-level declaration holding the edit is shifted, see
+/// Root::shiftDeclsLazily.
+template <typename TokenAt>
+ReparseRange findReparseRange(Root& root, size_t lo, size_t hi,
+                              const TokenAt& tokenAt) {
+    // only the last declaration starting before the edit can hold it
+    const size_t declsCount = root.getDeclsSize();
+    const size_t decl = partitionIndex(declsCount, [&](size_t i) {
+        return root.getDeclFirstToken(i) < lo;
+    });
+
+    const Block* block = nullptr;
+    if (decl > 0) {
+        block = findEnclosingBlock(root.getShiftedDecl(decl - 1), lo, hi);
+    }
+    for (const Block* inner = block; inner != nullptr;) {
+        block = inner;
+        auto&& stmts = block->getStmts();
+        const size_t i = partitionIndex(stmts.size(), [&](size_t j) {
+            return stmts[j]->firstTokenIndex() < lo;
+        });
+        inner = i > 0 ? findEnclosingBlock(*stmts[i - 1], lo, hi) : nullptr;
+    }
 
-    // find line_end_pos
-    for (size_t i = pos; i < source.size(); ++i) {
-        auto&& c = source[i];
-        if (c == '\n') {
-            line_end_pos = i;
-            break;
+    const size_t count =
+        block != nullptr ? block->getStmts().size() : declsCount;
+    const size_t end =
+        block != nullptr ? block->lastTokenIndex() : root.lastTokenIndex();
+    auto&& getStart = [&](size_t i) {
+        if (i == count) {
+            return end;
         }
+        return block != nullptr ? block->getStmts()[i]->firstTokenIndex()
+                                : root.getDeclFirstToken(i);
+    };
+
+    // the statements starting at or before the edit and up to it
+    size_t firstStmt = partitionIndex(
+        count, [&](size_t i) { return getStart(i) < lo + 1; });
+    if (firstStmt > 0) {
+        --firstStmt;
+    }
+    size_t endStmt =
+        partitionIndex(count, [&](size_t i) { return getStart(i) < hi; });
+    endStmt = std::min(std::max(endStmt, firstStmt + 1), count);
+
+    // declarations are never an 'if'
+    if (firstStmt > 0 &&
+        !endsOnItsOwn(block != nullptr
+                          ? block->getStmts()[firstStmt - 1].get()
+                          : nullptr,
+                      tokenAt(getStart(firstStmt) - 1))) {
+        --firstStmt;
     }
 
-    return Loc(line, column, line_start_pos, line_end_pos);
+    const size_t holder = decl > 0 ? decl - 1 : 0;
+    return ReparseRange{block,   holder,
+                        firstStmt, endStmt,
+                        getStart(firstStmt), getStart(endStmt)};
 }
 
-/// Returns a relative location from a token
-Loc Tree::getLocFromToken(const parser::Token& token,
-                          const size_t start) const {
-    return getLocFromPos(token.start, start);
+/// Lexes 'source' from 'pos' up to the token starting at 'syncPos',
+/// which is left out, into the tokens of 'window', keeping the doc
+/// comments with the index of the token after them
+/// A lexer error ends the tokens with the invalid one of 'window'.
+/// Returns false if no token starts at 'syncPos'.
+bool relex(support::StringRef source, size_t pos, size_t syncPos,
+           parser::TokenWindow& window,
+           std::vector<std::pair<size_t, parser::Token>>& docComments) {
+    parser::Tokenizer tokenizer(source, pos);
+    for (;;) {
+        const parser::Token token = tokenizer.nextToken();
+        if (token.is(parser::Token::Kind::Invalid)) {
+            // the full parse stops there too
+            window.hasInvalid = true;
+            window.invalid = token;
+            window.hasError = tokenizer.hasError();
+            if (window.hasError) {
+                window.error = tokenizer.getError();
+            }
+            return token.start <= syncPos;
+        }
+        if (token.start >= syncPos) {
+            // the rest of the source is the same, so is the rest of tokens
+            return token.start == syncPos;
+        }
+
+        if (token.is(parser::Token::Kind::DocComment)) {
+            docComments.emplace_back(window.tokens.size(), token);
+        } else if (token.isNot(parser::Token::Kind::LineComment)) {
+            window.tokens.push_back(token);
+        }
+    }
+}
+
+} // namespace
+
+SourceEdit mergeEdits(const SourceEdit& edit, const SourceEdit& next) {
+    const size_t start = std::min(edit.offset, next.offset);
+    // the end of both in the source before 'next'
+    const size_t end = std::max(edit.offset + edit.inserted,
+                                next.offset + next.removed);
+    const size_t oldEnd = end - edit.inserted + edit.removed;
+    return SourceEdit{start, oldEnd - start,
+                      end - start - next.removed + next.inserted};
 }
 
-/// Returns a relative location from a token index
-Loc Tree::getLocFromTokenIndex(const size_t tokenIndex,
-                               const size_t start) const {
-    assert(tokenIndex < tokens.size());
-    return getLocFromToken(tokens[tokenIndex], start);
+const NodeIndex& Tree::getNodeIndex() const {
+    std::lock_guard<std::mutex> lock(nodeIndexMutex);
+    if (nodeIndex == nullptr) {
+        nodeIndex = std::make_unique<NodeIndex>(*this);
+    }
+    return *nodeIndex;
 }
 
-std::unique_ptr<Tree> Tree::get(const std::string filename,
-                                const std::string source) {
-    std::vector<ErrorPtr> errors{};
+void Tree::flattenTokens() const {
+    if (!hasPendingTokens.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(tokensMutex);
+    if (pieces != nullptr) {
+        pieces->copy(pieces->size(), tokens, docComments);
+        pieces = nullptr;
+    }
+    if (baseTokens != 0) {
+        std::vector<parser::Token> all{};
+        std::unordered_map<size_t, DocComment> allDocs{};
+        base->copyTokens(baseTokens, all, allDocs);
+        all.insert(all.end(), tokens.begin(), tokens.end());
+        allDocs.insert(docComments.begin(), docComments.end());
+        tokens = std::move(all);
+        docComments = std::move(allDocs);
+        baseTokens = 0;
+    }
+    hasPendingTokens.store(false, std::memory_order_release);
+}
+
+size_t Tree::getTokensSize() const {
+    return pieces != nullptr ? pieces->size() : tokens.size();
+}
+
+parser::Token Tree::getToken(size_t index) const {
+    return pieces != nullptr ? pieces->get(index) : tokens[index];
+}
+
+void Tree::copyTokens(size_t end, std::vector<parser::Token>& result,
+                      std::unordered_map<size_t, DocComment>& resultDocs) const {
+    if (pieces != nullptr) {
+        pieces->copy(end, result, resultDocs);
+        return;
+    }
+
+    result.insert(result.end(), tokens.begin(), tokens.begin() + end);
+    for (auto&& entry : docComments) {
+        if (entry.first < end) {
+            resultDocs.insert(entry);
+        }
+    }
+}
+
+void Tree::addDocComment(size_t tokenIndex, const parser::Token& comment) {
+    auto&& result =
+        docComments.emplace(tokenIndex, DocComment{comment.start, comment.end});
+    if (!result.second) {
+        result.first->second.end = comment.end;
+    }
+}
+
+std::string Tree::getDocText(const DocComment& comment) const {
+    const support::StringRef source = getSource();
+    std::string text{};
+
+    size_t pos = comment.start;
+    while (pos < comment.end) {
+        size_t lineEnd = pos;
+        while (lineEnd < comment.end && source[lineEnd] != '\n') {
+            ++lineEnd;
+        }
+
+        support::StringRef line = source.substr(pos, lineEnd - pos);
+        size_t indent = 0;
+        while (indent < line.size() &&
+               (line[indent] == ' ' || line[indent] == '\t')) {
+            ++indent;
+        }
+        line = line.substr(indent);
+
+        // line comments between doc comments are left out
+        if (line.size() >= 3 && line[0] == '/' && line[1] == '/' &&
+            line[2] == '/' &&
+            (line.size() == 3 || line[3] != '/')) {
+            line = line.substr(line.size() > 3 && line[3] == ' ' ? 4 : 3);
+            text.append(line.data(), line.size());
+            text += '\n';
+        }
+
+        pos = lineEnd + 1;
+    }
+
+    return text;
+}
+
+/// Returns a location from a position in the source
+Loc Tree::getLocFromPos(const size_t pos) const {
+    return sourceManager->getLoc(file, pos);
+}
+
+/// Returns a location from a token
+Loc Tree::getLocFromToken(const parser::Token& token) const {
+    return getLocFromPos(token.start);
+}
+
+/// Returns a location from a token index
+Loc Tree::getLocFromTokenIndex(const size_t tokenIndex) const {
+    auto&& allTokens = getTokens();
+    assert(tokenIndex < allTokens.size());
+    return getLocFromToken(allTokens[tokenIndex]);
+}
+
+std::unique_ptr<Tree> Tree::get(SourceManagerPtr sourceManager,
+                                support::FileID file,
+                                support::Timer* lexTimer, bool pipelined,
+                                size_t diagnosticsLimit) {
+    support::MemoryScope memory(support::MemoryPhase::Parser);
+    parser::DiagnosticsEngine diagnostics(diagnosticsLimit);
     std::vector<parser::Token> tokens{};
     std::unique_ptr<Root> root = nullptr;
-    auto&& tree = std::make_unique<Tree>(std::move(filename), std::move(source),
+    auto&& tree = std::make_unique<Tree>(std::move(sourceManager), file,
                                          std::move(root), std::move(tokens),
-                                         std::move(errors));
+                                         std::move(diagnostics));
 
-    parser::Parser parser(*tree);
+    parser::Parser parser(*tree, lexTimer, pipelined);
 
     try {
         tree->setRoot(parser.parseRoot());
@@ -73,5 +324,214 @@ std::unique_ptr<Tree> Tree::get(const std::string filename,
     return std::move(tree);
 }
 
+std::unique_ptr<Tree> Tree::stream(SourceManagerPtr sourceManager,
+                                   support::FileID file,
+                                   const parser::DeclConsumer& consumer,
+                                   support::Timer* lexTimer, bool pipelined) {
+    support::MemoryScope memory(support::MemoryPhase::Parser);
+    parser::DiagnosticsEngine diagnostics{};
+    std::vector<parser::Token> tokens{};
+    std::unique_ptr<Root> root = nullptr;
+    auto&& tree = std::make_unique<Tree>(std::move(sourceManager), file,
+                                         std::move(root), std::move(tokens),
+                                         std::move(diagnostics));
+
+    {
+        parser::Parser parser(*tree, lexTimer, pipelined);
+        try {
+            tree->setRoot(parser.parseRootStreaming(consumer));
+        } catch (int) {
+            // parsing ended with an unrecoverable error,
+            // anything else was thrown by the consumer and is passed on
+        }
+    }
+
+    // the rest of the tokens is indexed from where streaming stopped
+    tree->getTokensMut().clear();
+    tree->getTokensMut().shrink_to_fit();
+
+    return std::move(tree);
+}
+
+std::unique_ptr<Tree> Tree::reparse(std::unique_ptr<Tree>&& previous,
+                                    SourceManagerPtr sourceManager,
+                                    support::FileID file,
+                                    const SourceEdit& newEdit) {
+    support::MemoryScope memory(support::MemoryPhase::Parser);
+    SourceEdit edit = newEdit;
+    if (previous->base != nullptr) {
+        // the edited part of 'previous' didn't parse, its base did
+        edit = mergeEdits(previous->baseEdit, newEdit);
+        std::unique_ptr<Tree> base = std::move(previous->base);
+        previous = std::move(base);
+    }
+
+    const support::StringRef source = sourceManager->getBuffer(file);
+    const size_t oldSize = previous->getSource().size();
+    const size_t editEnd = edit.offset + edit.removed;
+
+    // dropped diagnostics can't be told apart by where they are
+    if (previous->root == nullptr || previous->getTokensSize() == 0 ||
+        previous->diagnostics.getDroppedCount() != 0 ||
+        previous->root->getDeclsSize() == 0 || editEnd > oldSize ||
+        source.size() != oldSize - edit.removed + edit.inserted) {
+        previous = nullptr;
+        return get(std::move(sourceManager), file);
+    }
+
+    // the changed tokens [lo, hi): the ones ending at or after the start
+    // of the edit, up to the first one starting at or after its end
+    auto&& tokenAt = [&previous](size_t i) { return previous->getToken(i); };
+    const size_t tokensCount = previous->getTokensSize();
+    const size_t lo = partitionIndex(tokensCount, [&](size_t i) {
+        return tokenAt(i).end < edit.offset;
+    });
+    const size_t hi = partitionIndex(tokensCount, [&](size_t i) {
+        return tokenAt(i).start < editEnd;
+    });
+
+    Root& oldRoot = *previous->root;
+    const ReparseRange range = findReparseRange(oldRoot, lo, hi, tokenAt);
+    const size_t firstToken = range.firstToken;
+    const size_t endToken = range.endToken;
+    const std::ptrdiff_t byteDelta =
+        static_cast<std::ptrdiff_t>(edit.inserted) -
+        static_cast<std::ptrdiff_t>(edit.removed);
+
+    // lexing starts right after the token before the range, which the
+    // edit didn't touch, and ends at the token after it, which moved
+    parser::TokenWindow window{};
+    window.first = firstToken;
+    if (firstToken > 0) {
+        window.previous = tokenAt(firstToken - 1);
+    }
+    parser::Token sync = tokenAt(endToken);
+    sync.start += byteDelta;
+    sync.end += byteDelta;
+    std::vector<std::pair<size_t, parser::Token>> docComments{};
+    if (!relex(source, firstToken > 0 ? window.previous.end : 0, sync.start,
+               window, docComments)) {
+        previous = nullptr;
+        return get(std::move(sourceManager), file);
+    }
+    const size_t count = window.tokens.size();
+    if (!window.hasInvalid) {
+        window.tokens.push_back(sync);
+    }
+
+    // the diagnostics of the range go to the new tree first,
+    // the parser can't get past an invalid token
+    auto&& tree = std::make_unique<Tree>(
+        std::move(sourceManager), file, nullptr,
+        std::vector<parser::Token>{}, parser::DiagnosticsEngine(0));
+    tree->reparsed = true;
+    NodeList<Stmt> stmts{};
+    const size_t last = firstToken + count - (window.hasInvalid ? 0 : 1);
+    bool parsed = count == 0 && !window.hasInvalid;
+    bool failed = false;
+    if (!parsed) {
+        try {
+            parser::Parser parser(*tree);
+            parsed = range.block != nullptr
+                         ? parser.reparseStmts(window, last, stmts)
+                         : parser.reparseDecls(window, last, stmts);
+        } catch (int) {
+            // an unrecoverable error, unless the parser went on
+            // past the range
+            failed = !window.exceeded;
+        }
+    }
+
+    // the diagnostics of the replaced statements are the new ones,
+    // they are at the ends of their tokens, the ones of the statements
+    // before them at the start of the first token at the latest
+    const support::SourceManager& oldSourceManager =
+        previous->getSourceManager();
+    const size_t regionStart = tokenAt(firstToken).start;
+    const size_t regionEnd =
+        endToken > firstToken ? tokenAt(endToken - 1).end : regionStart;
+    parser::DiagnosticsEngine diagnostics{};
+    auto&& keepDiagnostics = [&](bool after) {
+        for (auto&& diag : previous->diagnostics.getDiagnostics()) {
+            const size_t pos = oldSourceManager.getFilePos(diag.loc);
+            if (after ? pos > regionEnd : pos <= regionStart) {
+                parser::Diagnostic kept = diag;
+                kept.loc = tree->getLocFromPos(after ? pos + byteDelta : pos);
+                diagnostics.report(kept);
+            }
+        }
+    };
+    keepDiagnostics(false);
+    for (auto&& diag : tree->diagnostics.getDiagnostics()) {
+        diagnostics.report(diag);
+    }
+    if (!failed) {
+        keepDiagnostics(true);
+    }
+
+    if ((!parsed && !failed) || diagnostics.getDroppedCount() != 0) {
+        previous = nullptr;
+        return get(tree->sourceManager, file);
+    }
+    tree->diagnostics = std::move(diagnostics);
+
+    if (failed) {
+        // a full parse stops at the error too, with the tokens up to it
+        const size_t fetched = std::min(window.fetched, count + 1);
+        tree->tokens.assign(window.tokens.begin(),
+                            window.tokens.begin() +
+                                std::min(fetched, window.tokens.size()));
+        for (auto&& entry : docComments) {
+            if (entry.first < fetched) {
+                tree->addDocComment(firstToken + entry.first, entry.second);
+            }
+        }
+        tree->baseTokens = firstToken;
+        tree->hasPendingTokens.store(firstToken != 0,
+                                     std::memory_order_release);
+        tree->base = std::move(previous);
+        tree->baseEdit = edit;
+        return std::move(tree);
+    }
+
+    // the tokens after the range are moved as a whole
+    if (previous->pieces == nullptr) {
+        previous->pieces = std::make_unique<TokenPieces>(
+            std::move(previous->tokens), std::move(previous->docComments));
+    }
+    window.tokens.pop_back();
+    previous->pieces->replace(firstToken, endToken, window.tokens,
+                              docComments, byteDelta);
+
+    // the nodes after it are shifted in the declaration holding the
+    // block, the declarations after that one lazily
+    const std::ptrdiff_t tokenDelta =
+        static_cast<std::ptrdiff_t>(count) -
+        static_cast<std::ptrdiff_t>(endToken - firstToken);
+    if (range.block != nullptr) {
+        if (tokenDelta != 0) {
+            oldRoot.getShiftedDecl(range.decl).shiftTokens(endToken,
+                                                           tokenDelta);
+        }
+        oldRoot.shiftDeclsLazily(range.decl + 1, endToken, tokenDelta);
+        // the tree owns its nodes, only lends them out as const
+        const_cast<Block*>(range.block)
+            ->replaceStmts(range.firstStmt, range.endStmt, std::move(stmts));
+    } else {
+        oldRoot.shiftDeclsLazily(range.endStmt, endToken, tokenDelta);
+        oldRoot.replaceDecls(range.firstStmt, range.endStmt,
+                             std::move(stmts));
+    }
+
+    tree->root = std::move(previous->root);
+    tree->pieces = std::move(previous->pieces);
+    tree->hasPendingTokens.store(true, std::memory_order_release);
+    previous = nullptr;
+    if (tree->pieces->isFragmented()) {
+        tree->flattenTokens();
+    }
+    return std::move(tree);
+}
+
 } // namespace ast
 } // namespace perun
@@ -1,37 +1,66 @@
 #ifndef PERUN_AST_TREE_HPP
 #define PERUN_AST_TREE_HPP
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "../ast/nodeindex.hpp"
 #include "../ast/stmt.hpp"
+#include "../ast/tokenpieces.hpp"
 
+#include "../parser/diagnostic.hpp"
 #include "../parser/parser.hpp"
 #include "../parser/token.hpp"
 
-#include "../support/error.hpp"
+#include "../support/source.hpp"
+#include "../support/timer.hpp"
 
 namespace perun {
 namespace ast {
 
 class Root;
 
+/// A change of a source: 'removed' bytes at 'offset' were replaced
+/// by 'inserted' new ones
+struct SourceEdit {
+    size_t offset;
+    size_t removed;
+    size_t inserted;
+};
+
+/// Merges 'next', an edit of a source already changed by 'edit',
+/// into a single edit of the original source covering both
+SourceEdit mergeEdits(const SourceEdit& edit, const SourceEdit& next);
+
 /// Manager of a single Abstract Syntax Tree
 class Tree {
 public:
-    using ErrorPtr = std::unique_ptr<support::Error>;
 
-    explicit Tree(std::string filename, std::string source,
+    using SourceManagerPtr = std::shared_ptr<const support::SourceManager>;
+
+    explicit Tree(SourceManagerPtr sourceManager, support::FileID file,
                   std::unique_ptr<Root>&& root,
                   std::vector<parser::Token>&& tokens,
-                  std::vector<ErrorPtr>&& errors)
-        : filename(std::move(filename)), source(std::move(source)),
+                  parser::DiagnosticsEngine&& diagnostics)
+        : sourceManager(std::move(sourceManager)), file(file),
           root(std::move(root)), tokens(std::move(tokens)),
-          errors(std::move(errors)) {}
+          diagnostics(std::move(diagnostics)) {}
 
-    const std::string& getFilename() const { return filename; }
-    const std::string& getSource() const { return source; }
+    const support::SourceManager& getSourceManager() const {
+        return *sourceManager;
+    }
+    support::FileID getFileID() const { return file; }
+
+    const std::string& getFilename() const {
+        return sourceManager->getFilename(file);
+    }
+    support::StringRef getSource() const {
+        return sourceManager->getBuffer(file);
+    }
 
     const Root* getRoot() const { return root.get(); }
     void setRoot(std::unique_ptr<Root>&& r) {
@@ -39,38 +68,150 @@ public:
         root = std::move(r);
     }
 
-    const std::vector<parser::Token>& getTokens() const { return tokens; }
-    std::vector<parser::Token>& getTokensMut() { return tokens; }
-
-    const std::vector<ErrorPtr>& getErrors() const { return errors; }
-    std::vector<ErrorPtr>& getErrorsMut() { return errors; }
-    bool hasErrors() const { return !errors.empty(); }
-    void addError(ErrorPtr&& error_ptr) {
-        errors.push_back(std::move(error_ptr));
+    const std::vector<parser::Token>& getTokens() const {
+        flattenTokens();
+        return tokens;
+    }
+    std::vector<parser::Token>& getTokensMut() {
+        flattenTokens();
+        return tokens;
     }
 
-    /// Returns a relative location from a position
-    Loc getLocFromPos(const size_t pos, const size_t start = 0) const;
+    const parser::DiagnosticsEngine& getDiagnostics() const {
+        return diagnostics;
+    }
+    parser::DiagnosticsEngine& getDiagnosticsMut() { return diagnostics; }
+    bool hasErrors() const { return diagnostics.hasErrors(); }
+
+    /// Doc comments in front of the token 'tokenIndex', null if none
+    const DocComment* getDocComment(size_t tokenIndex) const {
+        flattenTokens();
+        auto&& it = docComments.find(tokenIndex);
+        return it != docComments.end() ? &it->second : nullptr;
+    }
 
-    /// Returns a relative location from a token
-    Loc getLocFromToken(const parser::Token& token,
-                        const size_t start = 0) const;
+    /// Doc comments of a declaration, e.g. a FnDecl or a VarDecl
+    const DocComment* getDocComment(const Node& decl) const {
+        return getDocComment(decl.firstTokenIndex());
+    }
 
-    /// Returns a relative location from a token index
-    Loc getLocFromTokenIndex(const size_t tokenIndex,
-                             const size_t start = 0) const;
+    /// token index -> the doc comments in front of it
+    const std::unordered_map<size_t, DocComment>& getDocComments() const {
+        flattenTokens();
+        return docComments;
+    }
 
-    static std::unique_ptr<Tree> get(const std::string filename,
-                                     const std::string source);
+    /// Adds the doc comment 'comment' to the ones in front of 'tokenIndex'
+    /// The parser calls this for every doc comment it skips.
+    void addDocComment(size_t tokenIndex, const parser::Token& comment);
+
+    /// Returns the text of 'comment', without the slashes
+    /// and the first space after them
+    std::string getDocText(const DocComment& comment) const;
+
+    /// Returns the index of all nodes by their position, see ast::NodeIndex
+    /// It is built on the first call, expects a tree with its tokens.
+    const NodeIndex& getNodeIndex() const;
+
+    /// Returns a location from a position in the source
+    Loc getLocFromPos(const size_t pos) const;
+
+    /// Returns a location from a token
+    Loc getLocFromToken(const parser::Token& token) const;
+
+    /// Returns a location from a token index
+    Loc getLocFromTokenIndex(const size_t tokenIndex) const;
+
+    /// Parses the buffer 'file' owned by 'sourceManager'
+    /// Time spent lexing is added to 'lexTimer' if it is not null.
+    /// 'pipelined' lexes on a separate thread, see parser::Parser.
+    /// 'diagnosticsLimit' is the store limit of parser::DiagnosticsEngine.
+    static std::unique_ptr<Tree>
+    get(SourceManagerPtr sourceManager, support::FileID file,
+        support::Timer* lexTimer = nullptr, bool pipelined = false,
+        size_t diagnosticsLimit = parser::DiagnosticsEngine::defaultStoreLimit);
+
+    /// Parses the buffer 'file' and hands every top-level declaration
+    /// to 'consumer' as soon as it is parsed, see parser::DeclConsumer
+    /// Only the tokens of the declaration being parsed are kept,
+    /// so memory doesn't grow with the size of the file.
+    /// The returned tree holds the diagnostics, has no tokens and its
+    /// root has no declarations (or is null after an unrecoverable error).
+    /// Exceptions thrown by 'consumer' stop the parsing and are rethrown.
+    static std::unique_ptr<Tree> stream(SourceManagerPtr sourceManager,
+                                        support::FileID file,
+                                        const parser::DeclConsumer& consumer,
+                                        support::Timer* lexTimer = nullptr,
+                                        bool pipelined = false);
+
+    /// Parses the buffer 'file', which is the source of 'previous' changed
+    /// by 'edit', reusing the nodes of 'previous' outside of the edit
+    ///
+    /// Only the statements around the edit in the innermost block whose
+    /// braces it left alone (or the top-level declarations around it)
+    /// are lexed and parsed again, the rest of the nodes and tokens are
+    /// moved over. The tokens after the edit are moved by ast::TokenPieces
+    /// and the declarations after it are shifted lazily, see
+    /// Root::shiftDeclsLazily, so the cost is that of the edited function.
+    ///
+    /// Diagnostics of 'previous' outside of the edited statements are
+    /// kept. If the edited statements have an unrecoverable error, the
+    /// returned tree has no root like after a full parse and keeps
+    /// 'previous', which the next reparse starts from again.
+    /// Falls back to a full parse if 'previous' has no tokens or dropped
+    /// diagnostics, or if the edited part does not parse the same
+    /// on its own.
+    static std::unique_ptr<Tree> reparse(std::unique_ptr<Tree>&& previous,
+                                         SourceManagerPtr sourceManager,
+                                         support::FileID file,
+                                         const SourceEdit& edit);
+
+    /// True if the tree was made by 'reparse' without a full parse
+    bool isReparsed() const { return reparsed; }
 
 private:
-    const std::string filename;
-    const std::string source;
+    /// Puts the tokens and doc comments held by 'pieces' or 'base'
+    /// into 'tokens' and 'docComments'
+    void flattenTokens() const;
+
+    // for reparse, without flattening
+    size_t getTokensSize() const;
+    parser::Token getToken(size_t index) const;
+
+    /// Copies the tokens before 'end' and their doc comments
+    void copyTokens(size_t end, std::vector<parser::Token>& result,
+                    std::unordered_map<size_t, DocComment>& resultDocs) const;
+
+    const SourceManagerPtr sourceManager;
+    const support::FileID file;
     std::unique_ptr<Root> root;
 
-    std::vector<parser::Token> tokens;
+    mutable std::vector<parser::Token> tokens;
+
+    parser::DiagnosticsEngine diagnostics;
+
+    // filled while lexing, keyed by the index of the following token
+    mutable std::unordered_map<size_t, DocComment> docComments;
+
+    // after a reparse the tokens and doc comments are held by 'pieces'
+    // until they are accessed; a tree without a root made by reparse
+    // has only the tokens from 'baseTokens' on, the ones before are
+    // the first ones of 'base'
+    mutable std::unique_ptr<TokenPieces> pieces = nullptr;
+    mutable size_t baseTokens = 0;
+    mutable std::atomic<bool> hasPendingTokens{false};
+    mutable std::mutex tokensMutex;
+
+    // the tree the edited part of which failed to parse and the edit
+    // of its source which led to this tree, see reparse
+    std::unique_ptr<Tree> base = nullptr;
+    SourceEdit baseEdit{0, 0, 0};
+
+    // built lazily, the tree can be shared between threads
+    mutable std::mutex nodeIndexMutex;
+    mutable std::unique_ptr<NodeIndex> nodeIndex = nullptr;
 
-    std::vector<ErrorPtr> errors;
+    bool reparsed = false;
 };
 
 } // namespace ast
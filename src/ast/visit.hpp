@@ -0,0 +1,132 @@
+#ifndef PERUN_AST_VISIT_HPP
+#define PERUN_AST_VISIT_HPP
+
+#include "expr.hpp"
+#include "literal.hpp"
+#include "node.hpp"
+#include "stmt.hpp"
+
+namespace perun {
+namespace ast {
+
+/// Calls 'f(const Node&)' on every non-null direct child of 'node'
+/// in source order
+template <typename F> void forEachChild(const Node& node, F&& f) {
+    // TODO: use llvm RTTI
+    switch (node.getKind()) {
+    case Node::Kind::Root: {
+        for (auto&& decl : static_cast<const Root&>(node).getDecls()) {
+            f(static_cast<const Node&>(*decl));
+        }
+        break;
+    }
+    case Node::Kind::Block: {
+        for (auto&& stmt : static_cast<const Block&>(node).getStmts()) {
+            f(static_cast<const Node&>(*stmt));
+        }
+        break;
+    }
+    case Node::Kind::VarDecl: {
+        auto&& varDecl = static_cast<const VarDecl&>(node);
+        f(static_cast<const Node&>(*varDecl.getIdentifier()));
+        if (varDecl.getType() != nullptr) {
+            f(static_cast<const Node&>(*varDecl.getType()));
+        }
+        if (varDecl.getExpr() != nullptr) {
+            f(static_cast<const Node&>(*varDecl.getExpr()));
+        }
+        break;
+    }
+    case Node::Kind::ParamDecl: {
+        auto&& paramDecl = static_cast<const ParamDecl&>(node);
+        if (paramDecl.getIdentifier() != nullptr) {
+            f(static_cast<const Node&>(*paramDecl.getIdentifier()));
+        }
+        f(static_cast<const Node&>(*paramDecl.getType()));
+        break;
+    }
+    case Node::Kind::FnDecl: {
+        auto&& fnDecl = static_cast<const FnDecl&>(node);
+        if (fnDecl.getIdentifier() != nullptr) {
+            f(static_cast<const Node&>(*fnDecl.getIdentifier()));
+        }
+        for (auto&& param : fnDecl.getParams()) {
+            f(static_cast<const Node&>(*param));
+        }
+        if (fnDecl.getReturnType() != nullptr) {
+            f(static_cast<const Node&>(*fnDecl.getReturnType()));
+        }
+        if (fnDecl.getBody() != nullptr) {
+            f(static_cast<const Node&>(*fnDecl.getBody()));
+        }
+        break;
+    }
+    case Node::Kind::Return: {
+        auto&& ret = static_cast<const Return&>(node);
+        if (ret.getExpr() != nullptr) {
+            f(static_cast<const Node&>(*ret.getExpr()));
+        }
+        break;
+    }
+    case Node::Kind::IfStmt: {
+        auto&& ifStmt = static_cast<const IfStmt&>(node);
+        f(static_cast<const Node&>(*ifStmt.getCondition()));
+        f(static_cast<const Node&>(*ifStmt.getThenBlock()));
+        if (ifStmt.getElseBlock() != nullptr) {
+            f(static_cast<const Node&>(*ifStmt.getElseBlock()));
+        }
+        break;
+    }
+    case Node::Kind::AssignStmt: {
+        auto&& assign = static_cast<const AssignStmt&>(node);
+        if (assign.getLHS() != nullptr) {
+            f(static_cast<const Node&>(*assign.getLHS()));
+        }
+        f(static_cast<const Node&>(*assign.getRHS()));
+        break;
+    }
+    case Node::Kind::GroupedExpr: {
+        f(static_cast<const Node&>(
+            *static_cast<const GroupedExpr&>(node).getExpr()));
+        break;
+    }
+    case Node::Kind::PrefixExpr: {
+        f(static_cast<const Node&>(
+            *static_cast<const PrefixExpr&>(node).getRHS()));
+        break;
+    }
+    case Node::Kind::InfixExpr: {
+        auto&& expr = static_cast<const InfixExpr&>(node);
+        f(static_cast<const Node&>(*expr.getLHS()));
+        f(static_cast<const Node&>(*expr.getRHS()));
+        break;
+    }
+    case Node::Kind::SuffixExpr: {
+        f(static_cast<const Node&>(
+            *static_cast<const SuffixExpr&>(node).getLHS()));
+        break;
+    }
+    case Node::Kind::CallExpr: {
+        auto&& expr = static_cast<const CallExpr&>(node);
+        f(static_cast<const Node&>(*expr.getFn()));
+        for (auto&& arg : expr.getArgs()) {
+            f(static_cast<const Node&>(*arg));
+        }
+        break;
+    }
+    case Node::Kind::Identifier:
+    case Node::Kind::LiteralInteger:
+    case Node::Kind::LiteralString:
+    case Node::Kind::LiteralBoolean:
+    case Node::Kind::LiteralNil:
+    case Node::Kind::LiteralUndefined: {
+        // leaves
+        break;
+    }
+    }
+}
+
+} // namespace ast
+} // namespace perun
+
+#endif // PERUN_AST_VISIT_HPP
@@ -0,0 +1,263 @@
+#include "generator.hpp"
+
+#include <vector>
+
+namespace perun {
+namespace bench {
+
+namespace {
+
+/// SplitMix64, chosen for being tiny and identical on all platforms
+/// (unlike the distributions of <random>)
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// Uniform in [0, bound)
+    size_t below(size_t bound) { return next() % bound; }
+
+    bool chance(double probability) {
+        return static_cast<double>(next() >> 11) * 0x1.0p-53 < probability;
+    }
+
+    template <size_t N> const char* pick(const char* const (&items)[N]) {
+        return items[below(N)];
+    }
+
+private:
+    uint64_t state;
+};
+
+const char* const types[] = {"i32", "u8", "u64", "bool", "?u8", "?i32"};
+const char* const words[] = {"count", "value", "index", "size", "left",
+                             "right", "node",  "item",  "total", "x"};
+const char* const infixOps[] = {"+",  "-",  "*",  "/", "%",  "<<", ">>",
+                                "&",  "|",  "==", "!=", "<", "<=", ">",
+                                ">="};
+const char* const prefixOps[] = {"-", "!", "~", "&", "?"};
+const char* const suffixOps[] = {"^", "?"};
+const char* const assignOps[] = {"=",  "+=", "-=",  "*=",  "/=",
+                                 "%=", "&=", "|=", "<<=", ">>="};
+const char* const commentWords[] = {"the", "returns", "checks", "keeps",
+                                    "a",   "value",   "of",     "node",
+                                    "when", "size",   "is",     "zero"};
+
+class Generator {
+public:
+    explicit Generator(const GeneratorOptions& options)
+        : options(options), random(options.seed) {}
+
+    std::string run() {
+        while (out.size() < options.targetBytes) {
+            topLevelDecl();
+        }
+        return std::move(out);
+    }
+
+private:
+    // names with a digit can't collide with a keyword
+    void identifier() {
+        out += random.pick(words);
+        out += std::to_string(random.below(64));
+    }
+
+    void indentLine() { out.append(indent * 4, ' '); }
+
+    void maybeComment(bool doc) {
+        if (!random.chance(options.commentDensity)) {
+            return;
+        }
+        indentLine();
+        out += doc && random.chance(0.5) ? "///" : "//";
+        for (size_t i = 0, n = 2 + random.below(8); i < n; ++i) {
+            out += ' ';
+            out += random.pick(commentWords);
+        }
+        out += '\n';
+    }
+
+    void literal() {
+        switch (random.below(6)) {
+        case 0: {
+            out += "0x";
+            const char hex[] = "0123456789ABCDEF";
+            for (size_t i = 0, n = 1 + random.below(4); i < n; ++i) {
+                out += hex[random.below(16)];
+            }
+            break;
+        }
+        case 1: {
+            out += random.chance(0.5) ? "true" : "false";
+            break;
+        }
+        case 2: {
+            out += random.chance(0.5) ? "nil" : "undefined";
+            break;
+        }
+        default: {
+            out += std::to_string(random.below(100000));
+            break;
+        }
+        }
+    }
+
+    void operand(size_t depth) {
+        size_t choice = random.below(10);
+        if (choice == 0 && depth < options.maxDepth) {
+            out += '(';
+            expr(depth + 1);
+            out += ')';
+        } else if (choice == 1) {
+            out += random.pick(prefixOps);
+            operand(depth);
+        } else if (choice == 2 && depth < options.maxDepth) {
+            call(depth + 1);
+        } else if (random.chance(options.identifierRatio)) {
+            identifier();
+            if (random.chance(0.1)) {
+                out += random.pick(suffixOps);
+            }
+        } else {
+            literal();
+        }
+    }
+
+    void call(size_t depth) {
+        identifier();
+        out += '(';
+        for (size_t i = 0, n = random.below(4); i < n; ++i) {
+            out += i == 0 ? "" : ", ";
+            expr(depth);
+        }
+        out += ')';
+    }
+
+    void expr(size_t depth) {
+        operand(depth);
+        for (size_t i = 0, n = random.below(4); i < n; ++i) {
+            out += ' ';
+            out += random.pick(infixOps);
+            out += ' ';
+            operand(depth);
+        }
+    }
+
+    void varDecl() {
+        out += random.chance(0.3) ? "const " : "var ";
+        identifier();
+        if (random.chance(0.5)) {
+            out += ": ";
+            out += random.pick(types);
+        }
+        out += " = ";
+        expr(0);
+        out += ";\n";
+    }
+
+    void stmt(size_t depth) {
+        maybeComment(false);
+        indentLine();
+
+        size_t choice = random.below(10);
+        if (choice < 2 && depth < options.maxDepth) {
+            out += "if ";
+            expr(0);
+            out += ' ';
+            block(depth + 1);
+            if (random.chance(0.4)) {
+                out += " else ";
+                block(depth + 1);
+            }
+            out += '\n';
+        } else if (choice < 5) {
+            varDecl();
+        } else if (choice < 6) {
+            out += "_ = ";
+            call(0);
+            out += ";\n";
+        } else {
+            identifier();
+            out += ' ';
+            out += random.pick(assignOps);
+            out += ' ';
+            expr(0);
+            out += ";\n";
+        }
+    }
+
+    void block(size_t depth) {
+        out += "{\n";
+        ++indent;
+        for (size_t i = 0, n = 1 + random.below(6); i < n; ++i) {
+            stmt(depth);
+        }
+        if (random.chance(0.3)) {
+            indentLine();
+            out += "return ";
+            expr(0);
+            out += ";\n";
+        }
+        --indent;
+        indentLine();
+        out += '}';
+    }
+
+    void fnDecl() {
+        bool external = random.chance(0.1);
+        if (random.chance(0.3)) {
+            out += "pub ";
+        }
+        out += external ? "extern fn " : "fn ";
+        identifier();
+        out += '(';
+        for (size_t i = 0, n = random.below(4); i < n; ++i) {
+            out += i == 0 ? "" : ", ";
+            identifier();
+            out += ": ";
+            out += random.pick(types);
+        }
+        out += ')';
+        if (random.chance(0.7)) {
+            out += " -> ";
+            out += random.pick(types);
+        }
+
+        if (external) {
+            out += ";\n\n";
+            return;
+        }
+        out += ' ';
+        block(0);
+        out += "\n\n";
+    }
+
+    void topLevelDecl() {
+        maybeComment(true);
+        if (random.chance(0.25)) {
+            varDecl();
+        } else {
+            fnDecl();
+        }
+    }
+
+    const GeneratorOptions& options;
+    Random random;
+    std::string out{};
+    size_t indent = 0;
+};
+
+} // namespace
+
+std::string generateProgram(const GeneratorOptions& options) {
+    return Generator(options).run();
+}
+
+} // namespace bench
+} // namespace perun
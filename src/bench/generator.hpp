@@ -0,0 +1,36 @@
+#ifndef PERUN_BENCH_GENERATOR_HPP
+#define PERUN_BENCH_GENERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace perun {
+namespace bench {
+
+/// Shape of a generated corpus
+struct GeneratorOptions {
+    uint64_t seed = 1;
+
+    // the program is cut at the first top-level declaration past this size
+    size_t targetBytes = 4 * 1024 * 1024;
+
+    // maximal nesting of blocks (if statements) and of grouped expressions
+    size_t maxDepth = 4;
+
+    // share of identifiers among the operands, the rest are literals
+    double identifierRatio = 0.5;
+
+    // probability of a comment before a statement or a declaration
+    double commentDensity = 0.1;
+};
+
+/// Generates a valid Perun program
+/// The output depends only on the options -- the generator has its own
+/// random number generator, so a seed gives the same corpus everywhere.
+std::string generateProgram(const GeneratorOptions& options);
+
+} // namespace bench
+} // namespace perun
+
+#endif // PERUN_BENCH_GENERATOR_HPP
@@ -0,0 +1,718 @@
+#include "generator.hpp"
+#include "scaling.hpp"
+
+#include "../ast/merkle.hpp"
+#include "../ast/printer.hpp"
+#include "../ast/tree.hpp"
+#include "../ast/visit.hpp"
+
+#include "../cst/syntax.hpp"
+
+#include "../parser/eventparser.hpp"
+#include "../parser/tokenizer.hpp"
+
+#include "../support/json.hpp"
+#include "../support/memory.hpp"
+#include "../support/output.hpp"
+#include "../support/timer.hpp"
+#include "../support/util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace perun;
+
+// Every allocation of the process is counted, the phases read the counters
+// before and after. Relaxed atomics are enough, the benchmark is serial.
+// A build with PERUN_MEMORY_TRACKING already replaces operator new,
+// its totals are used instead.
+namespace {
+
+#ifdef PERUN_MEMORY_TRACKING
+
+uint64_t getAllocationCount() {
+    return support::MemoryTracker::getTotal().count;
+}
+uint64_t getAllocatedBytes() {
+    return support::MemoryTracker::getTotal().bytes;
+}
+
+#else
+
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> allocatedBytes{0};
+
+uint64_t getAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+uint64_t getAllocatedBytes() {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+#endif
+
+} // namespace
+
+#ifndef PERUN_MEMORY_TRACKING
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+
+void operator delete(void* pointer, size_t) noexcept { std::free(pointer); }
+
+#endif
+
+static void printUsage() {
+    std::cout << "Usage: perun-bench [-h/--help] [--seed=<n>]\n"
+                 "                   [--size=<bytes>] [--depth=<n>]\n"
+                 "                   [--identifiers=<0..1>]\n"
+                 "                   [--comments=<0..1>] [--iterations=<n>]\n"
+                 "                   [--emit=<file>] [--json]\n"
+                 "                   [--write-baseline=<file>]\n"
+                 "                   [--baseline=<file>] [--tolerance=<0..1>]\n"
+                 "       perun-bench --scaling [--max-exponent=<e>]\n"
+                 "                   [--steps=<n>] [--scale=<factor>]\n"
+                 "                   [--shape=<name>] [--iterations=<n>]"
+              << std::endl;
+}
+
+namespace {
+
+/// Measurements of one phase, the fastest iteration is kept
+struct Phase {
+    const char* name = nullptr;
+    double seconds = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+};
+
+/// The allocations are the same in every iteration, only the time differs
+void keepFastest(Phase& best, const Phase& current) {
+    if (best.name == nullptr || current.seconds < best.seconds) {
+        best = current;
+    }
+}
+
+/// Runs 'f' 'iterations' times, keeps the fastest one
+template <typename F>
+Phase measure(const char* name, size_t iterations, F&& f) {
+    Phase phase{};
+    for (size_t i = 0; i < iterations; ++i) {
+        uint64_t count = getAllocationCount();
+        uint64_t bytes = getAllocatedBytes();
+
+        support::Timer timer;
+        timer.start();
+        f();
+        timer.stop();
+
+        Phase current{};
+        current.name = name;
+        current.seconds = timer.getSeconds();
+        current.allocations = getAllocationCount() - count;
+        current.allocatedBytes = getAllocatedBytes() - bytes;
+        keepFastest(phase, current);
+    }
+    return phase;
+}
+
+// node lookups per iteration of the "lookups" phase,
+// and how many of them are also done by walking the tree
+constexpr size_t lookupCount = 4096;
+constexpr size_t lookupRounds = 64;
+constexpr size_t walkCount = 16;
+
+/// Sink of parser::parseEvents which only counts the events
+struct CountingSink {
+    size_t enters = 0;
+    size_t tokens = 0;
+    size_t depth = 0;
+    bool balanced = true;
+
+    void enter(ast::Node::Kind) {
+        ++enters;
+        ++depth;
+    }
+    void leave(ast::Node::Kind) {
+        balanced = balanced && depth > 0;
+        --depth;
+    }
+    void token(const parser::Token&) { ++tokens; }
+};
+
+size_t countNodes(const ast::Node& node) {
+    size_t count = 1;
+    ast::forEachChild(node, [&](const ast::Node& child) {
+        count += countNodes(child);
+    });
+    return count;
+}
+
+/// Appends the kinds and token spans of 'node' and its children
+void collectSpans(const ast::Node& node, std::vector<size_t>& spans) {
+    spans.push_back(static_cast<size_t>(node.getKind()));
+    spans.push_back(node.firstTokenIndex());
+    spans.push_back(node.lastTokenIndex());
+    ast::forEachChild(node, [&](const ast::Node& child) {
+        collectSpans(child, spans);
+    });
+}
+
+/// True if both trees have the same tokens and nodes over the same tokens
+bool isSameTree(const ast::Tree& tree, const ast::Tree& other) {
+    auto&& tokens = tree.getTokens();
+    auto&& otherTokens = other.getTokens();
+    if (tokens.size() != otherTokens.size() ||
+        tree.getDocComments().size() != other.getDocComments().size()) {
+        return false;
+    }
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        if (tokens[i].getKind() != otherTokens[i].getKind() ||
+            tokens[i].start != otherTokens[i].start ||
+            tokens[i].end != otherTokens[i].end) {
+            return false;
+        }
+    }
+
+    std::vector<size_t> spans{};
+    std::vector<size_t> otherSpans{};
+    collectSpans(*tree.getRoot(), spans);
+    collectSpans(*other.getRoot(), otherSpans);
+    return spans == otherSpans &&
+           ast::MerkleHashes(tree).getRootHash() ==
+               ast::MerkleHashes(other).getRootHash();
+}
+
+/// Byte span of 'node', widened to its children like in ast::NodeIndex
+/// Sets 'found' to the innermost node containing 'pos' if there is one.
+std::pair<size_t, size_t> findByWalk(const ast::Tree& tree,
+                                     const ast::Node& node, size_t pos,
+                                     const ast::Node*& found) {
+    auto&& tokens = tree.getTokens();
+    std::pair<size_t, size_t> span{SIZE_MAX, 0};
+    if (node.isNot(ast::Node::Kind::Root)) {
+        span.first = tokens[node.firstTokenIndex()].start;
+        span.second = tokens[node.lastTokenIndex()].end;
+    }
+
+    ast::forEachChild(node, [&](const ast::Node& child) {
+        auto&& childSpan = findByWalk(tree, child, pos, found);
+        span.first = std::min(span.first, childSpan.first);
+        span.second = std::max(span.second, childSpan.second);
+    });
+
+    // the children are done first, so the innermost one wins
+    if (found == nullptr && span.first <= pos && pos < span.second) {
+        found = &node;
+    }
+    return span;
+}
+
+double perSecond(double amount, double seconds) {
+    return seconds > 0 ? amount / seconds : 0;
+}
+
+/// Parses 'value' as a number, returns false if invalid
+bool parseNumber(const std::string& value, double& result) {
+    char* end = nullptr;
+    result = std::strtod(value.c_str(), &end);
+    return !value.empty() && *end == '\0';
+}
+
+struct Results {
+    bench::GeneratorOptions options;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t nodes = 0;
+    // tokens of the largest declaration held while streaming
+    size_t streamWindow = 0;
+    // node at an offset through ast::NodeIndex and by walking the tree
+    double lookupNs = 0;
+    double walkNs = 0;
+    std::vector<Phase> phases{};
+
+    double getNsPerByte(const Phase& phase) const {
+        return bytes == 0 ? 0 : phase.seconds * 1e9 / bytes;
+    }
+
+    void writeJSON(support::OutputBuffer& out) const;
+    void printTable(std::ostream& os) const;
+};
+
+void Results::writeJSON(support::OutputBuffer& out) const {
+    out << "{\"version\":1,\"options\":{\"seed\":" << options.seed
+        << ",\"size\":" << static_cast<uint64_t>(options.targetBytes)
+        << ",\"depth\":" << static_cast<uint64_t>(options.maxDepth)
+        << ",\"identifiers\":" << std::to_string(options.identifierRatio)
+        << ",\"comments\":" << std::to_string(options.commentDensity)
+        << "},\"bytes\":" << static_cast<uint64_t>(bytes)
+        << ",\"tokens\":" << static_cast<uint64_t>(tokens)
+        << ",\"nodes\":" << static_cast<uint64_t>(nodes)
+        << ",\"streamWindow\":" << static_cast<uint64_t>(streamWindow)
+        << ",\"lookupNs\":" << std::to_string(lookupNs)
+        << ",\"walkNs\":" << std::to_string(walkNs)
+        << ",\"phases\":{";
+    for (size_t i = 0; i < phases.size(); ++i) {
+        auto&& phase = phases[i];
+        out << (i == 0 ? "" : ",") << '"' << phase.name
+            << "\":{\"nsPerByte\":" << std::to_string(getNsPerByte(phase))
+            << ",\"tokensPerSecond\":"
+            << static_cast<uint64_t>(perSecond(tokens, phase.seconds))
+            << ",\"nodesPerSecond\":"
+            << static_cast<uint64_t>(perSecond(nodes, phase.seconds))
+            << ",\"allocations\":" << phase.allocations
+            << ",\"allocatedBytes\":" << phase.allocatedBytes << '}';
+    }
+    out << "}}\n";
+}
+
+void Results::printTable(std::ostream& os) const {
+    os << "perun-bench: " << bytes << " bytes (seed " << options.seed
+       << ", depth " << options.maxDepth << "), " << tokens << " tokens, "
+       << nodes << " nodes, streaming window " << streamWindow
+       << " tokens\n";
+    os << "  phase        ns/byte      tokens/s       nodes/s      allocs"
+          "    alloc MB\n";
+    os << std::fixed;
+    for (auto&& phase : phases) {
+        os << "  " << std::left << std::setw(10) << phase.name << std::right
+           << std::setprecision(2) << std::setw(10) << getNsPerByte(phase)
+           << std::setprecision(0) << std::setw(14)
+           << perSecond(tokens, phase.seconds) << std::setw(14)
+           << perSecond(nodes, phase.seconds) << std::setw(12)
+           << phase.allocations << std::setprecision(2) << std::setw(12)
+           << phase.allocatedBytes / (1024.0 * 1024.0) << "\n";
+    }
+    os << "  node at offset: " << std::setprecision(1) << lookupNs
+       << " ns with the index, " << std::setprecision(0) << walkNs
+       << " ns walking the tree\n";
+    os << std::defaultfloat;
+}
+
+/// Compares the results with a baseline written by '--write-baseline'
+/// Returns false if a phase got slower or allocates more than 'tolerance'
+/// allows, or if the baseline can't be used.
+bool compareBaseline(const Results& results, const std::string& path,
+                     double tolerance, std::ostream& os) {
+    support::JSONValue baseline{};
+    std::string text = support::readFile(path);
+    if (text.empty() || !support::JSONValue::parse(text, baseline)) {
+        os << "perun-bench: error: could not read baseline: '" << path
+           << "'\n";
+        return false;
+    }
+
+    // times of a different corpus are not comparable
+    if (static_cast<size_t>(baseline.get("bytes").getInteger()) !=
+        results.bytes) {
+        os << "perun-bench: error: the baseline was measured on another "
+              "corpus, regenerate it with the same options\n";
+        return false;
+    }
+
+    bool passed = true;
+    auto&& limit = [tolerance](double base) { return base * (1 + tolerance); };
+    os << "perun-bench: baseline '" << path << "' (tolerance "
+       << tolerance * 100 << "%):\n";
+    for (auto&& phase : results.phases) {
+        auto&& base = baseline.get("phases").get(phase.name);
+        if (base.is(support::JSONValue::Kind::Null)) {
+            continue;
+        }
+
+        double nsPerByte = results.getNsPerByte(phase);
+        double baseNsPerByte = base.get("nsPerByte").getNumber();
+        double baseAllocations = base.get("allocations").getNumber();
+        bool slower = nsPerByte > limit(baseNsPerByte);
+        bool allocates = phase.allocations > limit(baseAllocations);
+
+        os << "  " << std::left << std::setw(10) << phase.name << std::right
+           << std::fixed << std::setprecision(2) << std::setw(10)
+           << nsPerByte << " ns/byte (baseline " << baseNsPerByte << ", "
+           << std::showpos
+           << (baseNsPerByte > 0 ? (nsPerByte / baseNsPerByte - 1) * 100 : 0)
+           << "%)" << std::noshowpos << std::defaultfloat;
+        if (slower) {
+            os << " REGRESSION";
+        }
+        if (allocates) {
+            os << " MORE ALLOCATIONS (" << phase.allocations << " vs "
+               << static_cast<uint64_t>(baseAllocations) << ")";
+        }
+        os << "\n";
+
+        passed = passed && !slower && !allocates;
+    }
+    return passed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    bench::GeneratorOptions options{};
+    size_t iterations = 5;
+    double tolerance = 0.10;
+    bool json = false;
+    bool scaling = false;
+    bench::ScalingOptions scalingOptions{};
+    std::string emitPath{};
+    std::string baselinePath{};
+    std::string writeBaselinePath{};
+
+    for (auto&& arg : args) {
+        auto&& eq = arg.find('=');
+        const std::string name = arg.substr(0, eq);
+        const std::string value =
+            eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+        double number = 0;
+        bool isNumber = parseNumber(value, number) && number >= 0;
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg == "--json") {
+            json = true;
+        } else if (arg == "--scaling") {
+            scaling = true;
+        } else if (name == "--max-exponent" && isNumber) {
+            scalingOptions.maxExponent = number;
+        } else if (name == "--steps" && isNumber && number >= 2 &&
+                   number <= 16) {
+            scalingOptions.steps = static_cast<size_t>(number);
+        } else if (name == "--scale" && isNumber && number > 0) {
+            scalingOptions.scale = number;
+        } else if (name == "--shape" && !value.empty()) {
+            scalingOptions.filter = value;
+        } else if (name == "--emit" && !value.empty()) {
+            emitPath = value;
+        } else if (name == "--baseline" && !value.empty()) {
+            baselinePath = value;
+        } else if (name == "--write-baseline" && !value.empty()) {
+            writeBaselinePath = value;
+        } else if (name == "--seed" && isNumber) {
+            options.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (name == "--size" && isNumber && number >= 1) {
+            options.targetBytes = static_cast<size_t>(number);
+        } else if (name == "--depth" && isNumber) {
+            options.maxDepth = static_cast<size_t>(number);
+        } else if (name == "--identifiers" && isNumber && number <= 1) {
+            options.identifierRatio = number;
+        } else if (name == "--comments" && isNumber && number <= 1) {
+            options.commentDensity = number;
+        } else if (name == "--iterations" && isNumber && number >= 1) {
+            iterations = static_cast<size_t>(number);
+        } else if (name == "--tolerance" && isNumber) {
+            tolerance = number;
+        } else {
+            std::cerr << "perun-bench: error: invalid option '" << arg
+                      << "'\n";
+            return 1;
+        }
+    }
+
+    if (scaling) {
+        scalingOptions.iterations = iterations;
+        return bench::runScaling(scalingOptions, std::cout) ? 0 : 1;
+    }
+
+    const std::string source = bench::generateProgram(options);
+    if (!emitPath.empty()) {
+        int fd = ::open(emitPath.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cerr << "perun-bench: error: could not write '" << emitPath
+                      << "'\n";
+            return 1;
+        }
+        support::OutputBuffer out(fd);
+        out << source;
+        out.flush();
+        ::close(fd);
+        return 0;
+    }
+
+    Results results{};
+    results.options = options;
+    results.bytes = source.size();
+
+    // a single tree is kept between the phases which need one
+    auto&& sourceManager = std::make_shared<support::SourceManager>();
+    support::FileID file = sourceManager->addBuffer("<bench>", source);
+    std::unique_ptr<ast::Tree> tree = nullptr;
+
+    results.phases.push_back(measure("tokenize", iterations, [&]() {
+        parser::Tokenizer tokenizer(sourceManager->getBuffer(file));
+        size_t tokens = 0;
+        while (tokenizer.nextToken().getKind() !=
+               parser::Token::Kind::EndOfFile) {
+            ++tokens;
+        }
+        results.tokens = tokens + 1;
+    }));
+
+    // parsing and teardown alternate, the last tree is parsed again untimed
+    Phase parse{};
+    Phase teardown{};
+    for (size_t i = 0; i < iterations; ++i) {
+        keepFastest(parse, measure("parse", 1, [&]() {
+                        tree = ast::Tree::get(sourceManager, file);
+                    }));
+        keepFastest(teardown,
+                    measure("teardown", 1, [&]() { tree = nullptr; }));
+    }
+    results.phases.push_back(parse);
+
+    // the same with the tokenizer running ahead on another thread
+    Phase pipelined{};
+    size_t pipelinedTokens = 0;
+    for (size_t i = 0; i < iterations; ++i) {
+        keepFastest(pipelined, measure("pipelined", 1, [&]() {
+                        tree = ast::Tree::get(sourceManager, file, nullptr,
+                                              true);
+                    }));
+        pipelinedTokens = tree->getTokens().size();
+        tree = nullptr;
+    }
+    results.phases.push_back(pipelined);
+
+    // declarations are dropped as soon as they are parsed
+    size_t streamedDecls = 0;
+    results.phases.push_back(measure("stream", iterations, [&]() {
+        streamedDecls = 0;
+        ast::Tree::stream(sourceManager, file,
+                          [&](std::unique_ptr<ast::Stmt>&&,
+                              const parser::DeclTokens& tokens) {
+                              results.streamWindow = std::max(
+                                  results.streamWindow, tokens.size());
+                              ++streamedDecls;
+                          });
+    }));
+
+    // the same grammar reporting events instead of building nodes
+    CountingSink sink{};
+    results.phases.push_back(measure("events", iterations, [&]() {
+        sink = CountingSink{};
+        parser::parseEvents(sourceManager, file, sink);
+    }));
+
+    // the lossless syntax tree, with a fresh cache and with the cache
+    // of the previous version of the file (here: the same one)
+    std::unique_ptr<cst::SyntaxTree> syntaxTree = nullptr;
+    results.phases.push_back(measure("cst", iterations, [&]() {
+        cst::GreenCache cache{};
+        syntaxTree = cst::SyntaxTree::parse(sourceManager, file, cache);
+    }));
+
+    cst::GreenCache greenCache{};
+    syntaxTree = cst::SyntaxTree::parse(sourceManager, file, greenCache);
+    results.phases.push_back(measure("reparse", iterations, [&]() {
+        cst::SyntaxTree::parse(sourceManager, file, greenCache);
+    }));
+
+    if (syntaxTree->getText() != source) {
+        std::cerr << "perun-bench: error: the syntax tree does not "
+                     "reproduce the source\n";
+        return 1;
+    }
+    syntaxTree = nullptr;
+
+    tree = ast::Tree::get(sourceManager, file);
+    if (tree->getRoot() != nullptr &&
+        tree->getRoot()->getDecls().size() != streamedDecls) {
+        std::cerr << "perun-bench: error: streamed " << streamedDecls
+                  << " declarations instead of "
+                  << tree->getRoot()->getDecls().size() << "\n";
+        return 1;
+    }
+    if (tree->getTokens().size() != pipelinedTokens) {
+        std::cerr << "perun-bench: error: the pipelined parse read "
+                  << pipelinedTokens << " tokens instead of "
+                  << tree->getTokens().size() << "\n";
+        return 1;
+    }
+
+    if (tree->hasErrors() || tree->getRoot() == nullptr) {
+        std::cerr << "perun-bench: error: the generated program has errors\n";
+        tree->getDiagnostics().print(std::cerr, *sourceManager);
+        return 1;
+    }
+    results.nodes = countNodes(*tree->getRoot());
+    if (sink.enters != results.nodes ||
+        sink.tokens != tree->getTokens().size() || !sink.balanced ||
+        sink.depth != 0) {
+        std::cerr << "perun-bench: error: the event parse entered "
+                  << sink.enters << " nodes and read " << sink.tokens
+                  << " tokens instead of " << results.nodes << " and "
+                  << tree->getTokens().size() << "\n";
+        return 1;
+    }
+
+    // building the index, then looking up nodes with and without it
+    results.phases.push_back(measure("index", iterations, [&]() {
+        ast::NodeIndex index(*tree);
+    }));
+
+    auto&& index = tree->getNodeIndex();
+    std::vector<size_t> positions{};
+    for (size_t i = 0; i < lookupCount; ++i) {
+        positions.push_back(source.size() * i / lookupCount);
+    }
+
+    size_t checksum = 0;
+    Phase lookups = measure("lookups", iterations, [&]() {
+        for (size_t round = 0; round < lookupRounds; ++round) {
+            for (size_t pos : positions) {
+                checksum += index.findAt(pos);
+            }
+        }
+    });
+    results.lookupNs =
+        lookups.seconds * 1e9 / (lookupCount * lookupRounds);
+
+    // a walk visits every node, a few positions are enough
+    size_t mismatch = SIZE_MAX;
+    Phase walks = measure("walks", iterations, [&]() {
+        for (size_t i = 0; i < walkCount; ++i) {
+            const size_t pos = positions[i * lookupCount / walkCount];
+            const ast::Node* found = nullptr;
+            findByWalk(*tree, *tree->getRoot(), pos, found);
+            if (found != &index.getNode(index.findAt(pos))) {
+                mismatch = pos;
+            }
+        }
+    });
+    results.walkNs = walks.seconds * 1e9 / walkCount;
+    if (mismatch != SIZE_MAX) {
+        std::cerr << "perun-bench: error: the node index disagrees with "
+                     "the tree at "
+                  << mismatch << "\n";
+        return 1;
+    }
+    if (checksum == 0) {
+        std::cerr << "perun-bench: error: every lookup found the root\n";
+        return 1;
+    }
+
+    // structural hashes of every declaration
+    results.phases.push_back(measure("merkle", iterations, [&]() {
+        ast::MerkleHashes hashes(*tree);
+    }));
+
+    // a statement typed into the function in the middle of the file,
+    // only the statements around it are parsed again
+    auto&& decls = tree->getRoot()->getDecls();
+    size_t editOffset = SIZE_MAX;
+    for (size_t i = decls.size() / 2; i < decls.size(); ++i) {
+        if (decls[i]->is(ast::Node::Kind::FnDecl) &&
+            static_cast<const ast::FnDecl&>(*decls[i]).hasBody()) {
+            auto&& body = static_cast<const ast::FnDecl&>(*decls[i]).getBody();
+            editOffset = tree->getTokens()[body->firstTokenIndex()].end;
+            break;
+        }
+    }
+    if (editOffset != SIZE_MAX) {
+        const std::string statement = "\n    var edited = 1;";
+        std::string editedSource = source;
+        editedSource.insert(editOffset, statement);
+        support::FileID editedFile =
+            sourceManager->addBuffer("<bench-edit>", std::move(editedSource));
+        const ast::SourceEdit edit{editOffset, 0, statement.size()};
+
+        Phase reparse{};
+        std::unique_ptr<ast::Tree> edited = nullptr;
+        for (size_t i = 0; i < iterations; ++i) {
+            edited = ast::Tree::get(sourceManager, file);
+            keepFastest(reparse, measure("edit", 1, [&]() {
+                            edited = ast::Tree::reparse(std::move(edited),
+                                                        sourceManager,
+                                                        editedFile, edit);
+                        }));
+        }
+        results.phases.push_back(reparse);
+
+        if (!edited->isReparsed() ||
+            !isSameTree(*edited,
+                        *ast::Tree::get(sourceManager, editedFile))) {
+            std::cerr << "perun-bench: error: reparsing the edit did not "
+                         "give the tree of a full parse\n";
+            return 1;
+        }
+
+        // the same statement typed without its ';' first, the second
+        // edit reparses a tree with an error in it
+        const size_t typed = statement.size() - 1;
+        std::string brokenSource = source;
+        brokenSource.insert(editOffset, statement, 0, typed);
+        support::FileID brokenFile =
+            sourceManager->addBuffer("<bench-broken>", std::move(brokenSource));
+        edited = ast::Tree::reparse(ast::Tree::get(sourceManager, file),
+                                    sourceManager, brokenFile,
+                                    ast::SourceEdit{editOffset, 0, typed});
+        const bool broken = edited->isReparsed() && edited->hasErrors();
+        edited = ast::Tree::reparse(std::move(edited), sourceManager,
+                                    editedFile,
+                                    ast::SourceEdit{editOffset + typed, 0, 1});
+        if (!broken || !edited->isReparsed() || edited->hasErrors() ||
+            !isSameTree(*edited,
+                        *ast::Tree::get(sourceManager, editedFile))) {
+            std::cerr << "perun-bench: error: reparsing a tree with an "
+                         "error did not give the tree of a full parse\n";
+            return 1;
+        }
+    }
+
+    results.phases.push_back(measure("print", iterations, [&]() {
+        support::OutputBuffer out{};
+        ast::Printer printer(out, 0);
+        printer.printRoot(*tree->getRoot());
+    }));
+
+    results.phases.push_back(teardown);
+
+    if (json) {
+        support::OutputBuffer out(STDOUT_FILENO);
+        results.writeJSON(out);
+    } else {
+        results.printTable(std::cout);
+    }
+
+    if (!writeBaselinePath.empty()) {
+        int fd = ::open(writeBaselinePath.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cerr << "perun-bench: error: could not write '"
+                      << writeBaselinePath << "'\n";
+            return 1;
+        }
+        support::OutputBuffer out(fd);
+        results.writeJSON(out);
+        out.flush();
+        ::close(fd);
+    }
+
+    if (!baselinePath.empty() &&
+        !compareBaseline(results, baselinePath, tolerance, std::cerr)) {
+        return 1;
+    }
+    return 0;
+}
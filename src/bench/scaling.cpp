@@ -0,0 +1,205 @@
+#include "scaling.hpp"
+
+#include "shapes.hpp"
+
+#include "../ast/printer.hpp"
+#include "../ast/tree.hpp"
+
+#include "../parser/tokenizer.hpp"
+
+#include "../support/output.hpp"
+#include "../support/timer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace perun {
+namespace bench {
+
+namespace {
+
+enum Phase { Lex = 0, Parse, Errors, Print, Teardown, PhaseCount };
+
+const char* const phaseNames[PhaseCount] = {"lex", "parse", "errors", "print",
+                                            "teardown"};
+
+// times this short are mostly noise, their exponent isn't checked
+constexpr double minFitSeconds = 100e-6;
+
+// with fewer iterations a single slow run decides the verdict,
+// the fastest two are needed to estimate the noise
+constexpr size_t minIterations = 3;
+
+/// All iterations of one phase on one input
+struct Samples {
+    std::vector<double> seconds;
+
+    double getFastest() const {
+        return *std::min_element(seconds.begin(), seconds.end());
+    }
+
+    /// Relative gap between the fastest and the second fastest run
+    double getNoise() const {
+        std::vector<double> sorted = seconds;
+        std::sort(sorted.begin(), sorted.end());
+        if (sorted.size() < 2 || sorted[0] <= 0) {
+            return 0;
+        }
+        return (sorted[1] - sorted[0]) / sorted[0];
+    }
+};
+
+template <typename F> double timeSeconds(F&& f) {
+    support::Timer timer;
+    timer.start();
+    f();
+    timer.stop();
+    return timer.getSeconds();
+}
+
+/// Measures all phases on a single input 'iterations' times
+/// Returns the size of the printed output.
+size_t measure(const std::string& source, size_t iterations,
+               Samples (&samples)[PhaseCount]) {
+    size_t printedBytes = 0;
+    auto&& sourceManager = std::make_shared<support::SourceManager>();
+    support::FileID file = sourceManager->addBuffer("<scaling>", source);
+
+    for (size_t i = 0; i < iterations; ++i) {
+        samples[Lex].seconds.push_back(timeSeconds([&]() {
+            parser::Tokenizer tokenizer(sourceManager->getBuffer(file));
+            while (tokenizer.nextToken().getKind() !=
+                   parser::Token::Kind::EndOfFile) {
+            }
+        }));
+
+        // every diagnostic is stored and formatted, the store and
+        // the display limit would hide the cost of the later ones
+        std::unique_ptr<ast::Tree> tree = nullptr;
+        samples[Parse].seconds.push_back(timeSeconds([&]() {
+            tree = ast::Tree::get(sourceManager, file, nullptr, false, 0);
+        }));
+
+        tree->getDiagnosticsMut().setDisplayLimit(0);
+        samples[Errors].seconds.push_back(timeSeconds([&]() {
+            std::ostringstream os{};
+            tree->getDiagnostics().print(os, *sourceManager);
+        }));
+
+        samples[Print].seconds.push_back(timeSeconds([&]() {
+            if (tree->getRoot() != nullptr) {
+                support::OutputBuffer out{};
+                ast::Printer(out, 0).printRoot(*tree->getRoot());
+                printedBytes = out.getBytesWritten();
+            }
+        }));
+
+        samples[Teardown].seconds.push_back(
+            timeSeconds([&]() { tree = nullptr; }));
+    }
+    return printedBytes;
+}
+
+/// Slope of the least squares fit of log(seconds) over log(size)
+double fitExponent(const std::vector<double>& sizes,
+                   const std::vector<double>& seconds) {
+    double meanX = 0;
+    double meanY = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        meanX += std::log(sizes[i]) / sizes.size();
+        meanY += std::log(std::max(seconds[i], 1e-9)) / sizes.size();
+    }
+
+    double covariance = 0;
+    double variance = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        double dx = std::log(sizes[i]) - meanX;
+        covariance += dx * (std::log(std::max(seconds[i], 1e-9)) - meanY);
+        variance += dx * dx;
+    }
+    return variance > 0 ? covariance / variance : 0;
+}
+
+} // namespace
+
+bool runScaling(const ScalingOptions& options, std::ostream& os) {
+    const size_t iterations = std::max(options.iterations, minIterations);
+    os << "perun-bench: scaling over " << options.steps
+       << " doublings, bound n^" << options.maxExponent << ", "
+       << iterations << " iterations\n";
+    if (iterations != options.iterations) {
+        os << "perun-bench: note: raised from " << options.iterations
+           << " iterations, fewer can't tell noise from growth\n";
+    }
+    os << "  shape             phase     time at n (ms)  at " << std::setw(3)
+       << (1 << (options.steps - 1)) << "n (ms)  exponent  margin\n";
+
+    bool passed = true;
+    for (auto&& shape : getShapes()) {
+        if (std::string(shape.name).find(options.filter) ==
+            std::string::npos) {
+            continue;
+        }
+
+        // printing is fitted over the size of its output instead,
+        // the indentation of nested blocks grows quadratically
+        std::vector<double> sizes{};
+        std::vector<double> printedSizes{};
+        std::vector<double> times[PhaseCount];
+        double noise[PhaseCount] = {};
+        for (size_t step = 0; step < options.steps; ++step) {
+            size_t n = static_cast<size_t>(shape.baseSize * options.scale)
+                       << step;
+            Samples samples[PhaseCount];
+            size_t printed = measure(shape.generate(n), iterations, samples);
+
+            sizes.push_back(static_cast<double>(n));
+            printedSizes.push_back(static_cast<double>(std::max<size_t>(
+                printed, 1)));
+            for (size_t phase = 0; phase < PhaseCount; ++phase) {
+                times[phase].push_back(samples[phase].getFastest());
+                noise[phase] =
+                    std::max(noise[phase], samples[phase].getNoise());
+            }
+        }
+
+        for (size_t phase = 0; phase < PhaseCount; ++phase) {
+            auto&& phaseTimes = times[phase];
+            os << "  " << std::left << std::setw(18) << shape.name
+               << std::setw(10) << phaseNames[phase] << std::right
+               << std::fixed << std::setprecision(3) << std::setw(14)
+               << phaseTimes.front() * 1000 << std::setw(14)
+               << phaseTimes.back() * 1000;
+
+            if (phaseTimes.back() < minFitSeconds) {
+                os << "         -\n" << std::defaultfloat;
+                continue;
+            }
+
+            // times off by the noise in opposite directions at both ends
+            // tilt the fit by about this much
+            double margin = 2 * std::log2(1 + noise[phase]) /
+                            static_cast<double>(options.steps - 1);
+            double exponent = fitExponent(
+                phase == Print ? printedSizes : sizes, phaseTimes);
+            os << std::setprecision(2) << std::setw(10) << exponent
+               << "  +-" << margin << std::defaultfloat;
+            if (exponent - margin > options.maxExponent) {
+                os << "  SUPERLINEAR";
+                passed = false;
+            } else if (exponent + margin > options.maxExponent) {
+                // too noisy to tell, more iterations would narrow it
+                os << "  NOISY";
+            }
+            os << "\n";
+        }
+    }
+    return passed;
+}
+
+} // namespace bench
+} // namespace perun
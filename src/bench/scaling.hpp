@@ -0,0 +1,42 @@
+#ifndef PERUN_BENCH_SCALING_HPP
+#define PERUN_BENCH_SCALING_HPP
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace perun {
+namespace bench {
+
+struct ScalingOptions {
+    // phases growing faster than n^maxExponent are reported
+    // cache and TLB misses alone push the teardown of big trees
+    // to about n^1.3, a quadratic algorithm shows up as n^2
+    double maxExponent = 1.4;
+
+    // inputs of n, 2n, 4n, ... (steps of them)
+    size_t steps = 4;
+
+    // multiplies the base sizes of all shapes
+    double scale = 1;
+
+    // at least 3 are run, see runScaling
+    size_t iterations = 3;
+
+    // only shapes whose name contains this are run
+    std::string filter{};
+};
+
+/// Runs every phase (lex, parse, error reporting, printing, teardown)
+/// on growing inputs of every Shape and fits the growth exponent
+/// of its time (least squares on log-log).
+/// The fastest of at least 3 iterations is fitted, the gap to the second
+/// fastest one widens the bound by a noise margin.
+/// Returns false if a phase scaled worse than 'maxExponent' beyond
+/// the noise margin.
+bool runScaling(const ScalingOptions& options, std::ostream& os);
+
+} // namespace bench
+} // namespace perun
+
+#endif // PERUN_BENCH_SCALING_HPP
@@ -0,0 +1,105 @@
+#include "shapes.hpp"
+
+#include "generator.hpp"
+
+namespace perun {
+namespace bench {
+
+namespace {
+
+std::string program(size_t n) {
+    GeneratorOptions options{};
+    options.targetBytes = n;
+    return generateProgram(options);
+}
+
+std::string nestedBlocks(size_t n) {
+    std::string out = "fn f() {\n";
+    for (size_t i = 0; i < n; ++i) {
+        out += "if a {\n";
+    }
+    out += "x = 1;\n";
+    for (size_t i = 0; i < n; ++i) {
+        out += "}\n";
+    }
+    return out + "}\n";
+}
+
+std::string nestedParens(size_t n) {
+    return "var x = " + std::string(n, '(') + "1" + std::string(n, ')') +
+           ";\n";
+}
+
+std::string operatorChain(size_t n) {
+    std::string out = "var x = a0";
+    for (size_t i = 1; i < n; ++i) {
+        out += i % 2 == 0 ? " + a" : " * a";
+        out += std::to_string(i % 100);
+    }
+    return out + ";\n";
+}
+
+std::string prefixChain(size_t n) {
+    return "var x = " + std::string(n, '-') + "1;\n";
+}
+
+std::string manyErrors(size_t n) {
+    // every declaration is missing its semicolon, which is recoverable
+    std::string out{};
+    for (size_t i = 0; i < n; ++i) {
+        out += "var x" + std::to_string(i % 100) + " = " + std::to_string(i) +
+               "\n";
+    }
+    return out;
+}
+
+std::string hugeLiteral(size_t n) {
+    return "var x = " + std::string(n, '7') + ";\n// " + std::string(n, 'c') +
+           "\n";
+}
+
+std::string longLine(size_t n) {
+    // line comments would swallow the rest of the line
+    GeneratorOptions options{};
+    options.targetBytes = n;
+    options.commentDensity = 0;
+
+    std::string out = generateProgram(options);
+    for (auto&& c : out) {
+        if (c == '\n') {
+            c = ' ';
+        }
+    }
+    return out;
+}
+
+std::string longLineErrors(size_t n) {
+    std::string out{};
+    for (size_t i = 0; i < n; ++i) {
+        out += "var x" + std::to_string(i % 100) + " = " + std::to_string(i) +
+               " ";
+    }
+    return out + "\n";
+}
+
+} // namespace
+
+const std::vector<Shape>& getShapes() {
+    static const std::vector<Shape> shapes = {
+        {"program", "generated program of n bytes", 256 * 1024, program},
+        {"nested-blocks", "n nested if blocks", 256, nestedBlocks},
+        {"nested-parens", "n nested parentheses", 256, nestedParens},
+        {"infix-chain", "n operands of + and *", 8 * 1024, operatorChain},
+        {"prefix-chain", "n prefix minuses", 256, prefixChain},
+        {"many-errors", "n lines with an error each", 32 * 1024, manyErrors},
+        {"huge-literal", "n digit literal, n byte comment", 256 * 1024,
+         hugeLiteral},
+        {"long-line", "program of n bytes on one line", 256 * 1024, longLine},
+        {"long-line-errors", "n errors on one line", 32 * 1024,
+         longLineErrors},
+    };
+    return shapes;
+}
+
+} // namespace bench
+} // namespace perun
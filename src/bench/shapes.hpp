@@ -0,0 +1,31 @@
+#ifndef PERUN_BENCH_SHAPES_HPP
+#define PERUN_BENCH_SHAPES_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace perun {
+namespace bench {
+
+/// A family of inputs growing with 'n', used to measure scaling
+struct Shape {
+    const char* name;
+    const char* description;
+
+    // 'n' of the smallest input
+    // the nesting shapes stay small, the parser recurses on them
+    size_t baseSize;
+
+    std::string (*generate)(size_t n);
+};
+
+/// The regular generated programs and the adversarial shapes:
+/// deep nesting, long operator chains, many errors, huge literals
+/// and very long lines
+const std::vector<Shape>& getShapes();
+
+} // namespace bench
+} // namespace perun
+
+#endif // PERUN_BENCH_SHAPES_HPP
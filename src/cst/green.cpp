@@ -0,0 +1,232 @@
+#include "green.hpp"
+
+#include <algorithm>
+
+#include "../parser/tokenizer.hpp"
+#include "../support/hash.hpp"
+#include "../support/memory.hpp"
+
+namespace perun {
+namespace cst {
+
+namespace {
+
+/// Splits the trivia in front of a token into whitespace and comments
+void splitTrivia(support::StringRef text,
+                 support::SmallVector<Trivia, 2>& trivia) {
+    auto&& addPiece = [&trivia](TriviaKind kind, size_t width) {
+        if (width > 0) {
+            trivia.push_back({kind, static_cast<uint32_t>(width)});
+        }
+    };
+
+    if (std::find(text.begin(), text.end(), '/') == text.end()) {
+        addPiece(TriviaKind::Whitespace, text.size());
+        return;
+    }
+
+    // the tokenizer decides what is a doc comment
+    parser::Tokenizer tokenizer(text);
+    size_t pos = 0;
+    for (;;) {
+        const parser::Token comment = tokenizer.nextToken();
+        addPiece(TriviaKind::Whitespace, comment.start - pos);
+        if (!comment.isOneOf(parser::Token::Kind::LineComment,
+                             parser::Token::Kind::DocComment)) {
+            break;
+        }
+
+        addPiece(comment.is(parser::Token::Kind::DocComment)
+                     ? TriviaKind::DocComment
+                     : TriviaKind::LineComment,
+                 comment.length());
+        pos = comment.end;
+    }
+}
+
+uint64_t hashToken(parser::Token::Kind kind, support::StringRef fullText) {
+    return support::hashCombine(
+        static_cast<uint64_t>(kind),
+        support::hash64(fullText.data(), fullText.size()));
+}
+
+} // namespace
+
+void GreenElement::writeText(std::string& out) const {
+    if (isToken()) {
+        out += static_cast<const GreenToken&>(*this).getFullText();
+        return;
+    }
+
+    auto&& node = static_cast<const GreenNode&>(*this);
+    for (size_t i = 0; i < node.getChildCount(); ++i) {
+        node.getChild(i).writeText(out);
+    }
+}
+
+GreenToken::GreenToken(parser::Token::Kind kind, std::string&& fullText,
+                       size_t triviaWidth, uint64_t hash)
+    : GreenElement(true, fullText.size(), hash), kind(kind),
+      triviaWidth(static_cast<uint32_t>(triviaWidth)),
+      fullText(std::move(fullText)) {
+    assert(triviaWidth <= this->fullText.size());
+    splitTrivia(support::StringRef(this->fullText).substr(0, triviaWidth),
+                trivia);
+}
+
+GreenNode::GreenNode(ast::Node::Kind kind, const GreenPtr* children,
+                     size_t count, size_t width, uint64_t hash)
+    : GreenElement(false, width, hash), kind(kind) {
+    this->children.reserve(count);
+    size_t offset = 0;
+    for (size_t i = 0; i < count; ++i) {
+        this->children.push_back(
+            Child{children[i], static_cast<uint32_t>(offset)});
+        offset += children[i]->getWidth();
+    }
+}
+
+size_t GreenNode::findChild(size_t offset) const {
+    assert(!children.empty() && offset < getWidth());
+    // the last child starting at or before 'offset',
+    // which skips the empty ones starting there too
+    auto&& it = std::upper_bound(children.begin(), children.end(), offset,
+                                 [](size_t offset, const Child& child) {
+                                     return offset < child.offset;
+                                 });
+    return static_cast<size_t>(it - children.begin()) - 1;
+}
+
+template <typename F>
+GreenCache::Slot& GreenCache::find(uint64_t hash, F&& equals) {
+    if (slots.empty()) {
+        slots.resize(1024);
+    }
+
+    const size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        Slot& slot = slots[i];
+        if (slot.element == nullptr ||
+            (slot.hash == hash && equals(*slot.element))) {
+            return slot;
+        }
+    }
+}
+
+GreenPtr GreenCache::insert(Slot& slot, uint64_t hash, GreenPtr&& element) {
+    slot.hash = hash;
+    slot.element = std::move(element);
+    ++count;
+
+    // at most half full, the probes stay short
+    if (count * 2 <= slots.size()) {
+        return slot.element;
+    }
+
+    GreenPtr result = slot.element;
+    rehash(slots.size() * 2);
+    return result;
+}
+
+void GreenCache::rehash(size_t size) {
+    std::vector<Slot> old(size);
+    old.swap(slots);
+    const size_t mask = slots.size() - 1;
+    for (auto&& entry : old) {
+        if (entry.element == nullptr) {
+            continue;
+        }
+        size_t i = entry.hash & mask;
+        while (slots[i].element != nullptr) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = std::move(entry);
+    }
+}
+
+GreenPtr GreenCache::token(parser::Token::Kind kind,
+                           support::StringRef fullText, size_t triviaWidth) {
+    const uint64_t hash = hashToken(kind, fullText);
+
+    Slot& slot = find(hash, [&](const GreenElement& element) {
+        if (!element.isToken()) {
+            return false;
+        }
+        auto&& token = static_cast<const GreenToken&>(element);
+        return token.getKind() == kind &&
+               token.getTriviaWidth() == triviaWidth &&
+               support::StringRef(token.getFullText()) == fullText;
+    });
+    if (slot.element != nullptr) {
+        ++hits;
+        return slot.element;
+    }
+
+    ++misses;
+    support::MemoryScope memory(support::MemoryPhase::Syntax);
+    return insert(slot, hash,
+                  std::make_shared<GreenToken>(kind, fullText.str(),
+                                               triviaWidth, hash));
+}
+
+GreenPtr GreenCache::node(ast::Node::Kind kind, const GreenPtr* children,
+                          size_t size) {
+    // children are interned, so their hashes identify them
+    uint64_t hash = support::hashCombine(0xC57, static_cast<uint64_t>(kind));
+    size_t width = 0;
+    for (size_t i = 0; i < size; ++i) {
+        hash = support::hashCombine(hash, children[i]->getHash());
+        width += children[i]->getWidth();
+    }
+
+    Slot& slot = find(hash, [&](const GreenElement& element) {
+        if (element.isToken()) {
+            return false;
+        }
+        auto&& node = static_cast<const GreenNode&>(element);
+        if (node.getKind() != kind || node.getChildCount() != size) {
+            return false;
+        }
+        for (size_t i = 0; i < size; ++i) {
+            if (&node.getChild(i) != children[i].get()) {
+                return false;
+            }
+        }
+        return true;
+    });
+    if (slot.element != nullptr) {
+        ++hits;
+        return slot.element;
+    }
+
+    ++misses;
+    support::MemoryScope memory(support::MemoryPhase::Syntax);
+    return insert(slot, hash,
+                  std::make_shared<GreenNode>(kind, children, size, width,
+                                              hash));
+}
+
+size_t GreenCache::collect() {
+    const size_t before = count;
+
+    // dropping a node can leave its children unused, so repeat
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto&& slot : slots) {
+            if (slot.element != nullptr && slot.element.use_count() == 1) {
+                slot.element = nullptr;
+                --count;
+                changed = true;
+            }
+        }
+    }
+
+    // the probe sequences may have holes now
+    rehash(slots.size());
+
+    return before - count;
+}
+
+} // namespace cst
+} // namespace perun
@@ -0,0 +1,176 @@
+#ifndef PERUN_CST_GREEN_HPP
+#define PERUN_CST_GREEN_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../ast/node.hpp"
+#include "../parser/token.hpp"
+#include "../support/smallvector.hpp"
+#include "../support/stringref.hpp"
+
+namespace perun {
+namespace cst {
+
+/// Kinds of the source text between two tokens
+enum class TriviaKind : uint8_t {
+    Whitespace,
+    LineComment,
+    DocComment,
+};
+
+struct Trivia {
+    TriviaKind kind;
+    uint32_t width;
+};
+
+/// Element of the immutable ("green") half of the syntax tree
+///
+/// An element only knows its kind, its width and its children, never
+/// its position, so equal subtrees are the same element -- within a tree
+/// and between versions of it (see GreenCache).
+/// Every token owns the trivia in front of it, which makes the tree
+/// lossless: its text is exactly the source it was parsed from.
+class GreenElement {
+public:
+    bool isToken() const { return token; }
+
+    /// Length of the text, including all trivia
+    size_t getWidth() const { return width; }
+
+    uint64_t getHash() const { return hash; }
+
+    /// Appends the text of the element to 'out'
+    void writeText(std::string& out) const;
+
+protected:
+    GreenElement(bool token, size_t width, uint64_t hash)
+        : token(token), width(static_cast<uint32_t>(width)), hash(hash) {}
+
+private:
+    bool token;
+    uint32_t width;
+    uint64_t hash;
+};
+
+using GreenPtr = std::shared_ptr<const GreenElement>;
+
+class GreenToken : public GreenElement {
+public:
+    /// 'fullText' starts with 'triviaWidth' bytes of trivia
+    GreenToken(parser::Token::Kind kind, std::string&& fullText,
+               size_t triviaWidth, uint64_t hash);
+
+    parser::Token::Kind getKind() const { return kind; }
+
+    /// The leading trivia followed by the token itself
+    const std::string& getFullText() const { return fullText; }
+
+    /// The token without its trivia
+    support::StringRef getText() const {
+        return support::StringRef(fullText).substr(triviaWidth);
+    }
+
+    size_t getTriviaWidth() const { return triviaWidth; }
+
+    /// Pieces of the leading trivia, in order
+    const support::SmallVector<Trivia, 2>& getTrivia() const {
+        return trivia;
+    }
+
+private:
+    parser::Token::Kind kind;
+    uint32_t triviaWidth;
+    std::string fullText;
+    support::SmallVector<Trivia, 2> trivia;
+};
+
+class GreenNode : public GreenElement {
+public:
+    GreenNode(ast::Node::Kind kind, const GreenPtr* children, size_t count,
+              size_t width, uint64_t hash);
+
+    ast::Node::Kind getKind() const { return kind; }
+
+    size_t getChildCount() const { return children.size(); }
+
+    const GreenElement& getChild(size_t i) const {
+        assert(i < children.size());
+        return *children[i].element;
+    }
+
+    /// Offset of a child from the start of this node
+    size_t getChildOffset(size_t i) const {
+        assert(i < children.size());
+        return children[i].offset;
+    }
+
+    /// Index of the child whose text contains 'offset' (relative)
+    size_t findChild(size_t offset) const;
+
+private:
+    struct Child {
+        GreenPtr element;
+        uint32_t offset;
+    };
+
+    ast::Node::Kind kind;
+    std::vector<Child> children;
+};
+
+/// Interning table of green elements
+///
+/// Hands out the existing element for a token with the same kind
+/// and text, or for a node with the same kind and children. Children
+/// are interned before their parents, so comparing their pointers is
+/// enough. A tree parsed again after an edit shares everything
+/// outside of the edited part with the previous version.
+/// Not thread-safe, meant to be kept per document.
+class GreenCache {
+public:
+    /// 'fullText' starts with 'triviaWidth' bytes of trivia
+    GreenPtr token(parser::Token::Kind kind, support::StringRef fullText,
+                   size_t triviaWidth);
+
+    GreenPtr node(ast::Node::Kind kind, const GreenPtr* children,
+                  size_t size);
+
+    size_t size() const { return count; }
+    size_t getHits() const { return hits; }
+    size_t getMisses() const { return misses; }
+
+    /// Drops the elements nothing but the cache refers to
+    /// Returns the number of dropped elements.
+    size_t collect();
+
+private:
+    struct Slot {
+        uint64_t hash;
+        GreenPtr element; // null if empty
+    };
+
+    // open addressing with linear probing, the size is a power of two
+    // a lookup mostly touches a single slot and the element it checks
+    std::vector<Slot> slots;
+    size_t count = 0;
+
+    size_t hits = 0;
+    size_t misses = 0;
+
+    /// Returns the slot holding an element with 'hash' for which
+    /// 'equals' holds, or the empty slot where it belongs
+    template <typename F> Slot& find(uint64_t hash, F&& equals);
+
+    /// Puts 'element' into the empty 'slot' returned by 'find'
+    GreenPtr insert(Slot& slot, uint64_t hash, GreenPtr&& element);
+
+    void rehash(size_t size);
+};
+
+} // namespace cst
+} // namespace perun
+
+#endif // PERUN_CST_GREEN_HPP
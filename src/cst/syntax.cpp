@@ -0,0 +1,248 @@
+#include "syntax.hpp"
+
+#include <vector>
+
+#include "../parser/grammar.hpp"
+#include "../support/memory.hpp"
+
+namespace perun {
+namespace cst {
+
+namespace {
+
+/// Builder of parser::Grammar which makes green nodes
+///
+/// Tokens become green tokens as soon as they are consumed, each
+/// with the source text between it and the previous token as its
+/// leading trivia. A complete node takes the nodes made since its
+/// start and the tokens around them, in source order, as children.
+/// The trivia after the last declaration belongs to the end-of-file
+/// token.
+class GreenBuilder {
+public:
+    // the children are on the builder's stack
+    template <typename T> using Ptr = parser::NodeHandle;
+    template <typename T> using List = parser::NodeHandleList;
+
+    struct Start {
+        size_t firstToken;
+        size_t mark;
+    };
+
+    static constexpr bool releasesTokens = true;
+
+    /// 'root' is set once the whole file is parsed
+    GreenBuilder(const parser::ParserBase& parser, support::StringRef source,
+                 GreenCache& cache, std::shared_ptr<const GreenNode>& root)
+        : parser(parser), source(source), cache(cache), root(root) {}
+
+    Start start() const {
+        return Start{parser.getNextTokenIndex(), stack.size()};
+    }
+
+    template <typename T, typename... Args>
+    parser::NodeHandle make(Start start, Args&&...) {
+        build(ast::NodeKindOf<T>::value, start);
+        return parser::NodeHandle::made();
+    }
+
+    parser::NodeHandle makeIdentifier(Start start, size_t) {
+        return make<ast::Identifier>(start);
+    }
+
+    parser::NodeHandle makeInteger(Start start, size_t) {
+        return make<ast::LiteralInteger>(start);
+    }
+
+    parser::NodeHandle makeRoot() { return parser::NodeHandle::made(); }
+
+    void addDecl(parser::NodeHandle&, parser::NodeHandle&&) {
+        assert(stack.size() == 1);
+        Entry& decl = stack.back();
+        addRootTokens(decl.first);
+        rootChildren.push_back(std::move(decl.green));
+
+        tokens.erase(tokens.begin(),
+                     tokens.begin() + (decl.last + 1 - tokensBase));
+        tokensBase = decl.last + 1;
+        stack.clear();
+    }
+
+    void finishRoot(parser::NodeHandle&, size_t eofToken) {
+        addTokens(eofToken + 1);
+        addRootTokens(eofToken + 1);
+        root = std::static_pointer_cast<const GreenNode>(
+            cache.node(ast::Node::Kind::Root, rootChildren.data(),
+                       rootChildren.size()));
+    }
+
+private:
+    /// A complete node not yet taken by its parent
+    struct Entry {
+        GreenPtr green;
+        size_t first; // first and last token
+        size_t last;
+    };
+
+    const parser::ParserBase& parser;
+    const support::StringRef source;
+    GreenCache& cache;
+
+    std::vector<Entry> stack;
+
+    // green tokens of the current declaration, from 'tokensBase' on
+    std::vector<GreenPtr> tokens;
+    size_t tokensBase = 0;
+    size_t triviaStart = 0;
+
+    std::vector<GreenPtr> children; // reused by 'build'
+    std::vector<GreenPtr> rootChildren;
+    std::shared_ptr<const GreenNode>& root;
+
+    /// Makes the green tokens before 'end'
+    void addTokens(size_t end) {
+        for (size_t i = tokensBase + tokens.size(); i < end; ++i) {
+            const parser::Token& token = parser.tokenAt(i);
+            tokens.push_back(cache.token(
+                token.getKind(),
+                source.substr(triviaStart, token.end - triviaStart),
+                token.start - triviaStart));
+            triviaStart = token.end;
+        }
+    }
+
+    /// Moves the tokens before 'end' outside of any declaration
+    /// (skipped after an error, or the end of file) to the root
+    void addRootTokens(size_t end) {
+        assert(end >= tokensBase);
+        rootChildren.insert(rootChildren.end(), tokens.begin(),
+                            tokens.begin() + (end - tokensBase));
+        tokens.erase(tokens.begin(), tokens.begin() + (end - tokensBase));
+        tokensBase = end;
+    }
+
+    void build(ast::Node::Kind kind, Start start) {
+        const size_t last = parser.getTokenIndex();
+        addTokens(last + 1);
+
+        children.clear();
+        size_t next = start.firstToken;
+        for (size_t i = start.mark; i < stack.size(); ++i) {
+            Entry& child = stack[i];
+            for (; next < child.first; ++next) {
+                children.push_back(tokens[next - tokensBase]);
+            }
+            children.push_back(std::move(child.green));
+            next = child.last + 1;
+        }
+        for (; next <= last; ++next) {
+            children.push_back(tokens[next - tokensBase]);
+        }
+
+        stack.resize(start.mark);
+        stack.push_back(
+            Entry{cache.node(kind, children.data(), children.size()),
+                  start.firstToken, last});
+    }
+};
+
+} // namespace
+
+SyntaxNode::SyntaxNode(std::shared_ptr<const GreenNode> green)
+    : owner(std::move(green)), green(*owner), parent(nullptr), index(0),
+      offset(0) {}
+
+SyntaxNode::SyntaxNode(const GreenNode& green, const SyntaxNode* parent,
+                       size_t index, size_t offset)
+    : green(green), parent(parent), index(index), offset(offset) {}
+
+const SyntaxNode& SyntaxNode::getChildNode(size_t i) const {
+    assert(!isTokenAt(i));
+    if (children == nullptr) {
+        support::MemoryScope memory(support::MemoryPhase::Syntax);
+        children = std::make_unique<std::unique_ptr<SyntaxNode>[]>(
+            getChildCount());
+    }
+
+    auto&& child = children[i];
+    if (child == nullptr) {
+        support::MemoryScope memory(support::MemoryPhase::Syntax);
+        child.reset(new SyntaxNode(
+            static_cast<const GreenNode&>(green.getChild(i)), this, i,
+            offset + green.getChildOffset(i)));
+    }
+    return *child;
+}
+
+SyntaxToken SyntaxNode::getChildToken(size_t i) const {
+    assert(isTokenAt(i));
+    return SyntaxToken{&static_cast<const GreenToken&>(green.getChild(i)),
+                       this, i, offset + green.getChildOffset(i)};
+}
+
+const SyntaxNode& SyntaxNode::findNode(size_t pos) const {
+    assert(pos >= offset && pos < getEnd());
+    const SyntaxNode* node = this;
+    for (;;) {
+        const size_t i = node->green.findChild(pos - node->offset);
+        if (node->isTokenAt(i)) {
+            return *node;
+        }
+        node = &node->getChildNode(i);
+    }
+}
+
+SyntaxToken SyntaxNode::findToken(size_t pos) const {
+    const SyntaxNode& node = findNode(pos);
+    return node.getChildToken(node.green.findChild(pos - node.offset));
+}
+
+std::string SyntaxNode::getText() const {
+    std::string text{};
+    text.reserve(green.getWidth());
+    green.writeText(text);
+    return text;
+}
+
+std::unique_ptr<SyntaxTree>
+SyntaxTree::parse(ast::Tree::SourceManagerPtr sourceManager,
+                  support::FileID file, GreenCache& cache) {
+    support::MemoryScope memory(support::MemoryPhase::Parser);
+    parser::DiagnosticsEngine diagnostics{};
+    std::vector<parser::Token> tokens{};
+    std::unique_ptr<ast::Root> astRoot = nullptr;
+    auto&& tree = std::make_unique<ast::Tree>(
+        std::move(sourceManager), file, std::move(astRoot), std::move(tokens),
+        std::move(diagnostics));
+
+    std::shared_ptr<const GreenNode> green = nullptr;
+    {
+        parser::Grammar<GreenBuilder> grammar(*tree, nullptr, false,
+                                              tree->getSource(), cache, green);
+        try {
+            grammar.parseRoot();
+            tree->setRoot(std::make_unique<ast::Root>());
+        } catch (int) {
+            // parsing ended with an unrecoverable error
+        }
+    }
+
+    std::unique_ptr<SyntaxNode> root = nullptr;
+    if (green != nullptr) {
+        support::MemoryScope memory(support::MemoryPhase::Syntax);
+        root = std::make_unique<SyntaxNode>(std::move(green));
+    }
+
+    tree->getTokensMut().clear();
+    tree->getTokensMut().shrink_to_fit();
+
+    return std::unique_ptr<SyntaxTree>(
+        new SyntaxTree(std::move(tree), std::move(root)));
+}
+
+std::string SyntaxTree::getText() const {
+    return root != nullptr ? root->getText() : std::string();
+}
+
+} // namespace cst
+} // namespace perun
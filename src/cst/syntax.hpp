@@ -0,0 +1,124 @@
+#ifndef PERUN_CST_SYNTAX_HPP
+#define PERUN_CST_SYNTAX_HPP
+
+#include <cassert>
+#include <memory>
+#include <string>
+
+#include "../ast/tree.hpp"
+
+#include "green.hpp"
+
+namespace perun {
+namespace cst {
+
+class SyntaxNode;
+
+/// A green token at its place in a tree
+struct SyntaxToken {
+    const GreenToken* green;
+    const SyntaxNode* parent;
+    size_t index;  // in 'parent'
+    size_t offset; // of its leading trivia in the file
+
+    parser::Token::Kind getKind() const { return green->getKind(); }
+
+    /// Offsets of the token itself, without trivia
+    size_t getStart() const { return offset + green->getTriviaWidth(); }
+    size_t getEnd() const { return offset + green->getWidth(); }
+
+    support::StringRef getText() const { return green->getText(); }
+};
+
+/// A green node at its place in a tree (the "red" half)
+///
+/// Knows its parent and absolute offset, which the shared green nodes
+/// cannot. Red nodes are cheap and made on demand, only along the
+/// paths the tree is walked on, and live as long as the root.
+class SyntaxNode {
+public:
+    /// A root over 'green', which it keeps alive
+    explicit SyntaxNode(std::shared_ptr<const GreenNode> green);
+
+    SyntaxNode(const SyntaxNode&) = delete;
+    SyntaxNode& operator=(const SyntaxNode&) = delete;
+
+    const GreenNode& getGreen() const { return green; }
+    ast::Node::Kind getKind() const { return green.getKind(); }
+
+    /// Offsets in the file, including the leading trivia
+    size_t getOffset() const { return offset; }
+    size_t getEnd() const { return offset + green.getWidth(); }
+
+    /// Null for the root
+    const SyntaxNode* getParent() const { return parent; }
+    size_t getIndexInParent() const { return index; }
+
+    size_t getChildCount() const { return green.getChildCount(); }
+    bool isTokenAt(size_t i) const { return green.getChild(i).isToken(); }
+
+    /// Asserts the child is a node
+    const SyntaxNode& getChildNode(size_t i) const;
+
+    /// Asserts the child is a token
+    SyntaxToken getChildToken(size_t i) const;
+
+    /// The innermost node containing 'pos', trivia included
+    /// Asserts 'pos' is inside of this node.
+    const SyntaxNode& findNode(size_t pos) const;
+
+    /// The token containing 'pos' in it or in its leading trivia
+    SyntaxToken findToken(size_t pos) const;
+
+    std::string getText() const;
+
+private:
+    SyntaxNode(const GreenNode& green, const SyntaxNode* parent,
+               size_t index, size_t offset);
+
+    std::shared_ptr<const GreenNode> owner; // only set in the root
+    const GreenNode& green;
+
+    const SyntaxNode* parent;
+    size_t index;
+    size_t offset;
+
+    // made on the first access, null for tokens
+    mutable std::unique_ptr<std::unique_ptr<SyntaxNode>[]> children;
+};
+
+/// Lossless syntax tree of a file: every byte of the source,
+/// comments and whitespace included, is in exactly one token
+class SyntaxTree {
+public:
+    /// Parses the buffer 'file' owned by 'sourceManager'
+    /// Every green element equal to one already in 'cache' is reused,
+    /// so the trees of subsequent versions of a file share everything
+    /// the edits did not touch.
+    static std::unique_ptr<SyntaxTree>
+    parse(ast::Tree::SourceManagerPtr sourceManager, support::FileID file,
+          GreenCache& cache);
+
+    /// Holds the diagnostics, has no tokens and its root is empty
+    const ast::Tree& getTree() const { return *tree; }
+
+    bool hasErrors() const { return tree->hasErrors(); }
+
+    /// Null after an unrecoverable error
+    const SyntaxNode* getRoot() const { return root.get(); }
+
+    std::string getText() const;
+
+private:
+    SyntaxTree(std::unique_ptr<ast::Tree>&& tree,
+               std::unique_ptr<SyntaxNode>&& root)
+        : tree(std::move(tree)), root(std::move(root)) {}
+
+    std::unique_ptr<ast::Tree> tree;
+    std::unique_ptr<SyntaxNode> root;
+};
+
+} // namespace cst
+} // namespace perun
+
+#endif // PERUN_CST_SYNTAX_HPP
@@ -0,0 +1,304 @@
+#include "cache.hpp"
+
+#include "../ast/serializer.hpp"
+
+#include "../support/bytes.hpp"
+#include "../support/hash.hpp"
+#include "../support/util.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace perun {
+namespace driver {
+
+namespace {
+
+// bump this whenever the entry layout or the AST changes
+constexpr uint64_t formatVersion = 3;
+
+const char entryMagic[] = {'P', 'R', 'N', 'C'};
+const char entrySuffix[] = ".pcache";
+const char tmpInfix[] = ".pcache.tmp.";
+
+// a temporary file this old was left behind by a process
+// that died between writing and renaming it
+constexpr time_t staleTmpAge = 60 * 60;
+
+bool hasSuffix(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+ParseCache::ParseCache(std::string directory, uint64_t maxSize)
+    : directory(std::move(directory)), maxSize(maxSize) {
+    // it's fine if this fails because the directory already exists
+    ::mkdir(this->directory.c_str(), 0755);
+}
+
+uint64_t ParseCache::getKey(support::StringRef source) const {
+    return support::hash64(source.data(), source.size(), formatVersion);
+}
+
+std::string ParseCache::getEntryPath(uint64_t key) const {
+    return directory + "/" + support::hashToHex(key) + entrySuffix;
+}
+
+std::unique_ptr<ast::Tree>
+ParseCache::load(uint64_t key, ast::Tree::SourceManagerPtr sourceManager,
+                 support::FileID file) const {
+    const std::string path = getEntryPath(key);
+    const std::string entry = support::readFile(path);
+    if (entry.empty()) {
+        return nullptr;
+    }
+
+    support::ByteReader reader(entry.data(), entry.size());
+    for (char c : entryMagic) {
+        if (reader.readByte() != static_cast<uint8_t>(c)) {
+            return nullptr;
+        }
+    }
+
+    // tokens and diagnostics past the source would be read out of bounds
+    const size_t sourceSize = sourceManager->getBuffer(file).size();
+    if (reader.readVarint() != formatVersion || reader.readFixed64() != key ||
+        reader.readVarint() != sourceSize) {
+        return nullptr;
+    }
+
+    std::vector<parser::Token> tokens{};
+    uint64_t tokensSize = reader.readVarint();
+    for (uint64_t i = 0; i < tokensSize && !reader.failed(); ++i) {
+        uint64_t kind = reader.readVarint();
+        if (kind >= parser::tokenKindsCount) {
+            return nullptr;
+        }
+        uint64_t start = reader.readVarint();
+        uint64_t length = reader.readVarint();
+        if (start > sourceSize || length > sourceSize - start) {
+            return nullptr;
+        }
+        parser::Token token(static_cast<parser::Token::Kind>(kind), start);
+        token.end = start + length;
+        tokens.push_back(token);
+    }
+
+    parser::DiagnosticsEngine diagnostics{};
+    uint64_t diagnosticsSize = reader.readVarint();
+    for (uint64_t i = 0; i < diagnosticsSize && !reader.failed(); ++i) {
+        parser::Diagnostic diag{};
+        uint64_t id = reader.readVarint();
+        if (id >= parser::diagIDsCount) {
+            return nullptr;
+        }
+        diag.id = static_cast<parser::DiagID>(id);
+        size_t pos = reader.readVarint();
+        if (pos > sourceSize) {
+            return nullptr;
+        }
+        diag.loc = sourceManager->getLoc(file, pos);
+        diag.argsSize = reader.readByte();
+        if (diag.argsSize > parser::Diagnostic::maxArgs) {
+            return nullptr;
+        }
+        for (size_t j = 0; j < diag.argsSize; ++j) {
+            uint64_t kind = reader.readByte();
+            uint64_t value = reader.readVarint();
+            if (!parser::DiagArg::isValid(kind, value)) {
+                return nullptr;
+            }
+            diag.args[j].kind = static_cast<parser::DiagArg::Kind>(kind);
+            diag.args[j].value = static_cast<uint32_t>(value);
+        }
+        diagnostics.report(diag);
+    }
+    diagnostics.setDroppedCount(reader.readVarint());
+
+    // kept aside until the tree exists
+    std::vector<std::pair<size_t, parser::Token>> docComments{};
+    uint64_t docCommentsSize = reader.readVarint();
+    for (uint64_t i = 0; i < docCommentsSize && !reader.failed(); ++i) {
+        uint64_t tokenIndex = reader.readVarint();
+        uint64_t start = reader.readVarint();
+        uint64_t length = reader.readVarint();
+        if (tokenIndex >= tokens.size() || start > sourceSize ||
+            length > sourceSize - start) {
+            return nullptr;
+        }
+        parser::Token comment(parser::Token::Kind::DocComment, start);
+        comment.end = start + length;
+        docComments.emplace_back(tokenIndex, comment);
+    }
+
+    std::unique_ptr<ast::Root> root = nullptr;
+    if (reader.readBool()) {
+        ast::Deserializer deserializer(reader, tokens.size());
+        root = deserializer.readRoot();
+        if (root == nullptr) {
+            return nullptr;
+        }
+    }
+
+    if (reader.failed() || !reader.atEnd()) {
+        return nullptr;
+    }
+
+    // refresh the entry for the LRU eviction
+    ::utimes(path.c_str(), nullptr);
+
+    auto&& tree = std::make_unique<ast::Tree>(
+        std::move(sourceManager), file, std::move(root), std::move(tokens),
+        std::move(diagnostics));
+    for (auto&& docComment : docComments) {
+        tree->addDocComment(docComment.first, docComment.second);
+    }
+    return std::move(tree);
+}
+
+void ParseCache::store(uint64_t key, const ast::Tree& tree) const {
+    std::string entry{};
+    support::ByteWriter writer(entry);
+
+    writer.writeBytes(entryMagic, sizeof(entryMagic));
+    writer.writeVarint(formatVersion);
+    writer.writeFixed64(key);
+    writer.writeVarint(tree.getSource().size());
+
+    auto&& tokens = tree.getTokens();
+    writer.writeVarint(tokens.size());
+    for (auto&& token : tokens) {
+        writer.writeVarint(static_cast<uint64_t>(token.getKind()));
+        writer.writeVarint(token.start);
+        writer.writeVarint(token.length());
+    }
+
+    // locations are stored relative to the file,
+    // global offsets differ between processes
+    auto&& sourceManager = tree.getSourceManager();
+    auto&& diagnostics = tree.getDiagnostics();
+    writer.writeVarint(diagnostics.getDiagnostics().size());
+    for (auto&& diag : diagnostics.getDiagnostics()) {
+        writer.writeVarint(static_cast<uint64_t>(diag.id));
+        writer.writeVarint(sourceManager.getFilePos(diag.loc));
+        writer.writeByte(diag.argsSize);
+        for (size_t i = 0; i < diag.argsSize; ++i) {
+            writer.writeByte(static_cast<uint8_t>(diag.args[i].kind));
+            writer.writeVarint(diag.args[i].value);
+        }
+    }
+    writer.writeVarint(diagnostics.getDroppedCount());
+
+    auto&& docComments = tree.getDocComments();
+    writer.writeVarint(docComments.size());
+    for (auto&& docComment : docComments) {
+        writer.writeVarint(docComment.first);
+        writer.writeVarint(docComment.second.start);
+        writer.writeVarint(docComment.second.end - docComment.second.start);
+    }
+
+    auto&& root = tree.getRoot();
+    writer.writeBool(root != nullptr);
+    if (root != nullptr) {
+        ast::Serializer serializer(writer);
+        serializer.writeRoot(*root);
+    }
+
+    // write into a process-unique temporary file and atomically rename it,
+    // readers will never observe a partially written entry
+    static std::atomic<unsigned> tmpCounter(0);
+    const std::string path = getEntryPath(key);
+    const std::string tmpPath = path + ".tmp." + std::to_string(::getpid()) +
+                                "." + std::to_string(tmpCounter++);
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        out.write(entry.data(), entry.size());
+        if (!out) {
+            std::remove(tmpPath.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+    }
+}
+
+void ParseCache::evict() const {
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        time_t mtime;
+    };
+
+    DIR* dir = ::opendir(directory.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+
+    const time_t now = ::time(nullptr);
+    std::vector<Entry> entries{};
+    uint64_t totalSize = 0;
+    while (auto&& dirent = ::readdir(dir)) {
+        const std::string name = dirent->d_name;
+        const bool tmp = name.find(tmpInfix) != std::string::npos;
+        if (!tmp && !hasSuffix(name, entrySuffix)) {
+            continue;
+        }
+
+        const std::string path = directory + "/" + name;
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0) {
+            continue;
+        }
+
+        if (tmp) {
+            // a recent one may still be renamed into place,
+            // it only counts toward the size
+            if (now - st.st_mtime >= staleTmpAge) {
+                std::remove(path.c_str());
+            } else {
+                totalSize += st.st_size;
+            }
+            continue;
+        }
+
+        entries.push_back({path, static_cast<uint64_t>(st.st_size),
+                           st.st_mtime});
+        totalSize += st.st_size;
+    }
+    ::closedir(dir);
+
+    if (totalSize <= maxSize) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.mtime < b.mtime; });
+
+    for (auto&& entry : entries) {
+        if (totalSize <= maxSize) {
+            break;
+        }
+
+        // another process may have removed it already, that's fine
+        if (std::remove(entry.path.c_str()) == 0) {
+            totalSize -= entry.size;
+        }
+    }
+}
+
+} // namespace driver
+} // namespace perun
@@ -0,0 +1,56 @@
+#ifndef PERUN_DRIVER_CACHE_HPP
+#define PERUN_DRIVER_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../ast/tree.hpp"
+
+namespace perun {
+
+namespace driver {
+
+/// Content-addressed on-disk cache of parse results
+///
+/// Entries are keyed by a hash of the source bytes and the cache format
+/// version and contain the tokens, the diagnostics and the serialized AST.
+/// Entries are written into a temporary file which is then renamed
+/// into place, so concurrent perun processes can safely share a directory.
+/// The directory is kept under 'maxSize' bytes by evicting
+/// the least recently used entries (a hit refreshes the entry's mtime).
+/// Eviction scans the whole directory, so it is not done by 'store',
+/// call 'evict' once after a batch of stores.
+class ParseCache {
+public:
+    ParseCache(std::string directory, uint64_t maxSize);
+
+    /// Computes the key of an entry
+    uint64_t getKey(support::StringRef source) const;
+
+    /// Returns nullptr on a miss or on a malformed entry
+    std::unique_ptr<ast::Tree> load(uint64_t key,
+                                    ast::Tree::SourceManagerPtr sourceManager,
+                                    support::FileID file) const;
+
+    /// Stores a tree, failures are silently ignored
+    /// -> a cache should never break a build
+    void store(uint64_t key, const ast::Tree& tree) const;
+
+    /// Removes the oldest entries until the directory fits into maxSize
+    /// and sweeps temporary files left behind by crashed writers
+    void evict() const;
+
+    static constexpr uint64_t defaultMaxSize = 256 * 1024 * 1024;
+
+private:
+    std::string getEntryPath(uint64_t key) const;
+
+    const std::string directory;
+    const uint64_t maxSize;
+};
+
+} // namespace driver
+} // namespace perun
+
+#endif // PERUN_DRIVER_CACHE_HPP
@@ -0,0 +1,415 @@
+#include "daemon.hpp"
+
+#include "driver.hpp"
+#include "treecache.hpp"
+
+#include "../support/bytes.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace perun {
+namespace driver {
+
+// A request is a fixed64 length of the body, sent together with the client's
+// stdout and stderr (SCM_RIGHTS), followed by the body:
+//   varint version, varint argument count, strings arguments, string cwd
+// The response is a varint exit status, the connection is closed after it.
+namespace {
+
+constexpr uint64_t protocolVersion = 1;
+
+// guards the daemon against garbage on the socket
+constexpr uint64_t maxRequestSize = 64 * 1024 * 1024;
+
+constexpr size_t passedFds = 2;
+
+// a client which stops sending would block every other one,
+// connections are served one at a time
+constexpr time_t receiveTimeoutSeconds = 10;
+
+/// Closes a file descriptor on destruction
+class FdGuard {
+public:
+    explicit FdGuard(int fd = -1) : fd(fd) {}
+    ~FdGuard() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    FdGuard(const FdGuard&) = delete;
+    FdGuard& operator=(const FdGuard&) = delete;
+
+    int get() const { return fd; }
+    void reset(int newFd) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = newFd;
+    }
+
+private:
+    int fd;
+};
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+/// Reads exactly 'size' bytes, returns false on an error or an early EOF
+bool readExactly(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t count = ::read(fd, data, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool getAddress(const std::string& path, struct sockaddr_un& address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.data(), path.size());
+    return true;
+}
+
+/// Returns a connected socket or -1
+int connectTo(const std::string& path) {
+    struct sockaddr_un address;
+    if (!getAddress(path, address)) {
+        return -1;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<struct sockaddr*>(&address),
+                  sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/// Sends the length of the request together with the passed descriptors
+bool sendHeader(int fd, uint64_t bodySize) {
+    std::string header{};
+    support::ByteWriter(header).writeFixed64(bodySize);
+
+    struct iovec iov;
+    iov.iov_base = &header[0];
+    iov.iov_len = header.size();
+
+    union {
+        char buffer[CMSG_SPACE(passedFds * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(passedFds * sizeof(int));
+    const int fds[passedFds] = {STDOUT_FILENO, STDERR_FILENO};
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    // the descriptors go with the first byte, the rest is written normally
+    return sent > 0 && writeAll(fd, header.data() + sent, header.size() - sent);
+}
+
+/// Receives the length of the request and the passed descriptors
+bool receiveHeader(int fd, uint64_t& bodySize, FdGuard (&fds)[passedFds]) {
+    char header[8];
+
+    struct iovec iov;
+    iov.iov_base = header;
+    iov.iov_len = sizeof(header);
+
+    union {
+        char buffer[CMSG_SPACE(passedFds * sizeof(int))];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    ssize_t received;
+    do {
+        received = ::recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) {
+        return false;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+            cmsg->cmsg_len == CMSG_LEN(passedFds * sizeof(int))) {
+            int passed[passedFds];
+            std::memcpy(passed, CMSG_DATA(cmsg), sizeof(passed));
+            for (size_t i = 0; i < passedFds; ++i) {
+                fds[i].reset(passed[i]);
+            }
+        }
+    }
+    if ((message.msg_flags & MSG_CTRUNC) != 0) {
+        return false;
+    }
+    // both the output and the diagnostics descriptor are required
+    for (auto&& passed : fds) {
+        if (passed.get() < 0) {
+            return false;
+        }
+    }
+
+    if (!readExactly(fd, header + received, sizeof(header) - received)) {
+        return false;
+    }
+    bodySize = support::ByteReader(header, sizeof(header)).readFixed64();
+    return true;
+}
+
+/// Paths of a request are resolved against its working directory,
+/// so it has to be absolute
+bool isDirectory(const std::string& path) {
+    struct stat st;
+    return !path.empty() && path[0] == '/' &&
+           ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+/// Serves a single connection, returns false if the daemon should stop
+bool serve(int client, TreeCache& treeCache) {
+    uint64_t bodySize = 0;
+    FdGuard fds[passedFds];
+    if (!receiveHeader(client, bodySize, fds) || bodySize > maxRequestSize) {
+        return true;
+    }
+
+    std::string body(bodySize, '\0');
+    if (!readExactly(client, &body[0], body.size())) {
+        return true;
+    }
+
+    support::ByteReader reader(body.data(), body.size());
+    const uint64_t version = reader.readVarint();
+    // every argument takes at least the byte of its length
+    const uint64_t argCount = reader.readVarint();
+    bool valid = !reader.failed() && version == protocolVersion &&
+                 argCount <= reader.remaining();
+    std::vector<std::string> args(valid ? argCount : 0);
+    for (auto&& arg : args) {
+        arg = reader.readString();
+    }
+    const std::string workingDirectory = reader.readString();
+    valid = valid && !reader.failed();
+
+    const bool shutdown =
+        valid && args.size() == 1 && args[0] == "--shutdown";
+
+    int status = 0;
+    std::ostringstream err{};
+    if (!valid) {
+        err << "perun: error: invalid daemon request\n";
+        status = 1;
+    } else if (shutdown) {
+        // nothing to build
+    } else if (!isDirectory(workingDirectory)) {
+        err << "perun: error: daemon could not find directory '"
+            << workingDirectory << "'\n";
+        status = 1;
+    } else {
+        // relative paths are resolved by the build,
+        // the daemon's own working directory never changes
+        BuildContext context{};
+        context.outFd = fds[0].get();
+        context.err = &err;
+        context.workingDirectory = workingDirectory;
+        context.treeCache = &treeCache;
+        status = run(args, context);
+    }
+
+    // diagnostics are rendered only after the build, send them in one go
+    const std::string errors = err.str();
+    writeAll(fds[1].get(), errors.data(), errors.size());
+
+    std::string response{};
+    support::ByteWriter(response).writeVarint(static_cast<uint64_t>(status));
+    writeAll(client, response.data(), response.size());
+
+    return !shutdown;
+}
+
+} // namespace
+
+int runDaemon(const std::string& socketPath) {
+    struct sockaddr_un address;
+    if (!getAddress(socketPath, address)) {
+        std::cerr << "perun: error: invalid daemon socket path: '"
+                  << socketPath << "'\n";
+        return 1;
+    }
+
+    // a socket left behind by a killed daemon is replaced,
+    // a live one is not
+    struct stat info;
+    if (::lstat(socketPath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        int live = connectTo(socketPath);
+        if (live >= 0) {
+            ::close(live);
+            std::cerr << "perun: error: a daemon is already listening on '"
+                      << socketPath << "'\n";
+            return 1;
+        }
+        ::unlink(socketPath.c_str());
+    }
+
+    FdGuard listener(::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (listener.get() < 0 ||
+        ::bind(listener.get(), reinterpret_cast<struct sockaddr*>(&address),
+               sizeof(address)) != 0 ||
+        ::listen(listener.get(), SOMAXCONN) != 0) {
+        std::cerr << "perun: error: could not listen on '" << socketPath
+                  << "': " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    // a client which went away must not kill the daemon
+    ::signal(SIGPIPE, SIG_IGN);
+
+    TreeCache treeCache{};
+    for (;;) {
+        FdGuard client(::accept4(listener.get(), nullptr, nullptr,
+                                 SOCK_CLOEXEC));
+        if (client.get() < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::cerr << "perun: error: daemon stopped: "
+                      << std::strerror(errno) << "\n";
+            ::unlink(socketPath.c_str());
+            return 1;
+        }
+
+        struct timeval timeout;
+        timeout.tv_sec = receiveTimeoutSeconds;
+        timeout.tv_usec = 0;
+        if (::setsockopt(client.get(), SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                         sizeof(timeout)) != 0) {
+            continue;
+        }
+
+        if (!serve(client.get(), treeCache)) {
+            break;
+        }
+    }
+
+    ::unlink(socketPath.c_str());
+    return 0;
+}
+
+int runClient(const std::string& socketPath,
+              const std::vector<std::string>& args) {
+    FdGuard daemon(connectTo(socketPath));
+    if (daemon.get() < 0) {
+        std::cerr << "perun: error: could not connect to the daemon at '"
+                  << socketPath << "'\n";
+        return 1;
+    }
+
+    char cwd[PATH_MAX];
+    if (::getcwd(cwd, sizeof(cwd)) == nullptr) {
+        std::cerr << "perun: error: could not get the working directory\n";
+        return 1;
+    }
+
+    std::string body{};
+    support::ByteWriter writer(body);
+    writer.writeVarint(protocolVersion);
+    writer.writeVarint(args.size());
+    for (auto&& arg : args) {
+        writer.writeString(arg);
+    }
+    writer.writeString(cwd);
+
+    // the daemon's output goes straight into our stdout and stderr,
+    // make sure ours is out first
+    std::cout.flush();
+    std::cerr.flush();
+
+    if (!sendHeader(daemon.get(), body.size()) ||
+        !writeAll(daemon.get(), body.data(), body.size())) {
+        std::cerr << "perun: error: could not send the request to the daemon\n";
+        return 1;
+    }
+
+    std::string response{};
+    char buffer[64];
+    ssize_t count;
+    while ((count = ::read(daemon.get(), buffer, sizeof(buffer))) != 0) {
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        response.append(buffer, count);
+    }
+
+    support::ByteReader reader(response.data(), response.size());
+    uint64_t status = reader.readVarint();
+    if (reader.failed() || response.empty()) {
+        std::cerr << "perun: error: the daemon closed the connection\n";
+        return 1;
+    }
+    return static_cast<int>(status);
+}
+
+} // namespace driver
+} // namespace perun
@@ -0,0 +1,29 @@
+#ifndef PERUN_DRIVER_DAEMON_HPP
+#define PERUN_DRIVER_DAEMON_HPP
+
+#include <string>
+#include <vector>
+
+namespace perun {
+namespace driver {
+
+/// Serves builds on the Unix domain socket 'socketPath'
+///
+/// The parsed trees are kept in a TreeCache between the builds,
+/// so rebuilding unchanged files costs a stat(2) per file.
+/// A client passes its stdout and stderr along with the arguments
+/// and its working directory, the daemon writes the dumps directly
+/// into the client's stdout and sends back the exit status.
+/// The builds are served one at a time (each of them runs on the pool).
+/// Runs until a client sends '--shutdown', returns the exit status.
+int runDaemon(const std::string& socketPath);
+
+/// Forwards 'args' to the daemon listening on 'socketPath'
+/// Returns the exit status of the build.
+int runClient(const std::string& socketPath,
+              const std::vector<std::string>& args);
+
+} // namespace driver
+} // namespace perun
+
+#endif // PERUN_DRIVER_DAEMON_HPP
@@ -1,15 +1,35 @@
 #include "driver.hpp"
 
+#include "cache.hpp"
 #include "error.hpp"
+#include "stats.hpp"
+#include "treecache.hpp"
 
+#include "../support/memory.hpp"
+#include "../support/optional.hpp"
+#include "../support/output.hpp"
+#include "../support/sourcebuffer.hpp"
+#include "../support/threadpool.hpp"
+#include "../support/timer.hpp"
+#include "../support/trace.hpp"
 #include "../support/util.hpp"
 
+#include "../ast/dumper.hpp"
 #include "../ast/printer.hpp"
 #include "../ast/tree.hpp"
+#include "../ast/visit.hpp"
 
 #include "../parser/parser.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+#include <sys/resource.h>
+#include <unistd.h>
 
 namespace perun {
 namespace driver {
@@ -23,8 +43,359 @@ static bool hasFlag(std::string flag, std::vector<std::string>& args) {
     return contains;
 }
 
-BuildResult build(std::vector<std::string>& args) {
+/// Removes an option in the form of '--name=value' and returns its value
+static support::Optional<std::string>
+getOption(std::string name, std::vector<std::string>& args) {
+    const std::string prefix = name + "=";
+    auto&& it =
+        std::find_if(args.begin(), args.end(), [&](const std::string& arg) {
+            return arg.compare(0, prefix.size(), prefix) == 0;
+        });
+    if (it == args.end()) {
+        return support::Optional<std::string>();
+    }
+
+    std::string value = it->substr(prefix.size());
+    args.erase(it);
+    return support::Optional<std::string>(std::move(value));
+}
+
+/// Parses 'value' as a decimal unsigned integer, returns false if invalid
+static bool parseUnsigned(const std::string& value, uint64_t& result) {
+    char* end = nullptr;
+    result = std::strtoull(value.c_str(), &end, 10);
+    return !value.empty() && *end == '\0';
+}
+
+/// Splits the contents of a response file into arguments
+/// Arguments are separated by whitespace, which can be kept in an argument
+/// by single or double quotes or escaped by a backslash (like in GCC).
+static std::vector<std::string>
+splitResponseFile(const std::string& contents) {
+    std::vector<std::string> args{};
+    std::string arg{};
+    bool inArg = false;
+    char quote = '\0';
+
+    for (size_t i = 0; i < contents.size(); ++i) {
+        char c = contents[i];
+        if (c == '\\' && i + 1 < contents.size()) {
+            arg += contents[++i];
+            inArg = true;
+        } else if (quote != '\0') {
+            if (c == quote) {
+                quote = '\0';
+            } else {
+                arg += c;
+            }
+        } else if (c == '\'' || c == '"') {
+            quote = c;
+            inArg = true;
+        } else if (std::isspace(static_cast<unsigned char>(c))) {
+            if (inArg) {
+                args.push_back(std::move(arg));
+                arg.clear();
+                inArg = false;
+            }
+        } else {
+            arg += c;
+            inArg = true;
+        }
+    }
+
+    if (inArg) {
+        args.push_back(std::move(arg));
+    }
+    return args;
+}
+
+/// Prefixes a relative 'path' by 'directory' unless it is empty
+static std::string resolvePath(const std::string& directory,
+                               const std::string& path) {
+    if (directory.empty() || path.empty() || path[0] == '/') {
+        return path;
+    }
+    return directory + "/" + path;
+}
+
+/// Replaces every '@file' argument by the arguments in 'file',
+/// see splitResponseFile, response files can refer to other response files
+static std::unique_ptr<DriverError>
+expandResponseFiles(std::vector<std::string>& args,
+                    const std::string& workingDirectory) {
+    // guards against response files which include themselves
+    constexpr size_t maxResponseFiles = 256;
+    size_t expanded = 0;
+
+    for (size_t i = 0; i < args.size();) {
+        if (args[i].empty() || args[i][0] != '@') {
+            ++i;
+            continue;
+        }
+
+        const std::string file = args[i].substr(1);
+        if (++expanded > maxResponseFiles) {
+            return std::make_unique<DriverError>(
+                "too many response files, is '" + file + "' recursive?");
+        }
+
+        std::string contents =
+            support::readFile(resolvePath(workingDirectory, file));
+        if (contents.empty()) {
+            return std::make_unique<DriverError>(
+                "could not load response file: '" + file + "'");
+        }
+
+        auto&& fileArgs = splitResponseFile(contents);
+
+        // expanded arguments are processed again, they can be '@file' too
+        args.erase(args.begin() + i);
+        args.insert(args.begin() + i, fileArgs.begin(), fileArgs.end());
+    }
+
+    return nullptr;
+}
+
+namespace {
+
+/// Phase timers of a single file, see Stats
+struct FileTimers {
+    support::Timer load;
+    support::Timer cache;
+    support::Timer lex;
+    support::Timer parse; // includes 'lex'
+};
+
+/// Result of building a single input file
+struct FileResult {
+    std::shared_ptr<ast::Tree> tree = nullptr;
+    std::unique_ptr<DriverError> error = nullptr;
+    bool cacheHit = false;
+    bool treeCacheHit = false;
+    FileTimers timers;
+};
+
+/// Records a trace from its construction on, the spans are dropped
+/// unless the recording is handed over to driver::finish, which writes
+/// them (a daemon would keep recording across requests otherwise)
+class TraceRecording {
+public:
+    explicit TraceRecording(bool active) : active(active) {
+        if (active) {
+            support::Tracer::start();
+        }
+    }
+    ~TraceRecording() {
+        if (active) {
+            support::Tracer::cancel();
+        }
+    }
+
+    TraceRecording(const TraceRecording&) = delete;
+    TraceRecording& operator=(const TraceRecording&) = delete;
+
+    void release() { active = false; }
+
+private:
+    bool active;
+};
+
+} // namespace
+
+/// Files smaller than this aren't worth a lexer thread with '--pipeline'
+static constexpr size_t pipelineMinBytes = 64 * 1024;
+
+/// Loads and parses a single file, safe to call from multiple threads
+/// The phases are timed only if 'timed' is set, the spans are recorded
+/// only if the support::Tracer is enabled.
+static FileResult buildFile(const std::string& file,
+                            std::shared_ptr<support::SourceManager> sm,
+                            const ParseCache* cache, TreeCache* treeCache,
+                            const std::string& workingDirectory, bool timed,
+                            bool pipelined) {
+    FileResult result{};
+    auto&& timer = [timed](support::Timer& t) { return timed ? &t : nullptr; };
+    auto&& timers = result.timers;
+
+    // 'file' is still used as the name in diagnostics
+    const std::string path = resolvePath(workingDirectory, file);
+
+    // an unchanged file is taken from the tree cache without loading it
+    std::string treeKey{};
+    FileStamp stamp{};
+    bool stamped = false;
+    if (treeCache != nullptr) {
+        support::TimerScope scope(timer(timers.cache));
+        support::TraceScope trace("tree cache", file);
+        treeKey = path;
+        stamped = FileStamp::get(path, stamp);
+        if (stamped) {
+            result.tree = treeCache->find(treeKey, stamp);
+            result.treeCacheHit = result.tree != nullptr;
+        }
+        if (result.treeCacheHit) {
+            return result;
+        }
+
+        // a cached tree must not keep the other files of the build alive
+        sm = std::make_shared<support::SourceManager>();
+    }
+
+    support::FileID fileID = support::SourceManager::invalidFileID;
+    {
+        support::TimerScope scope(timer(timers.load));
+        support::TraceScope trace("load", file);
+
+        // trees in the tree cache outlive the run, the file may be
+        // truncated by then, which a mapping would turn into SIGBUS
+        auto&& source =
+            support::SourceBuffer::getFile(path, treeCache == nullptr);
+        if (source == nullptr || source->getSize() == 0) {
+            result.error = std::make_unique<DriverError>(
+                "could not load file: '" + file + "'");
+            return result;
+        }
+
+        fileID = sm->addBuffer(file, std::move(source));
+        if (fileID == support::SourceManager::invalidFileID) {
+            result.error = std::make_unique<DriverError>(
+                "file is too large: '" + file + "'");
+            return result;
+        }
+    }
+
+    uint64_t hash = 0;
+    if (treeCache != nullptr && stamped) {
+        support::TimerScope scope(timer(timers.cache));
+        support::TraceScope trace("tree cache", file);
+        hash = TreeCache::getHash(sm->getBuffer(fileID));
+        result.tree =
+            treeCache->find(treeKey, stamp, sm->getBuffer(fileID), hash);
+        result.treeCacheHit = result.tree != nullptr;
+        if (result.treeCacheHit) {
+            return result;
+        }
+    }
+
+    uint64_t key = 0;
+    if (cache != nullptr) {
+        support::TimerScope scope(timer(timers.cache));
+        support::TraceScope trace("cache load", file);
+        support::MemoryScope memory(support::MemoryPhase::Cache);
+        key = cache->getKey(sm->getBuffer(fileID));
+        result.tree = cache->load(key, sm, fileID);
+        result.cacheHit = result.tree != nullptr;
+    }
+
+    if (result.tree == nullptr) {
+        {
+            support::TimerScope scope(timer(timers.parse));
+            // lexing is streamed by the parser, so its time is an argument
+            support::TraceScope trace("parse", file);
+            pipelined = pipelined &&
+                        sm->getBuffer(fileID).size() >= pipelineMinBytes;
+            result.tree =
+                ast::Tree::get(sm, fileID, timer(timers.lex), pipelined);
+            trace.setArg("lexMicros", static_cast<uint64_t>(
+                                          timers.lex.getSeconds() * 1e6));
+        }
+
+        if (cache != nullptr) {
+            support::TimerScope scope(timer(timers.cache));
+            support::TraceScope trace("cache store", file);
+            support::MemoryScope memory(support::MemoryPhase::Cache);
+            cache->store(key, *result.tree);
+        }
+    }
+    assert(result.tree != nullptr);
+
+    if (treeCache != nullptr && stamped) {
+        treeCache->insert(treeKey, stamp, hash, result.tree);
+    }
+
+    return result;
+}
+
+static size_t countNodes(const ast::Node& node) {
+    size_t count = 1;
+    ast::forEachChild(node, [&](const ast::Node& child) {
+        count += countNodes(child);
+    });
+    return count;
+}
+
+BuildResult build(std::vector<std::string>& args,
+                  const BuildContext& context) {
+    support::Timer wallTimer;
+    wallTimer.start();
+
+    if (auto&& error = expandResponseFiles(args, context.workingDirectory)) {
+        return BuildResult(std::move(error));
+    }
+
     bool verbose = hasFlag("--verbose", args) || hasFlag("-v", args);
+    bool printStats = hasFlag("--stats", args);
+    auto&& timeReportFormat = getOption("--time-report", args);
+    auto&& tracePath = getOption("--trace", args);
+    bool timeReport = hasFlag("--time-report", args) ||
+                      timeReportFormat.hasValue();
+    bool memoryReport = hasFlag("--memory-report", args);
+    // on a single core the lexer thread would only take turns
+    // with the parser
+    bool pipelined = hasFlag("--pipeline", args) &&
+                     std::thread::hardware_concurrency() > 1;
+    auto&& cacheDir = getOption("--cache-dir", args);
+    auto&& cacheSize = getOption("--cache-size", args);
+    auto&& errorLimit = getOption("--error-limit", args);
+    auto&& jobs = getOption("--jobs", args);
+    auto&& dumpAst = getOption("--dump-ast", args);
+    auto&& dumpTokensFormat = getOption("--dump-tokens", args);
+    bool dumpTokens = hasFlag("--dump-tokens", args) ||
+                      dumpTokensFormat.hasValue();
+
+    if (timeReportFormat.hasValue() && timeReportFormat.getValue() != "json" &&
+        timeReportFormat.getValue() != "table") {
+        return BuildResult(std::make_unique<DriverError>(
+            "invalid time report format '" + timeReportFormat.getValue() +
+            "', expected 'table' or 'json'"));
+    }
+
+    for (auto&& format : {&dumpAst, &dumpTokensFormat}) {
+        if (format->hasValue() && format->getValue() != "json" &&
+            format->getValue() != "binary") {
+            return BuildResult(std::make_unique<DriverError>(
+                "invalid dump format '" + format->getValue() +
+                "', expected 'json' or 'binary'"));
+        }
+    }
+
+    uint64_t maxErrors = parser::DiagnosticsEngine::defaultDisplayLimit;
+    if (errorLimit.hasValue() &&
+        !parseUnsigned(errorLimit.getValue(), maxErrors)) {
+        return BuildResult(std::make_unique<DriverError>(
+            "invalid error limit '" + errorLimit.getValue() + "'"));
+    }
+
+    uint64_t cacheMaxSize = ParseCache::defaultMaxSize;
+    if (cacheSize.hasValue() &&
+        !parseUnsigned(cacheSize.getValue(), cacheMaxSize)) {
+        return BuildResult(std::make_unique<DriverError>(
+            "invalid cache size '" + cacheSize.getValue() + "'"));
+    }
+
+    if (memoryReport && !support::MemoryTracker::isEnabled()) {
+        return BuildResult(std::make_unique<DriverError>(
+            "'--memory-report' needs perun built with "
+            "-DPERUN_MEMORY_TRACKING=ON"));
+    }
+
+    // 0 means sized to the machine
+    uint64_t threads = 0;
+    if (jobs.hasValue() &&
+        (!parseUnsigned(jobs.getValue(), threads) || threads == 0)) {
+        return BuildResult(std::make_unique<DriverError>(
+            "invalid number of jobs '" + jobs.getValue() + "'"));
+    }
 
     // process all remaining arguments - they should be all params and not flags
     for (auto&& arg : args) {
@@ -38,33 +409,230 @@ BuildResult build(std::vector<std::string>& args) {
         return BuildResult(std::make_unique<DriverError>("no input file"));
     }
 
-    if (args.size() != 1) {
+    if (tracePath.hasValue() && tracePath.getValue().empty()) {
         return BuildResult(
-            std::make_unique<DriverError>("only one input file allowed"));
+            std::make_unique<DriverError>("missing trace file path"));
     }
+    TraceRecording recording(tracePath.hasValue());
 
-    const std::string file = args[0];
+    std::unique_ptr<ParseCache> cache = nullptr;
+    if (cacheDir.hasValue()) {
+        cache = std::make_unique<ParseCache>(
+            resolvePath(context.workingDirectory, cacheDir.getValue()),
+            cacheMaxSize);
+    }
 
-    std::string source = support::readFile(file);
-    if (source.empty()) {
-        return BuildResult(std::make_unique<DriverError>(
-            "could not load file: '" + file + "'"));
+    // load, lex and parse every file on the pool,
+    // results are stored by input index to keep the output deterministic
+    auto&& sourceManager = std::make_shared<support::SourceManager>();
+    std::vector<FileResult> results(args.size());
+    // no more workers than files
+    if (threads == 0) {
+        threads = support::ThreadPool::getHardwareThreads();
+    }
+    support::ThreadPool pool(std::min<uint64_t>(threads, args.size()));
+    pool.parallelFor(args.size(), [&](size_t i) {
+        auto&& result = results[i];
+        result = buildFile(args[i], sourceManager, cache.get(),
+                           context.treeCache, context.workingDirectory,
+                           timeReport || tracePath.hasValue(), pipelined);
+
+        if (result.tree != nullptr) {
+            result.tree->getDiagnosticsMut().setDisplayLimit(maxErrors);
+        }
+    });
+
+    if (cache != nullptr) {
+        support::TraceScope trace("cache evict");
+        cache->evict();
+    }
+    if (context.treeCache != nullptr) {
+        context.treeCache->evict();
+    }
+
+    Stats stats{};
+    stats.files = args.size();
+    stats.threads = pool.getThreadCount();
+
+    std::vector<std::shared_ptr<ast::Tree>> trees{};
+    trees.reserve(results.size());
+    if (context.fileErrors != nullptr) {
+        context.fileErrors->clear();
+        context.fileErrors->resize(results.size());
+    }
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto&& result = results[i];
+        if (result.error != nullptr) {
+            // the first failure in the input order is reported
+            if (context.fileErrors == nullptr) {
+                return BuildResult(std::move(result.error));
+            }
+            (*context.fileErrors)[i] = std::move(result.error);
+            continue;
+        }
+
+        if (cache != nullptr) {
+            (result.cacheHit ? stats.cacheHits : stats.cacheMisses)++;
+        }
+        if (context.treeCache != nullptr) {
+            stats.treeCache = true;
+            (result.treeCacheHit ? stats.treeCacheHits
+                                 : stats.treeCacheMisses)++;
+        }
+
+        if (timeReport) {
+            auto&& timers = result.timers;
+            stats.loadSeconds += timers.load.getSeconds();
+            stats.cacheSeconds += timers.cache.getSeconds();
+            stats.lexSeconds += timers.lex.getSeconds();
+            stats.parseSeconds +=
+                timers.parse.getSeconds() - timers.lex.getSeconds();
+
+            auto&& tree = result.tree;
+            stats.sourceBytes += tree->getSource().size();
+            stats.tokens += tree->getTokens().size();
+            if (tree->getRoot() != nullptr) {
+                stats.nodes += countNodes(*tree->getRoot());
+            }
+        }
+
+        trees.push_back(std::move(result.tree));
+    }
+
+    if (verbose || dumpAst.hasValue() || dumpTokens) {
+        auto&& start = std::chrono::steady_clock::now();
+        support::MemoryScope memory(support::MemoryPhase::Printer);
+
+        support::OutputBuffer out(context.outFd);
+        for (auto&& tree : trees) {
+            // trees with errors are not printed
+            if (tree->hasErrors()) {
+                continue;
+            }
+
+            support::TraceScope trace("dump", tree->getFilename());
+            if (verbose) {
+                // print ast formatted
+                ast::Printer printer(out, 0);
+                printer.printRoot(*tree->getRoot());
+            }
+            if (dumpTokens) {
+                if (dumpTokensFormat.hasValue() &&
+                    dumpTokensFormat.getValue() == "binary") {
+                    ast::BinaryDumper(out).dumpTokens(tree->getTokens());
+                } else {
+                    ast::JsonDumper(out).dumpTokens(tree->getTokens());
+                }
+            }
+            if (dumpAst.hasValue()) {
+                if (dumpAst.getValue() == "binary") {
+                    ast::BinaryDumper(out).dumpRoot(*tree->getRoot());
+                } else {
+                    ast::JsonDumper(out).dumpRoot(*tree->getRoot());
+                }
+            }
+        }
+        out.flush();
+
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        stats.dumpBytes = out.getBytesWritten();
+        stats.dumpSeconds = elapsed.count();
     }
 
-    auto&& tree = ast::Tree::get(std::move(file), std::move(source));
-    assert(tree != nullptr);
+    wallTimer.stop();
+    stats.timed = timeReport;
+    stats.wallSeconds = wallTimer.getSeconds();
 
-    if (tree->hasErrors()) {
-        return BuildResult(std::move(tree));
+    ReportOptions reports{};
+    reports.stats = printStats;
+    reports.timeReport = timeReport;
+    reports.memoryReport = memoryReport;
+    reports.timeReportJSON =
+        timeReportFormat.hasValue() && timeReportFormat.getValue() == "json";
+    if (tracePath.hasValue()) {
+        reports.tracePath =
+            resolvePath(context.workingDirectory, tracePath.getValue());
     }
 
-    if (verbose) {
-        // print ast formatted
-        ast::Printer printer(std::cout, 0);
-        printer.printRoot(*tree->getRoot());
+    recording.release();
+    return BuildResult(std::move(trees), stats, reports);
+}
+
+bool finish(BuildResult& result, const BuildContext& context) {
+    auto&& stats = result.getStats();
+    auto&& reports = result.getReportOptions();
+
+    // teardown is a part of the wall time too
+    support::Timer teardownTimer;
+    {
+        support::TimerScope scope(&teardownTimer);
+        support::TraceScope trace("teardown");
+        result.destroyTrees();
+    }
+    stats.teardownSeconds = teardownTimer.getSeconds();
+    stats.wallSeconds += stats.teardownSeconds;
+
+    if (stats.timed) {
+        struct rusage usage;
+        if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+            // in kilobytes on Linux
+            stats.peakRSSKiB = usage.ru_maxrss;
+        }
+    }
+
+    auto&& err = *context.err;
+    if (reports.stats) {
+        stats.print(err);
+    }
+    if (reports.timeReport) {
+        stats.printTimeReport(err, reports.timeReportJSON);
+    }
+    if (reports.memoryReport) {
+        printMemoryReport(err);
+    }
+
+    if (!reports.tracePath.empty() &&
+        !support::Tracer::stop(reports.tracePath)) {
+        err << "perun: error: could not write trace: '"
+                  << reports.tracePath << "'\n";
+        return false;
+    }
+
+    return true;
+}
+
+int run(std::vector<std::string>& args, const BuildContext& context) {
+    auto&& err = *context.err;
+    auto&& result = build(args, context);
+
+    switch (result.getKind()) {
+    case BuildResult::Kind::Invalid: {
+        assert(false);
+    }
+    case BuildResult::Kind::DError: {
+        err << result.moveError()->getMessage();
+        return 1;
+    }
+    case BuildResult::Kind::Trees: {
+        // diagnostics are printed in the order of the inputs
+        int status = 0;
+        for (auto&& tree : result.getTrees()) {
+            assert(tree != nullptr);
+            if (tree->hasErrors()) {
+                tree->getDiagnostics().print(err, tree->getSourceManager());
+                status = 1;
+            }
+        }
+
+        if (!finish(result, context)) {
+            status = 1;
+        }
+        return status;
+    }
     }
 
-    return BuildResult(std::move(tree));
+    return 1;
 }
 
 } // namespace driver
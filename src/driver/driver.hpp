@@ -2,26 +2,66 @@
 #define PERUN_DRIVER_DRIVER_HPP
 
 #include "../driver/error.hpp"
+#include "../driver/stats.hpp"
 
 #include "../ast/tree.hpp"
 
 #include <cassert>
+#include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <unistd.h>
+
 namespace perun {
 namespace driver {
 
+/// Reports requested on the command line, printed by driver::finish
+struct ReportOptions {
+    bool stats = false;
+    bool timeReport = false;
+    bool timeReportJSON = false;
+    bool memoryReport = false;
+
+    // written by support::Tracer if not empty
+    std::string tracePath{};
+};
+
+class TreeCache;
+
+/// Where a build writes its output and what it can reuse
+/// The defaults are used by a plain 'perun' run, the daemon points
+/// the output at its client and keeps the trees in a TreeCache.
+struct BuildContext {
+    // dumps and '--verbose' output
+    int outFd = STDOUT_FILENO;
+    // diagnostics, errors and reports
+    std::ostream* err = &std::cerr;
+
+    // relative paths in the arguments are resolved against this directory,
+    // the process' own working directory is used if empty
+    std::string workingDirectory{};
+    TreeCache* treeCache = nullptr;
+
+    // if set, a file which can't be loaded doesn't fail the build,
+    // its error is stored here by input index and it has no tree
+    std::vector<std::unique_ptr<DriverError>>* fileErrors = nullptr;
+};
+
 struct BuildResult {
 public:
-    enum Kind { Invalid = 0, DError, Tree };
+    enum Kind { Invalid = 0, DError, Trees };
 
     explicit BuildResult(std::unique_ptr<DriverError>&& error)
-        : kind(Kind::DError), driverError(std::move(error)), tree(nullptr) {}
+        : kind(Kind::DError), driverError(std::move(error)), trees() {}
 
-    explicit BuildResult(std::unique_ptr<ast::Tree>&& tree)
-        : kind(Kind::Tree), driverError(nullptr), tree(std::move(tree)) {}
+    /// Trees are in the order of the input files,
+    /// see BuildContext::fileErrors for the ones left out
+    explicit BuildResult(std::vector<std::shared_ptr<ast::Tree>>&& trees,
+                         const Stats& stats, const ReportOptions& reports)
+        : kind(Kind::Trees), driverError(nullptr), trees(std::move(trees)),
+          stats(stats), reports(reports) {}
 
     Kind getKind() const { return kind; }
     std::unique_ptr<DriverError> moveError() {
@@ -29,18 +69,42 @@ public:
         return std::move(driverError);
     }
 
-    std::unique_ptr<ast::Tree> moveTree() {
-        assert(kind == Kind::Tree);
-        return std::move(tree);
+    const std::vector<std::shared_ptr<ast::Tree>>& getTrees() const {
+        assert(kind == Kind::Trees);
+        return trees;
     }
+    void destroyTrees() { trees.clear(); }
+
+    Stats& getStats() { return stats; }
+    const ReportOptions& getReportOptions() const { return reports; }
 
 private:
     Kind kind;
     std::unique_ptr<DriverError> driverError;
-    std::unique_ptr<ast::Tree> tree;
+    std::vector<std::shared_ptr<ast::Tree>> trees;
+
+    Stats stats{};
+    ReportOptions reports{};
 };
 
-BuildResult build(std::vector<std::string>& args);
+/// Parses all input files given in 'args' on a thread pool
+/// Arguments in the form of '@file' are replaced by the whitespace
+/// separated arguments in 'file'.
+BuildResult build(std::vector<std::string>& args,
+                  const BuildContext& context = BuildContext());
+
+/// Destroys the trees of a successful build (timing the teardown),
+/// prints the reports requested by '--stats', '--time-report'
+/// and '--memory-report' and writes the '--trace'
+/// Returns false if the trace couldn't be written.
+bool finish(BuildResult& result,
+            const BuildContext& context = BuildContext());
+
+/// Builds 'args', prints the errors and the diagnostics in the order
+/// of the inputs and finishes the build
+/// Returns the exit status of perun.
+int run(std::vector<std::string>& args,
+        const BuildContext& context = BuildContext());
 
 } // namespace driver
 } // namespace perun
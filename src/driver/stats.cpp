@@ -0,0 +1,146 @@
+#include "stats.hpp"
+
+#include <iomanip>
+#include <vector>
+
+#include "../ast/node.hpp"
+
+#include "../support/memory.hpp"
+
+namespace perun {
+namespace driver {
+
+void Stats::print(std::ostream& os) const {
+    os << "perun: stats:\n";
+    os << "  files:        " << files << " (" << threads << " threads)\n";
+    os << "  cache hits:   " << cacheHits << "\n";
+    os << "  cache misses: " << cacheMisses << "\n";
+    if (treeCache) {
+        os << "  tree cache:   " << treeCacheHits << " hits, "
+           << treeCacheMisses << " misses\n";
+    }
+
+    if (dumpBytes != 0) {
+        double mbPerSecond =
+            dumpSeconds > 0 ? dumpBytes / dumpSeconds / (1024 * 1024) : 0;
+        os << "  ast dump:     " << dumpBytes << " bytes in "
+           << dumpSeconds * 1000 << " ms (" << mbPerSecond << " MB/s)\n";
+    }
+}
+
+namespace {
+
+struct Phase {
+    const char* name;
+    double seconds;
+    size_t bytes; // throughput is computed from these
+};
+
+double perSecond(double amount, double seconds) {
+    return seconds > 0 ? amount / seconds : 0;
+}
+
+} // namespace
+
+void Stats::printTimeReport(std::ostream& os, bool json) const {
+    std::vector<Phase> phases{};
+    phases.push_back({"load", loadSeconds, sourceBytes});
+    if (cacheHits + cacheMisses != 0) {
+        phases.push_back({"cache", cacheSeconds, sourceBytes});
+    }
+    phases.push_back({"lex", lexSeconds, sourceBytes});
+    phases.push_back({"parse", parseSeconds, sourceBytes});
+    if (dumpBytes != 0) {
+        phases.push_back({"dump", dumpSeconds, dumpBytes});
+    }
+    phases.push_back({"teardown", teardownSeconds, sourceBytes});
+
+    const double mb = 1024 * 1024;
+
+    if (json) {
+        os << "{\"files\":" << files << ",\"threads\":" << threads
+           << ",\"sourceBytes\":" << sourceBytes << ",\"tokens\":" << tokens
+           << ",\"nodes\":" << nodes << ",\"peakRSSKiB\":" << peakRSSKiB
+           << ",\"wallSeconds\":" << wallSeconds << ",\"phases\":[";
+        for (size_t i = 0; i < phases.size(); ++i) {
+            auto&& phase = phases[i];
+            os << (i == 0 ? "" : ",") << "{\"name\":\"" << phase.name
+               << "\",\"seconds\":" << phase.seconds
+               << ",\"bytes\":" << phase.bytes << ",\"mbPerSecond\":"
+               << perSecond(phase.bytes / mb, phase.seconds)
+               << ",\"tokensPerSecond\":"
+               << perSecond(tokens, phase.seconds) << "}";
+        }
+        os << "]}\n";
+        return;
+    }
+
+    os << "perun: time report (" << files << " files, " << threads
+       << " threads";
+    if (threads > 1) {
+        os << ", phases summed over threads";
+    }
+    os << "):\n";
+    os << "  phase         time (ms)       MB/s    tokens/s\n";
+
+    os << std::fixed;
+    for (auto&& phase : phases) {
+        os << "  " << std::left << std::setw(10) << phase.name << std::right
+           << std::setprecision(2) << std::setw(13) << phase.seconds * 1000
+           << std::setw(11) << perSecond(phase.bytes / mb, phase.seconds)
+           << std::setprecision(0) << std::setw(12)
+           << perSecond(tokens, phase.seconds) << "\n";
+    }
+    os << "  " << std::left << std::setw(10) << "wall" << std::right
+       << std::setprecision(2) << std::setw(13) << wallSeconds * 1000 << "\n";
+    os << std::defaultfloat;
+
+    os << "  source: " << sourceBytes << " bytes, tokens: " << tokens
+       << ", nodes: " << nodes << ", peak RSS: " << peakRSSKiB << " KiB\n";
+}
+
+namespace {
+
+void printMemoryRow(std::ostream& os, const char* name,
+                    const support::MemoryTracker::Counters& counters) {
+    const double kib = 1024;
+    os << "  " << std::left << std::setw(18) << name << std::right
+       << std::setw(12) << counters.count << std::setprecision(1)
+       << std::setw(14) << counters.bytes / kib << std::setw(14)
+       << counters.peak / kib << "\n";
+}
+
+} // namespace
+
+void printMemoryReport(std::ostream& os) {
+    using support::MemoryPhase;
+    using support::MemoryTracker;
+
+    os << "perun: memory report:\n";
+    os << "  phase                   allocs     total KiB      peak KiB\n";
+    os << std::fixed;
+    for (size_t i = 0; i < MemoryTracker::phaseCount; ++i) {
+        auto&& phase = static_cast<MemoryPhase>(i);
+        printMemoryRow(os, support::getMemoryPhaseName(phase),
+                       MemoryTracker::get(phase));
+    }
+    printMemoryRow(os, "all", MemoryTracker::getTotal());
+
+    os << "  ast node kind\n";
+    const size_t kinds =
+        static_cast<size_t>(ast::Node::Kind::LiteralUndefined) + 1;
+    static_assert(static_cast<size_t>(ast::Node::Kind::LiteralUndefined) <
+                      MemoryTracker::detailCount,
+                  "node kinds must fit into the memory tracker details");
+    for (size_t i = 0; i < kinds; ++i) {
+        auto&& kind = static_cast<ast::Node::Kind>(i);
+        auto&& counters = MemoryTracker::get(MemoryPhase::AST, i);
+        if (counters.count != 0) {
+            printMemoryRow(os, ast::getNodeKindName(kind), counters);
+        }
+    }
+    os << std::defaultfloat;
+}
+
+} // namespace driver
+} // namespace perun
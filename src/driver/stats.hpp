@@ -0,0 +1,55 @@
+#ifndef PERUN_DRIVER_STATS_HPP
+#define PERUN_DRIVER_STATS_HPP
+
+#include <cstddef>
+#include <ostream>
+
+namespace perun {
+namespace driver {
+
+/// Counters reported by '--stats' and '--time-report'
+struct Stats {
+    size_t files = 0;
+    size_t threads = 0;
+
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+
+    // in-memory tree cache, only filled by the daemon
+    bool treeCache = false;
+    size_t treeCacheHits = 0;
+    size_t treeCacheMisses = 0;
+
+    // ast dump, only filled with '--verbose' or '--dump-*'
+    size_t dumpBytes = 0;
+    double dumpSeconds = 0;
+
+    // per-phase times, only filled with '--time-report'
+    // phases which run on the thread pool are summed over all files
+    bool timed = false;
+    double loadSeconds = 0;
+    double cacheSeconds = 0;
+    double lexSeconds = 0;
+    double parseSeconds = 0;
+    double teardownSeconds = 0;
+    double wallSeconds = 0;
+
+    size_t sourceBytes = 0;
+    size_t tokens = 0;
+    size_t nodes = 0;
+    long peakRSSKiB = 0;
+
+    void print(std::ostream& os) const;
+
+    /// Prints the per-phase times as a table or as JSON
+    void printTimeReport(std::ostream& os, bool json) const;
+};
+
+/// Prints the allocations per memory phase and per ast node kind
+/// (see support::MemoryTracker), counted over the whole process
+void printMemoryReport(std::ostream& os);
+
+} // namespace driver
+} // namespace perun
+
+#endif // PERUN_DRIVER_STATS_HPP
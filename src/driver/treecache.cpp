@@ -0,0 +1,101 @@
+#include "treecache.hpp"
+
+#include "../support/hash.hpp"
+
+#include <sys/stat.h>
+
+namespace perun {
+namespace driver {
+
+bool FileStamp::get(const std::string& path, FileStamp& stamp) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+
+    stamp.device = info.st_dev;
+    stamp.inode = info.st_ino;
+    stamp.size = info.st_size;
+    stamp.mtimeNanos = static_cast<uint64_t>(info.st_mtim.tv_sec) *
+                           1000000000 +
+                       info.st_mtim.tv_nsec;
+    return true;
+}
+
+uint64_t TreeCache::getHash(support::StringRef source) {
+    return support::hash64(source.data(), source.size());
+}
+
+void TreeCache::touch(Entry& entry) {
+    lru.splice(lru.begin(), lru, entry.lruPosition);
+}
+
+TreeCache::TreePtr TreeCache::find(const std::string& key,
+                                   const FileStamp& stamp) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto&& it = entries.find(key);
+    if (it == entries.end() || it->second.stamp != stamp) {
+        return nullptr;
+    }
+
+    touch(it->second);
+    return it->second.tree;
+}
+
+TreeCache::TreePtr TreeCache::find(const std::string& key,
+                                   const FileStamp& stamp,
+                                   support::StringRef source, uint64_t hash) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto&& it = entries.find(key);
+    // equal hashes don't prove equal contents
+    if (it == entries.end() || it->second.hash != hash ||
+        it->second.tree->getSource() != source) {
+        return nullptr;
+    }
+
+    it->second.stamp = stamp;
+    touch(it->second);
+    return it->second.tree;
+}
+
+void TreeCache::insert(const std::string& key, const FileStamp& stamp,
+                       uint64_t hash, TreePtr tree) {
+    std::lock_guard<std::mutex> lock(mutex);
+    remove(key);
+
+    sourceBytes += tree->getSource().size();
+    lru.push_front(key);
+    entries.emplace(key, Entry{stamp, hash, std::move(tree), lru.begin()});
+}
+
+void TreeCache::erase(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    remove(key);
+}
+
+void TreeCache::remove(const std::string& key) {
+    auto&& it = entries.find(key);
+    if (it != entries.end()) {
+        sourceBytes -= it->second.tree->getSource().size();
+        lru.erase(it->second.lruPosition);
+        entries.erase(it);
+    }
+}
+
+void TreeCache::evict() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (sourceBytes > maxSourceBytes && !lru.empty()) {
+        auto&& it = entries.find(lru.back());
+        sourceBytes -= it->second.tree->getSource().size();
+        entries.erase(it);
+        lru.pop_back();
+    }
+}
+
+size_t TreeCache::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+} // namespace driver
+} // namespace perun
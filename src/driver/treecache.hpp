@@ -0,0 +1,97 @@
+#ifndef PERUN_DRIVER_TREECACHE_HPP
+#define PERUN_DRIVER_TREECACHE_HPP
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../ast/tree.hpp"
+
+namespace perun {
+namespace driver {
+
+/// Identity of a file on disk as reported by stat(2)
+struct FileStamp {
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    uint64_t mtimeNanos = 0;
+
+    bool operator==(const FileStamp& other) const {
+        return device == other.device && inode == other.inode &&
+               size == other.size && mtimeNanos == other.mtimeNanos;
+    }
+    bool operator!=(const FileStamp& other) const { return !(*this == other); }
+
+    /// Returns false if the file can't be stat-ed
+    static bool get(const std::string& path, FileStamp& stamp);
+};
+
+/// In-memory cache of parsed trees, kept by the daemon between builds
+///
+/// Entries are keyed by the absolute path of the file. An unchanged stamp
+/// is trusted without reading the file, a changed one falls back to
+/// comparing the contents (e.g. after a 'touch' or a checkout which
+/// didn't change the file), the hash only rules out most mismatches.
+/// Every cached tree owns its own SourceManager, so an entry can be
+/// dropped independently of the others.
+/// The least recently used entries are evicted once the cached sources
+/// don't fit into 'maxSourceBytes' (the trees are ~25x larger).
+/// All methods are thread-safe.
+class TreeCache {
+public:
+    using TreePtr = std::shared_ptr<ast::Tree>;
+
+    explicit TreeCache(uint64_t maxSourceBytes = defaultMaxSourceBytes)
+        : maxSourceBytes(maxSourceBytes) {}
+
+    /// Returns the tree of 'key' if the file still has 'stamp'
+    TreePtr find(const std::string& key, const FileStamp& stamp);
+
+    /// Returns the tree of 'key' if its source equals 'source'
+    /// and refreshes the stored stamp, 'hash' is the hash of 'source'
+    TreePtr find(const std::string& key, const FileStamp& stamp,
+                 support::StringRef source, uint64_t hash);
+
+    void insert(const std::string& key, const FileStamp& stamp, uint64_t hash,
+                TreePtr tree);
+
+    /// Drops the entry of 'key' if there is one
+    void erase(const std::string& key);
+
+    /// Drops the least recently used entries over the limit
+    void evict();
+
+    size_t getEntryCount() const;
+
+    static uint64_t getHash(support::StringRef source);
+
+    static constexpr uint64_t defaultMaxSourceBytes = 64 * 1024 * 1024;
+
+private:
+    struct Entry {
+        FileStamp stamp;
+        uint64_t hash;
+        TreePtr tree;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    // these expect the mutex to be held
+    void touch(Entry& entry);
+    void remove(const std::string& key);
+
+    const uint64_t maxSourceBytes;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    std::list<std::string> lru; // the most recently used first
+    uint64_t sourceBytes = 0;
+};
+
+} // namespace driver
+} // namespace perun
+
+#endif // PERUN_DRIVER_TREECACHE_HPP
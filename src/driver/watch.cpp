@@ -0,0 +1,329 @@
+#include "watch.hpp"
+
+#include "driver.hpp"
+#include "treecache.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace perun {
+namespace driver {
+
+namespace {
+
+/// Events arriving within this window are coalesced into one rebuild
+constexpr int coalesceMillis = 50;
+
+constexpr uint32_t directoryEvents = IN_CLOSE_WRITE | IN_MOVED_TO |
+                                     IN_MOVED_FROM | IN_CREATE | IN_DELETE |
+                                     IN_ONLYDIR;
+
+bool isSourceFile(const std::string& name) {
+    const std::string extension = ".per";
+    return name.size() > extension.size() &&
+           name.compare(name.size() - extension.size(), extension.size(),
+                        extension) == 0;
+}
+
+bool isRegularFile(const std::string& path) {
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode);
+}
+
+class Watcher {
+public:
+    Watcher(std::string directory, std::vector<std::string> options)
+        : directory(std::move(directory)), options(std::move(options)) {}
+
+    ~Watcher() {
+        if (inotifyFd >= 0) {
+            ::close(inotifyFd);
+        }
+    }
+
+    int run();
+
+private:
+    /// Watches 'path' and its subdirectories, adds their sources to 'found'
+    void addDirectory(const std::string& path, std::set<std::string>& found);
+
+    /// Waits for events at most 'timeout' ms (-1 waits forever),
+    /// returns false on a timeout
+    bool waitForEvents(int timeout);
+
+    /// Collects the files touched by the pending events into 'changed'
+    void readEvents(std::set<std::string>& changed, bool& rescan);
+
+    /// Rebuilds 'changed' and prints the diagnostics which changed,
+    /// a file which can't be loaded reports that as its diagnostics
+    /// Returns false if the build is invalid (e.g. a bad option).
+    bool rebuild(const std::set<std::string>& changed);
+
+    const std::string directory;
+    const std::vector<std::string> options;
+
+    int inotifyFd = -1;
+    std::unordered_map<int, std::string> directories{}; // by watch descriptor
+    std::set<std::string> files{};
+
+    // the last printed diagnostics, only files with errors are present
+    std::unordered_map<std::string, std::string> diagnostics{};
+
+    std::string workingDirectory{};
+    // everything stays cached, the watched tree is the working set
+    TreeCache treeCache{UINT64_MAX};
+};
+
+void Watcher::addDirectory(const std::string& path,
+                           std::set<std::string>& found) {
+    int wd = ::inotify_add_watch(inotifyFd, path.c_str(), directoryEvents);
+    if (wd < 0) {
+        std::cerr << "perun: warning: could not watch '" << path
+                  << "': " << std::strerror(errno) << "\n";
+        return;
+    }
+    directories[wd] = path;
+
+    DIR* dir = ::opendir(path.c_str());
+    if (dir == nullptr) {
+        return;
+    }
+    while (struct dirent* entry = ::readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+
+        const std::string child = path + "/" + name;
+        unsigned char type = entry->d_type;
+        if (type == DT_UNKNOWN) {
+            struct stat info;
+            if (::lstat(child.c_str(), &info) != 0) {
+                continue;
+            }
+            type = S_ISDIR(info.st_mode) ? DT_DIR
+                                         : S_ISREG(info.st_mode) ? DT_REG
+                                                                 : DT_UNKNOWN;
+        }
+
+        // symlinked directories aren't followed, they could form a cycle
+        if (type == DT_DIR) {
+            addDirectory(child, found);
+        } else if (isSourceFile(name) && isRegularFile(child)) {
+            found.insert(child);
+        }
+    }
+    ::closedir(dir);
+}
+
+bool Watcher::waitForEvents(int timeout) {
+    struct pollfd fd;
+    fd.fd = inotifyFd;
+    fd.events = POLLIN;
+    for (;;) {
+        int ready = ::poll(&fd, 1, timeout);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        return ready > 0;
+    }
+}
+
+void Watcher::readEvents(std::set<std::string>& changed, bool& rescan) {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length < 0 && errno == EINTR) {
+            continue;
+        }
+        if (length <= 0) {
+            return;
+        }
+
+        for (char* pos = buffer; pos < buffer + length;) {
+            auto&& event = *reinterpret_cast<struct inotify_event*>(pos);
+            pos += sizeof(struct inotify_event) + event.len;
+
+            if ((event.mask & IN_Q_OVERFLOW) != 0) {
+                rescan = true;
+                continue;
+            }
+
+            auto&& it = directories.find(event.wd);
+            if (it == directories.end()) {
+                continue;
+            }
+            if ((event.mask & IN_IGNORED) != 0) {
+                directories.erase(it);
+                continue;
+            }
+
+            const std::string name = event.len > 0 ? event.name : "";
+            const std::string path = it->second + "/" + name;
+            if ((event.mask & IN_ISDIR) == 0) {
+                if (isSourceFile(name)) {
+                    changed.insert(path);
+                }
+            } else if ((event.mask & (IN_CREATE | IN_MOVED_TO)) != 0) {
+                addDirectory(path, changed);
+            } else if ((event.mask & (IN_DELETE | IN_MOVED_FROM)) != 0) {
+                // the files under it are found missing by the rebuild
+                const std::string prefix = path + "/";
+                for (auto&& file = files.lower_bound(prefix);
+                     file != files.end() &&
+                     file->compare(0, prefix.size(), prefix) == 0;
+                     ++file) {
+                    changed.insert(*file);
+                }
+            }
+        }
+    }
+}
+
+bool Watcher::rebuild(const std::set<std::string>& changed) {
+    std::vector<std::string> inputs{};
+    for (auto&& file : changed) {
+        if (isRegularFile(file)) {
+            files.insert(file);
+            inputs.push_back(file);
+            continue;
+        }
+
+        files.erase(file);
+        treeCache.erase(file[0] == '/' ? file : workingDirectory + "/" + file);
+        if (diagnostics.erase(file) != 0) {
+            std::cerr << "perun: '" << file << "' was removed\n";
+        }
+    }
+    if (inputs.empty()) {
+        return true;
+    }
+
+    std::vector<std::string> args = options;
+    args.insert(args.end(), inputs.begin(), inputs.end());
+
+    std::vector<std::unique_ptr<DriverError>> fileErrors{};
+    BuildContext context{};
+    context.workingDirectory = workingDirectory;
+    context.treeCache = &treeCache;
+    context.fileErrors = &fileErrors;
+    auto&& result = build(args, context);
+
+    switch (result.getKind()) {
+    case BuildResult::Kind::Invalid: {
+        assert(false);
+    }
+    case BuildResult::Kind::DError: {
+        std::cerr << result.moveError()->getMessage();
+        return false;
+    }
+    case BuildResult::Kind::Trees: {
+        // trees are in the order of the inputs, without the files
+        // which couldn't be loaded
+        auto&& trees = result.getTrees();
+        size_t next = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            std::ostringstream text{};
+            if (fileErrors[i] != nullptr) {
+                text << fileErrors[i]->getMessage();
+            } else {
+                auto&& tree = trees[next++];
+                if (tree->hasErrors()) {
+                    tree->getDiagnostics().print(text,
+                                                 tree->getSourceManager());
+                }
+            }
+
+            auto&& last = diagnostics.find(inputs[i]);
+            if (text.tellp() == 0) {
+                if (last != diagnostics.end()) {
+                    std::cerr << "perun: '" << inputs[i]
+                              << "' has no errors now\n";
+                    diagnostics.erase(last);
+                }
+            } else if (last == diagnostics.end() ||
+                       last->second != text.str()) {
+                std::cerr << text.str();
+                diagnostics[inputs[i]] = text.str();
+            }
+        }
+        finish(result, context);
+        return true;
+    }
+    }
+
+    return false;
+}
+
+int Watcher::run() {
+    for (auto&& option : options) {
+        if (option.empty() || option[0] != '-') {
+            std::cerr << "perun: error: '--watch' takes no inputs, got '"
+                      << option << "'\n";
+            return 1;
+        }
+    }
+
+    char cwd[PATH_MAX];
+    if (::getcwd(cwd, sizeof(cwd)) == nullptr) {
+        std::cerr << "perun: error: could not get the working directory\n";
+        return 1;
+    }
+    workingDirectory = cwd;
+
+    inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        std::cerr << "perun: error: could not start watching: "
+                  << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::set<std::string> changed{};
+    addDirectory(directory, changed);
+    if (directories.empty()) {
+        return 1;
+    }
+
+    // an invalid command line is reported once and not retried
+    if (!rebuild(changed)) {
+        return 1;
+    }
+
+    for (;;) {
+        waitForEvents(-1);
+
+        changed.clear();
+        bool rescan = false;
+        do {
+            readEvents(changed, rescan);
+        } while (waitForEvents(coalesceMillis));
+
+        if (rescan) {
+            // events were lost, anything could have changed
+            changed = files;
+            addDirectory(directory, changed);
+        }
+        rebuild(changed);
+    }
+}
+
+} // namespace
+
+int runWatch(const std::string& directory,
+             const std::vector<std::string>& options) {
+    return Watcher(directory, options).run();
+}
+
+} // namespace driver
+} // namespace perun
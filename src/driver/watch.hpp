@@ -0,0 +1,24 @@
+#ifndef PERUN_DRIVER_WATCH_HPP
+#define PERUN_DRIVER_WATCH_HPP
+
+#include <string>
+#include <vector>
+
+namespace perun {
+namespace driver {
+
+/// Builds every '.per' file under 'directory' and rebuilds them as they change
+///
+/// The directory tree is watched with inotify, bursts of events
+/// (e.g. an editor's save or a checkout) are coalesced into one rebuild
+/// of just the changed files, the trees of the others stay in memory.
+/// The diagnostics of a file are printed only when they differ
+/// from the last printed ones. 'options' are passed to every build.
+/// Runs until killed, returns the exit status if watching fails.
+int runWatch(const std::string& directory,
+             const std::vector<std::string>& options);
+
+} // namespace driver
+} // namespace perun
+
+#endif // PERUN_DRIVER_WATCH_HPP
@@ -0,0 +1,121 @@
+#include "document.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace perun {
+namespace lsp {
+
+namespace {
+
+/// Number of UTF-16 code units taken by a character with this lead byte
+size_t getUTF16Length(unsigned char lead) { return lead >= 0xF0 ? 2 : 1; }
+
+/// Continuation bytes don't start a character
+bool isContinuationByte(unsigned char c) { return (c & 0xC0) == 0x80; }
+
+} // namespace
+
+Document::Document(std::string uri, int64_t version, std::string text)
+    : uri(std::move(uri)), version(version), text(std::move(text)),
+      lineStarts{0} {
+    updateLineStarts(0);
+}
+
+void Document::updateLineStarts(size_t fromLine) {
+    assert(fromLine < lineStarts.size());
+    lineStarts.resize(fromLine + 1);
+
+    const char* data = text.data();
+    const char* end = data + text.size();
+    const char* pos = data + lineStarts.back();
+    while (auto&& newline = static_cast<const char*>(
+               std::memchr(pos, '\n', end - pos))) {
+        pos = newline + 1;
+        lineStarts.push_back(pos - data);
+    }
+}
+
+size_t Document::getOffset(Position position) const {
+    if (position.line >= lineStarts.size()) {
+        return text.size();
+    }
+
+    size_t lineEnd = text.size();
+    if (position.line + 1 < lineStarts.size()) {
+        lineEnd = lineStarts[position.line + 1] - 1;
+    }
+
+    size_t offset = lineStarts[position.line];
+    for (uint32_t units = 0; offset < lineEnd && units < position.character;) {
+        units += getUTF16Length(static_cast<unsigned char>(text[offset]));
+        ++offset;
+        while (offset < lineEnd &&
+               isContinuationByte(static_cast<unsigned char>(text[offset]))) {
+            ++offset;
+        }
+    }
+    return offset;
+}
+
+Position Document::getPosition(size_t offset) const {
+    offset = std::min(offset, text.size());
+
+    // last line which starts before or at the offset
+    auto&& it = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+    size_t line = it - lineStarts.begin() - 1;
+
+    uint32_t character = 0;
+    for (size_t i = lineStarts[line]; i < offset; ++i) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (!isContinuationByte(c)) {
+            character += getUTF16Length(c);
+        }
+    }
+    return Position{static_cast<uint32_t>(line), character};
+}
+
+void Document::applyChange(Position start, Position end,
+                           support::StringRef newText) {
+    size_t startOffset = getOffset(start);
+    size_t endOffset = std::max(startOffset, getOffset(end));
+
+    text.replace(startOffset, endOffset - startOffset, newText.data(),
+                 newText.size());
+    // lines before the edit keep their starts
+    updateLineStarts(std::min<size_t>(start.line, lineStarts.size() - 1));
+
+    const ast::SourceEdit next{startOffset, endOffset - startOffset,
+                               newText.size()};
+    edit = dirty ? ast::mergeEdits(edit, next) : next;
+    dirty = true;
+}
+
+void Document::setText(std::string newText) {
+    text = std::move(newText);
+    updateLineStarts(0);
+    replaced = true;
+    dirty = true;
+}
+
+const ast::Tree& Document::getTree() {
+    if (dirty || tree == nullptr) {
+        // every parse gets a fresh manager, the old buffers are not needed
+        auto&& sourceManager = std::make_shared<support::SourceManager>();
+        support::FileID file = sourceManager->addBuffer(uri, text);
+        if (tree != nullptr && !replaced) {
+            tree = ast::Tree::reparse(std::move(tree), sourceManager, file,
+                                      edit);
+        } else {
+            tree = ast::Tree::get(sourceManager, file);
+        }
+        tree->getDiagnosticsMut().setDisplayLimit(0);
+        replaced = false;
+        dirty = false;
+    }
+    return *tree;
+}
+
+} // namespace lsp
+} // namespace perun
@@ -0,0 +1,80 @@
+#ifndef PERUN_LSP_DOCUMENT_HPP
+#define PERUN_LSP_DOCUMENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../ast/tree.hpp"
+
+#include "../support/stringref.hpp"
+
+namespace perun {
+namespace lsp {
+
+/// Position in the LSP sense -- 0-indexed line and a column
+/// counted in UTF-16 code units
+struct Position {
+    uint32_t line;
+    uint32_t character;
+};
+
+/// Text of an open document together with its last parse
+///
+/// Edits only update the text and its line table, the text is parsed
+/// lazily by 'getTree', so a burst of keystrokes costs a single parse.
+/// The edits since the last parse are merged into one, which is reparsed
+/// incrementally, see ast::Tree::reparse.
+class Document {
+public:
+    Document(std::string uri, int64_t version, std::string text);
+
+    const std::string& getURI() const { return uri; }
+
+    int64_t getVersion() const { return version; }
+    void setVersion(int64_t v) { version = v; }
+
+    const std::string& getText() const { return text; }
+
+    /// Replaces the text between 'start' and 'end' by 'newText'
+    /// Positions out of the line or the document are clamped.
+    void applyChange(Position start, Position end, support::StringRef newText);
+
+    /// Replaces the whole text
+    void setText(std::string newText);
+
+    /// True if the text changed since the last 'getTree'
+    bool isDirty() const { return dirty; }
+
+    /// Parses the text if it changed, the tree is valid until the next call
+    const ast::Tree& getTree();
+
+    size_t getOffset(Position position) const;
+    Position getPosition(size_t offset) const;
+
+private:
+    /// Rebuilds the line table from the line 'fromLine' onwards
+    void updateLineStarts(size_t fromLine);
+
+    std::string uri;
+    int64_t version;
+    std::string text;
+
+    // offsets of the first characters of all lines
+    std::vector<size_t> lineStarts;
+
+    std::unique_ptr<ast::Tree> tree = nullptr;
+    bool dirty = true;
+
+    // the text changed since the parse of 'tree' by 'edit' unless
+    // it was replaced as a whole
+    ast::SourceEdit edit{};
+    bool replaced = false;
+};
+
+} // namespace lsp
+} // namespace perun
+
+#endif // PERUN_LSP_DOCUMENT_HPP
@@ -0,0 +1,162 @@
+#include "server.hpp"
+
+#include "../support/json.hpp"
+#include "../support/output.hpp"
+#include "../support/util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace perun;
+
+static void printUsage() {
+    std::cout << "Usage: perun-lsp [-h/--help]\n"
+                 "       perun-lsp --bench=<file> [--keystrokes=<n>]\n"
+                 "Speaks the Language Server Protocol on stdin and stdout."
+              << std::endl;
+}
+
+namespace {
+
+/// Latencies of a single kind of message in milliseconds
+struct Samples {
+    std::vector<double> millis;
+
+    void print(const char* name) {
+        std::sort(millis.begin(), millis.end());
+        auto&& at = [this](double quantile) {
+            return millis[static_cast<size_t>(quantile * (millis.size() - 1))];
+        };
+        std::cout << "  " << std::left << std::setw(13) << name << std::right
+                  << std::fixed << std::setprecision(3) << "p50 "
+                  << std::setw(9) << at(0.5) << " ms  p95 " << std::setw(9)
+                  << at(0.95) << " ms  max " << std::setw(9)
+                  << millis.back() << " ms\n"
+                  << std::defaultfloat;
+    }
+};
+
+template <typename F> double timeMillis(F&& f) {
+    auto&& start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+} // namespace
+
+/// Replays typing into 'file' through the server in-process
+/// Every keystroke inserts a character which the next one deletes again,
+/// the responses are written into /dev/null.
+static int runBench(const std::string& file, size_t keystrokes) {
+    const std::string text = support::readFile(file);
+    if (text.empty()) {
+        std::cerr << "perun-lsp: error: could not load file: '" << file
+                  << "'\n";
+        return 1;
+    }
+    const size_t lines = std::count(text.begin(), text.end(), '\n') + 1;
+
+    int null = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    lsp::Server server(-1, null);
+
+    auto&& message = [](const std::string& method, const std::string& params,
+                        int id = -1) {
+        std::string body = "{\"jsonrpc\":\"2.0\",";
+        if (id >= 0) {
+            body += "\"id\":" + std::to_string(id) + ",";
+        }
+        return body + "\"method\":\"" + method + "\",\"params\":" + params +
+               "}";
+    };
+    const std::string document = "{\"uri\":\"file:///bench.per\"";
+
+    support::OutputBuffer escaped{};
+    support::writeJSONString(escaped, text);
+    Samples open{};
+    open.millis.push_back(timeMillis([&]() {
+        server.handleMessage(message("initialize", "{}", 0));
+        server.handleMessage(message(
+            "textDocument/didOpen", "{\"textDocument\":" + document +
+                                        ",\"version\":0,\"languageId\":"
+                                        "\"perun\",\"text\":" +
+                                        escaped.getData() + "}}"));
+        server.publishDiagnostics();
+    }));
+
+    Samples edit{};
+    Samples diagnostics{};
+    Samples symbols{};
+    for (size_t i = 0; i < keystrokes; ++i) {
+        // spread over the document, the pairs hit the same position
+        const size_t line = (i / 2) * 7919 % lines;
+        const std::string position =
+            "{\"line\":" + std::to_string(line) + ",\"character\":0}";
+        const std::string end =
+            "{\"line\":" + std::to_string(line) +
+            (i % 2 == 0 ? ",\"character\":0}" : ",\"character\":1}");
+        const std::string change =
+            message("textDocument/didChange",
+                    "{\"textDocument\":" + document + ",\"version\":" +
+                        std::to_string(i + 1) +
+                        "},\"contentChanges\":[{\"range\":{\"start\":" +
+                        position + ",\"end\":" + end + "},\"text\":\"" +
+                        (i % 2 == 0 ? "x" : "") + "\"}]}");
+
+        edit.millis.push_back(
+            timeMillis([&]() { server.handleMessage(change); }));
+        diagnostics.millis.push_back(
+            timeMillis([&]() { server.publishDiagnostics(); }));
+        symbols.millis.push_back(timeMillis([&]() {
+            server.handleMessage(
+                message("textDocument/documentSymbol",
+                        "{\"textDocument\":" + document + "}}", 1));
+        }));
+    }
+
+    std::cout << "perun-lsp: bench: " << lines << " lines, " << text.size()
+              << " bytes, " << keystrokes << " keystrokes\n";
+    open.print("open");
+    edit.print("edit");
+    diagnostics.print("diagnostics");
+    symbols.print("symbols");
+
+    ::close(null);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    std::string benchFile{};
+    size_t keystrokes = 200;
+    for (auto&& arg : args) {
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        } else if (arg.compare(0, 8, "--bench=") == 0) {
+            benchFile = arg.substr(8);
+        } else if (arg.compare(0, 13, "--keystrokes=") == 0) {
+            keystrokes = std::strtoull(arg.c_str() + 13, nullptr, 10);
+        } else {
+            std::cerr << "perun-lsp: error: unsupported option '" << arg
+                      << "'\n";
+            return 1;
+        }
+    }
+
+    if (!benchFile.empty()) {
+        return runBench(benchFile, std::max<size_t>(keystrokes, 1));
+    }
+
+    return lsp::Server(STDIN_FILENO, STDOUT_FILENO).run();
+}
@@ -0,0 +1,433 @@
+#include "server.hpp"
+
+#include "../ast/expr.hpp"
+#include "../ast/node.hpp"
+#include "../ast/stmt.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace perun {
+namespace lsp {
+
+using support::JSONValue;
+using support::OutputBuffer;
+
+namespace {
+
+// JSON-RPC and LSP error codes
+constexpr int parseError = -32700;
+constexpr int invalidRequest = -32600;
+constexpr int methodNotFound = -32601;
+
+// LSP enums
+constexpr int textDocumentSyncIncremental = 2;
+constexpr int severityError = 1;
+constexpr int symbolFunction = 12;
+constexpr int symbolVariable = 13;
+constexpr int symbolConstant = 14;
+
+/// The input buffer is compacted once this many bytes were handled
+constexpr size_t compactThreshold = 1024 * 1024;
+
+Position getPosition(const JSONValue& position) {
+    return Position{
+        static_cast<uint32_t>(position.get("line").getInteger()),
+        static_cast<uint32_t>(position.get("character").getInteger())};
+}
+
+void writePosition(OutputBuffer& out, Position position) {
+    out << "{\"line\":" << static_cast<uint64_t>(position.line)
+        << ",\"character\":" << static_cast<uint64_t>(position.character)
+        << '}';
+}
+
+void writeRange(OutputBuffer& out, const Document& document, size_t start,
+                size_t end) {
+    out << "{\"start\":";
+    writePosition(out, document.getPosition(start));
+    out << ",\"end\":";
+    writePosition(out, document.getPosition(end));
+    out << '}';
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+/// Returns the value of the Content-Length header, -1 if there's none
+long getContentLength(support::StringRef header) {
+    const support::StringRef name = "content-length:";
+    for (size_t lineStart = 0; lineStart < header.size();) {
+        size_t lineEnd = lineStart;
+        while (lineEnd < header.size() && header[lineEnd] != '\r') {
+            ++lineEnd;
+        }
+
+        auto&& line = header.substr(lineStart, lineEnd - lineStart);
+        bool matches = line.size() > name.size();
+        for (size_t i = 0; matches && i < name.size(); ++i) {
+            char c = line[i];
+            matches = (c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c) == name[i];
+        }
+        if (matches) {
+            return std::strtol(line.substr(name.size()).str().c_str(),
+                               nullptr, 10);
+        }
+
+        lineStart = lineEnd + 2; // skips "\r\n"
+    }
+    return -1;
+}
+
+} // namespace
+
+int Server::run() {
+    std::string body{};
+    for (;;) {
+        if (!unpublished.empty() && !hasPendingInput()) {
+            publishDiagnostics();
+        }
+
+        if (!readMessage(body)) {
+            // the client went away without 'exit'
+            return 1;
+        }
+        handleMessage(body);
+
+        if (exitRequested) {
+            return shutdownRequested ? 0 : 1;
+        }
+    }
+}
+
+bool Server::hasPendingInput() {
+    if (inputPos < input.size()) {
+        return true;
+    }
+
+    struct pollfd fd;
+    fd.fd = inFd;
+    fd.events = POLLIN;
+    return ::poll(&fd, 1, 0) > 0;
+}
+
+bool Server::readMessage(std::string& body) {
+    for (;;) {
+        // the header is separated by an empty line
+        size_t headerEnd = input.find("\r\n\r\n", inputPos);
+        if (headerEnd != std::string::npos) {
+            long length = getContentLength(support::StringRef(input).substr(
+                inputPos, headerEnd - inputPos));
+            size_t bodyStart = headerEnd + 4;
+
+            if (length < 0) {
+                // a malformed header is skipped
+                inputPos = bodyStart;
+                continue;
+            }
+            if (bodyStart + length <= input.size()) {
+                body.assign(input, bodyStart, length);
+                inputPos = bodyStart + length;
+
+                if (inputPos == input.size()) {
+                    input.clear();
+                    inputPos = 0;
+                } else if (inputPos >= compactThreshold) {
+                    input.erase(0, inputPos);
+                    inputPos = 0;
+                }
+                return true;
+            }
+        }
+
+        char buffer[64 * 1024];
+        ssize_t count = ::read(inFd, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        input.append(buffer, count);
+    }
+}
+
+void Server::send(const OutputBuffer& body) {
+    auto&& data = body.getData();
+    const std::string header =
+        "Content-Length: " + std::to_string(data.size()) + "\r\n\r\n";
+    writeAll(outFd, header.data(), header.size());
+    writeAll(outFd, data.data(), data.size());
+}
+
+void Server::sendResult(const JSONValue& id, const OutputBuffer& result) {
+    OutputBuffer out{};
+    out << "{\"jsonrpc\":\"2.0\",\"id\":";
+    id.write(out);
+    out << ",\"result\":" << result.getData() << '}';
+    send(out);
+}
+
+void Server::sendError(const JSONValue& id, int code,
+                       const std::string& message) {
+    OutputBuffer out{};
+    out << "{\"jsonrpc\":\"2.0\",\"id\":";
+    id.write(out);
+    out << ",\"error\":{\"code\":" << (code < 0 ? "-" : "")
+        << static_cast<uint64_t>(code < 0 ? -code : code)
+        << ",\"message\":";
+    support::writeJSONString(out, message);
+    out << "}}";
+    send(out);
+}
+
+void Server::handleMessage(support::StringRef body) {
+    JSONValue message{};
+    if (!JSONValue::parse(body, message) ||
+        !message.is(JSONValue::Kind::Object)) {
+        sendError(JSONValue(), parseError, "malformed message");
+        return;
+    }
+
+    auto&& method = message.get("method").getString();
+    auto&& id = message.get("id");
+    auto&& params = message.get("params");
+
+    if (method.empty()) {
+        // responses to our requests, we don't send any
+        return;
+    }
+    if (id.is(JSONValue::Kind::Null)) {
+        handleNotification(method, params);
+    } else {
+        handleRequest(method, id, params);
+    }
+}
+
+void Server::handleRequest(const std::string& method, const JSONValue& id,
+                           const JSONValue& params) {
+    if (shutdownRequested) {
+        sendError(id, invalidRequest, "the server is shutting down");
+        return;
+    }
+
+    if (method == "initialize") {
+        OutputBuffer result{};
+        result << "{\"capabilities\":{\"textDocumentSync\":{"
+               << "\"openClose\":true,\"change\":"
+               << static_cast<uint64_t>(textDocumentSyncIncremental)
+               << "},\"documentSymbolProvider\":true},"
+               << "\"serverInfo\":{\"name\":\"perun-lsp\"}}";
+        sendResult(id, result);
+    } else if (method == "shutdown") {
+        shutdownRequested = true;
+        OutputBuffer result{};
+        result << "null";
+        sendResult(id, result);
+    } else if (method == "textDocument/documentSymbol") {
+        documentSymbol(id, params);
+    } else {
+        sendError(id, methodNotFound, "unsupported method '" + method + "'");
+    }
+}
+
+void Server::handleNotification(const std::string& method,
+                                const JSONValue& params) {
+    if (method == "textDocument/didOpen") {
+        didOpen(params);
+    } else if (method == "textDocument/didChange") {
+        didChange(params);
+    } else if (method == "textDocument/didClose") {
+        didClose(params);
+    } else if (method == "exit") {
+        exitRequested = true;
+    }
+    // other notifications (e.g. 'initialized') need no action
+}
+
+void Server::didOpen(const JSONValue& params) {
+    auto&& item = params.get("textDocument");
+    auto&& uri = item.get("uri").getString();
+    documents[uri] = std::make_unique<Document>(
+        uri, item.get("version").getInteger(), item.get("text").getString());
+    unpublished.insert(uri);
+}
+
+void Server::didChange(const JSONValue& params) {
+    auto&& item = params.get("textDocument");
+    auto&& it = documents.find(item.get("uri").getString());
+    if (it == documents.end()) {
+        return;
+    }
+
+    auto&& document = *it->second;
+    document.setVersion(item.get("version").getInteger());
+
+    // changes are applied in order, each to the result of the previous one
+    for (auto&& change : params.get("contentChanges").getArray()) {
+        auto&& range = change.get("range");
+        if (range.is(JSONValue::Kind::Null)) {
+            document.setText(change.get("text").getString());
+        } else {
+            document.applyChange(getPosition(range.get("start")),
+                                 getPosition(range.get("end")),
+                                 change.get("text").getString());
+        }
+    }
+    unpublished.insert(document.getURI());
+}
+
+void Server::didClose(const JSONValue& params) {
+    auto&& uri = params.get("textDocument").get("uri").getString();
+    if (documents.erase(uri) == 0) {
+        return;
+    }
+    unpublished.erase(uri);
+
+    // clears the diagnostics shown by the editor
+    OutputBuffer out{};
+    out << "{\"jsonrpc\":\"2.0\",\"method\":"
+        << "\"textDocument/publishDiagnostics\",\"params\":{\"uri\":";
+    support::writeJSONString(out, uri);
+    out << ",\"diagnostics\":[]}}";
+    send(out);
+}
+
+void Server::publishDiagnostics() {
+    for (auto&& uri : unpublished) {
+        auto&& it = documents.find(uri);
+        if (it != documents.end()) {
+            publishDiagnostics(*it->second);
+        }
+    }
+    unpublished.clear();
+}
+
+void Server::publishDiagnostics(Document& document) {
+    auto&& tree = document.getTree();
+    auto&& sourceManager = tree.getSourceManager();
+
+    OutputBuffer out{};
+    out << "{\"jsonrpc\":\"2.0\",\"method\":"
+        << "\"textDocument/publishDiagnostics\",\"params\":{\"uri\":";
+    support::writeJSONString(out, document.getURI());
+    out << ",\"version\":" << static_cast<uint64_t>(document.getVersion())
+        << ",\"diagnostics\":[";
+
+    bool first = true;
+    for (auto&& diag : tree.getDiagnostics().getSorted()) {
+        // the parser reports positions, an editor would show an empty range
+        size_t start = sourceManager.getFilePos(diag.loc);
+        size_t end = start;
+        if (end < document.getText().size() &&
+            document.getText()[end] != '\n') {
+            ++end;
+        }
+
+        out << (first ? "" : ",") << "{\"range\":";
+        writeRange(out, document, start, end);
+        out << ",\"severity\":" << static_cast<uint64_t>(severityError)
+            << ",\"source\":\"perun\",\"message\":";
+        support::writeJSONString(
+            out, parser::DiagnosticsEngine::formatMessage(diag));
+        out << '}';
+        first = false;
+    }
+    out << "]}}";
+    send(out);
+}
+
+void Server::documentSymbol(const JSONValue& id, const JSONValue& params) {
+    auto&& uri = params.get("textDocument").get("uri").getString();
+    auto&& it = documents.find(uri);
+    if (it == documents.end()) {
+        sendError(id, invalidRequest, "unknown document '" + uri + "'");
+        return;
+    }
+
+    auto&& document = *it->second;
+    auto&& tree = document.getTree();
+    auto&& tokens = tree.getTokens();
+
+    // writes a symbol spanning 'node', named by 'identifier'
+    auto&& writeSymbol = [&](OutputBuffer& out, const ast::Node& node,
+                             const ast::Identifier& identifier, int kind) {
+        auto&& nameToken = tokens[identifier.firstTokenIndex()];
+        out << "{\"name\":";
+        support::writeJSONString(out, identifier.getName());
+        out << ",\"kind\":" << static_cast<uint64_t>(kind) << ",\"range\":";
+        writeRange(out, document, tokens[node.firstTokenIndex()].start,
+                   tokens[node.lastTokenIndex()].end);
+        out << ",\"selectionRange\":";
+        writeRange(out, document, nameToken.start, nameToken.end);
+    };
+
+    OutputBuffer result{};
+    result << '[';
+    bool first = true;
+    if (tree.getRoot() != nullptr) {
+        for (auto&& decl : tree.getRoot()->getDecls()) {
+            // TODO: use llvm RTTI
+            switch (decl->getKind()) {
+            case ast::Node::Kind::VarDecl: {
+                auto&& var = static_cast<const ast::VarDecl&>(*decl);
+                if (var.getIdentifier() == nullptr) {
+                    break;
+                }
+                result << (first ? "" : ",");
+                writeSymbol(result, var, *var.getIdentifier(),
+                            var.isConst() ? symbolConstant : symbolVariable);
+                result << '}';
+                first = false;
+                break;
+            }
+            case ast::Node::Kind::FnDecl: {
+                auto&& fn = static_cast<const ast::FnDecl&>(*decl);
+                if (fn.getIdentifier() == nullptr) {
+                    break;
+                }
+                result << (first ? "" : ",");
+                writeSymbol(result, fn, *fn.getIdentifier(), symbolFunction);
+
+                // parameters are the children of the function
+                result << ",\"children\":[";
+                bool firstParam = true;
+                for (auto&& param : fn.getParams()) {
+                    if (param->getIdentifier() == nullptr) {
+                        continue;
+                    }
+                    result << (firstParam ? "" : ",");
+                    writeSymbol(result, *param, *param->getIdentifier(),
+                                symbolVariable);
+                    result << '}';
+                    firstParam = false;
+                }
+                result << "]}";
+                first = false;
+                break;
+            }
+            default: { break; }
+            }
+        }
+    }
+    result << ']';
+    sendResult(id, result);
+}
+
+} // namespace lsp
+} // namespace perun
@@ -0,0 +1,84 @@
+#ifndef PERUN_LSP_SERVER_HPP
+#define PERUN_LSP_SERVER_HPP
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "document.hpp"
+
+#include "../support/json.hpp"
+#include "../support/output.hpp"
+
+namespace perun {
+namespace lsp {
+
+/// Language server speaking JSON-RPC with the LSP base protocol framing
+///
+/// Supports the incremental text document sync, publishes
+/// the diagnostics of the parser and serves document symbols.
+/// Diagnostics are published only once there's no pending input,
+/// so a burst of edits is parsed once.
+class Server {
+public:
+    Server(int inFd, int outFd) : inFd(inFd), outFd(outFd) {}
+
+    /// Serves messages until 'exit' or the end of the input,
+    /// returns the exit status
+    int run();
+
+    /// Handles a single message (the body, without the header)
+    void handleMessage(support::StringRef body);
+
+    /// Parses the changed documents and publishes their diagnostics
+    void publishDiagnostics();
+
+    size_t getDocumentCount() const { return documents.size(); }
+
+private:
+    /// Reads the body of the next message, returns false at the end
+    bool readMessage(std::string& body);
+
+    /// True if there's input which hasn't been handled yet
+    bool hasPendingInput();
+
+    void send(const support::OutputBuffer& body);
+    void sendResult(const support::JSONValue& id,
+                    const support::OutputBuffer& result);
+    void sendError(const support::JSONValue& id, int code,
+                   const std::string& message);
+
+    void handleRequest(const std::string& method,
+                       const support::JSONValue& id,
+                       const support::JSONValue& params);
+    void handleNotification(const std::string& method,
+                            const support::JSONValue& params);
+
+    void didOpen(const support::JSONValue& params);
+    void didChange(const support::JSONValue& params);
+    void didClose(const support::JSONValue& params);
+    void documentSymbol(const support::JSONValue& id,
+                        const support::JSONValue& params);
+
+    void publishDiagnostics(Document& document);
+
+    const int inFd;
+    const int outFd;
+
+    std::string input{};
+    size_t inputPos = 0;
+
+    bool shutdownRequested = false;
+    bool exitRequested = false;
+
+    // ordered so the diagnostics are published deterministically
+    std::map<std::string, std::unique_ptr<Document>> documents{};
+    // documents changed since their diagnostics were published
+    std::set<std::string> unpublished{};
+};
+
+} // namespace lsp
+} // namespace perun
+
+#endif // PERUN_LSP_SERVER_HPP
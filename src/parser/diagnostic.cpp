@@ -0,0 +1,205 @@
+#include "diagnostic.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "../support/memory.hpp"
+
+namespace perun {
+namespace parser {
+
+// this should be synchronized with DiagID
+const char* getDiagFormat(DiagID id) {
+    switch (id) {
+// This uses special macros defined in `diagkinds.def`.
+// See that file for more details on how this works.
+#define DIAG(id, format)                                                       \
+    case DiagID::id:                                                           \
+        return format;
+#include "diagkinds.def"
+#undef DIAG
+    }
+
+    assert(false);
+    return "";
+}
+
+bool Diagnostic::operator==(const Diagnostic& other) const {
+    if (id != other.id || loc != other.loc || argsSize != other.argsSize) {
+        return false;
+    }
+
+    for (size_t i = 0; i < argsSize; ++i) {
+        if (!(args[i] == other.args[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DiagnosticsEngine::report(DiagID id, ast::Loc loc,
+                               std::initializer_list<DiagArg> args) {
+    assert(args.size() <= Diagnostic::maxArgs);
+
+    Diagnostic diag{};
+    diag.id = id;
+    diag.loc = loc;
+    diag.argsSize = static_cast<uint8_t>(args.size());
+    std::copy(args.begin(), args.end(), diag.args);
+    report(diag);
+}
+
+void DiagnosticsEngine::report(const Diagnostic& diag) {
+    if (storeLimit != 0 && diagnostics.size() >= storeLimit) {
+        dropped++;
+        return;
+    }
+
+    support::MemoryScope memory(support::MemoryPhase::Diagnostics);
+    diagnostics.push_back(diag);
+}
+
+std::vector<Diagnostic> DiagnosticsEngine::getSorted() const {
+    // diagnostics at the same location stay in the order they were
+    // reported, the first one is usually the cause of the others
+    std::vector<Diagnostic> sorted = diagnostics;
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Diagnostic& a, const Diagnostic& b) {
+                         return a.loc < b.loc;
+                     });
+
+    // duplicates share a location, only the first one is kept
+    size_t kept = 0;
+    size_t locStart = 0;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (kept != 0 && sorted[kept - 1].loc != sorted[i].loc) {
+            locStart = kept;
+        }
+        auto&& begin = sorted.begin() + locStart;
+        auto&& end = sorted.begin() + kept;
+        if (std::find(begin, end, sorted[i]) == end) {
+            sorted[kept++] = sorted[i];
+        }
+    }
+    sorted.resize(kept);
+    return sorted;
+}
+
+void DiagnosticsEngine::print(
+    std::ostream& os, const support::SourceManager& sourceManager) const {
+    support::MemoryScope memory(support::MemoryPhase::Diagnostics);
+    auto&& sorted = getSorted();
+
+    size_t shown = sorted.size();
+    if (displayLimit != 0 && displayLimit < shown) {
+        shown = displayLimit;
+    }
+
+    for (size_t i = 0; i < shown; ++i) {
+        os << format(sorted[i], sourceManager) << '\n';
+    }
+
+    size_t hidden = sorted.size() - shown + dropped;
+    if (hidden != 0) {
+        os << "perun: " << hidden << " more error(s) not shown\n";
+    }
+
+    os.flush();
+}
+
+std::string DiagnosticsEngine::formatMessage(const Diagnostic& diag) {
+    std::string message{};
+
+    // substitute the arguments into the format
+    for (const char* c = getDiagFormat(diag.id); *c != '\0'; ++c) {
+        if (c[0] != '%' || c[1] < '0' || c[1] > '9') {
+            message += *c;
+            continue;
+        }
+
+        size_t argIndex = *(++c) - '0';
+        assert(argIndex < diag.argsSize && "missing diagnostic argument");
+
+        auto&& arg = diag.args[argIndex];
+        switch (arg.kind) {
+        case DiagArg::Kind::Integer: {
+            message += std::to_string(arg.value);
+            break;
+        }
+        case DiagArg::Kind::Token: {
+            message += getTokenName(static_cast<Token::Kind>(arg.value));
+            break;
+        }
+        }
+    }
+
+    return message;
+}
+
+std::string
+DiagnosticsEngine::format(const Diagnostic& diag,
+                          const support::SourceManager& sourceManager) {
+    auto&& presumed = sourceManager.getPresumedLoc(diag.loc);
+
+    std::string message = sourceManager.getFilename(presumed.file) + ":" +
+                          std::to_string(presumed.line + 1) + ":" +
+                          std::to_string(presumed.column + 1) +
+                          ": error: " + formatMessage(diag);
+
+    auto&& buffer = sourceManager.getBuffer(presumed.file);
+    const char* sourceLine = buffer.data() + presumed.lineStartPos;
+    size_t sourceLineSize = presumed.lineLength();
+    size_t column = presumed.column;
+
+    // there's no source line to show
+    if (sourceLineSize == 0) {
+        return message;
+    }
+
+    // only a window around the error is shown from long lines,
+    // otherwise every error on a minified line would copy all of it
+    // The window ends at the end of the line at the latest.
+    const bool cutStart = sourceLineSize > maxSourceLineWidth &&
+                          column > maxSourceLineWidth / 2;
+    if (cutStart) {
+        const size_t skipped =
+            std::min(column - maxSourceLineWidth / 2,
+                     sourceLineSize - maxSourceLineWidth);
+        sourceLine += skipped;
+        sourceLineSize -= skipped;
+        column -= skipped;
+    }
+    const bool cutEnd = sourceLineSize > maxSourceLineWidth;
+    if (cutEnd) {
+        sourceLineSize = maxSourceLineWidth;
+    }
+
+    const char* const ellipsis = "...";
+    message += '\n';
+    message += cutStart ? ellipsis : "";
+    message.append(sourceLine, sourceLineSize);
+    message += cutEnd ? ellipsis : "";
+    message += '\n';
+
+    // print a line with a marker where the error is located
+    message += cutStart ? "   " : "";
+    for (size_t i = 0; i < sourceLineSize + 1; ++i) {
+        char c = ' ';
+        if (i < sourceLineSize) {
+            c = sourceLine[i];
+        }
+
+        if (i == column) {
+            message += '^';
+        } else if (c == '\t') {
+            message += '\t';
+        } else {
+            message += ' ';
+        }
+    }
+
+    return message;
+}
+
+} // namespace parser
+} // namespace perun
@@ -0,0 +1,136 @@
+#ifndef PERUN_PARSER_DIAGNOSTIC_HPP
+#define PERUN_PARSER_DIAGNOSTIC_HPP
+
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "../ast/loc.hpp"
+
+#include "../support/source.hpp"
+
+#include "token.hpp"
+
+namespace perun {
+namespace parser {
+
+enum class DiagID : uint16_t {
+// This uses special macros defined in `diagkinds.def`.
+// See that file for more details on how this works.
+#define DIAG(id, format) id,
+#include "diagkinds.def"
+#undef DIAG
+};
+
+/// Number of diagnostic ids
+constexpr size_t diagIDsCount = 0
+// This uses special macros defined in `diagkinds.def`.
+// See that file for more details on how this works.
+#define DIAG(id, format) +1
+#include "diagkinds.def"
+#undef DIAG
+    ;
+
+/// Returns the message format of a diagnostic
+const char* getDiagFormat(DiagID id);
+
+/// A small argument of a diagnostic, formatted only when printed
+struct DiagArg {
+    enum class Kind : uint8_t { Integer, Token };
+
+    static DiagArg integer(uint32_t value) { return {Kind::Integer, value}; }
+    static DiagArg token(Token::Kind kind) {
+        return {Kind::Token, static_cast<uint32_t>(kind)};
+    }
+
+    /// Checks a kind and a value read back from outside of the process
+    static bool isValid(uint64_t kind, uint64_t value) {
+        return kind == static_cast<uint64_t>(Kind::Integer)
+                   ? value <= UINT32_MAX
+                   : kind == static_cast<uint64_t>(Kind::Token) &&
+                         value < tokenKindsCount;
+    }
+
+    bool operator==(const DiagArg& other) const {
+        return kind == other.kind && value == other.value;
+    }
+
+    Kind kind;
+    uint32_t value;
+};
+
+/// A compact diagnostic record -- no strings are built
+/// until the diagnostic is printed
+struct Diagnostic {
+    static constexpr size_t maxArgs = 2;
+
+    DiagID id;
+    uint8_t argsSize;
+    ast::Loc loc;
+    DiagArg args[maxArgs];
+
+    bool operator==(const Diagnostic& other) const;
+};
+
+/// Collects diagnostics of a single tree
+///
+/// At most 'storeLimit' records are kept (0 means no limit), the rest
+/// is only counted, so pathological inputs can't use unbounded memory.
+/// Printing sorts the diagnostics by location, drops duplicates
+/// and shows at most 'displayLimit' of them.
+class DiagnosticsEngine {
+public:
+    static constexpr size_t defaultStoreLimit = 1024;
+    static constexpr size_t defaultDisplayLimit = 20;
+    static constexpr size_t maxSourceLineWidth = 120;
+
+    explicit DiagnosticsEngine(size_t storeLimit = defaultStoreLimit)
+        : storeLimit(storeLimit) {}
+
+    void report(DiagID id, ast::Loc loc,
+                std::initializer_list<DiagArg> args = {});
+    void report(const Diagnostic& diag);
+
+    bool hasErrors() const { return !diagnostics.empty() || dropped != 0; }
+
+    /// Number of reported diagnostics, including the dropped ones
+    size_t getCount() const { return diagnostics.size() + dropped; }
+    size_t getDroppedCount() const { return dropped; }
+    void setDroppedCount(size_t count) { dropped = count; }
+
+    const std::vector<Diagnostic>& getDiagnostics() const {
+        return diagnostics;
+    }
+
+    /// 0 means no limit
+    void setDisplayLimit(size_t limit) { displayLimit = limit; }
+
+    /// Returns diagnostics sorted by location without duplicates,
+    /// the ones at the same location in the order they were reported
+    std::vector<Diagnostic> getSorted() const;
+
+    /// Prints every diagnostic followed by a newline
+    void print(std::ostream& os,
+               const support::SourceManager& sourceManager) const;
+
+    /// Substitutes the arguments into the format of a diagnostic
+    static std::string formatMessage(const Diagnostic& diag);
+
+    /// Renders a diagnostic together with the source line and a caret
+    /// Lines longer than 'maxSourceLineWidth' are cut around the caret.
+    static std::string format(const Diagnostic& diag,
+                              const support::SourceManager& sourceManager);
+
+private:
+    std::vector<Diagnostic> diagnostics;
+    size_t storeLimit;
+    size_t displayLimit = defaultDisplayLimit;
+    size_t dropped = 0;
+};
+
+} // namespace parser
+} // namespace perun
+
+#endif // PERUN_PARSER_DIAGNOSTIC_HPP
@@ -0,0 +1,170 @@
+#ifndef PERUN_PARSER_EVENTPARSER_HPP
+#define PERUN_PARSER_EVENTPARSER_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "../ast/node.hpp"
+#include "../ast/tree.hpp"
+
+#include "../support/memory.hpp"
+
+#include "grammar.hpp"
+#include "token.hpp"
+
+namespace perun {
+namespace parser {
+
+/// Builder of parser::Grammar which makes no nodes, but reports
+/// the productions to 'Sink' as events:
+///   - 'enter(ast::Node::Kind)' when a node starts,
+///   - 'token(const Token&)' for every token (comments excluded),
+///   - 'leave(ast::Node::Kind)' when a node ends,
+/// nested exactly like the tree parser::Parser would build.
+/// A node gets all the tokens its production consumed, including
+/// the trailing ';' which the ast nodes leave out of their token range.
+///
+/// The grammar only knows a node once it is complete, so the events
+/// of a top-level declaration are sent right after it is parsed.
+/// Until then every node is a small record in a buffer
+/// which is reused for all declarations.
+template <typename Sink> class EventBuilder {
+public:
+    // the children are already in the record buffer
+    template <typename T> using Ptr = NodeHandle;
+    template <typename T> using List = NodeHandleList;
+
+    struct Start {
+        size_t firstToken;
+        size_t record;
+    };
+
+    static constexpr bool releasesTokens = true;
+
+    EventBuilder(const ParserBase& parser, Sink& sink)
+        : parser(parser), sink(sink) {}
+
+    Start start() const {
+        return Start{parser.getNextTokenIndex(), records.size()};
+    }
+
+    template <typename T, typename... Args>
+    NodeHandle make(Start start, Args&&...) {
+        records.push_back(Record{ast::NodeKindOf<T>::value, start.firstToken,
+                                 parser.getTokenIndex(), start.record});
+        return NodeHandle::made();
+    }
+
+    NodeHandle makeIdentifier(Start start, size_t) {
+        return make<ast::Identifier>(start);
+    }
+
+    NodeHandle makeInteger(Start start, size_t) {
+        return make<ast::LiteralInteger>(start);
+    }
+
+    NodeHandle makeRoot() {
+        sink.enter(ast::Node::Kind::Root);
+        return NodeHandle::made();
+    }
+
+    void addDecl(NodeHandle&, NodeHandle&&) {
+        assert(!records.empty() && records.back().begin == 0);
+        emit(records.size() - 1);
+        records.clear();
+    }
+
+    void finishRoot(NodeHandle&, size_t eofToken) {
+        emitTokens(eofToken + 1);
+        sink.leave(ast::Node::Kind::Root);
+    }
+
+private:
+    /// A complete node, stored in post-order
+    struct Record {
+        ast::Node::Kind kind;
+        size_t first; // first and last token
+        size_t last;
+        size_t begin; // first record of its subtree
+    };
+
+    const ParserBase& parser;
+    Sink& sink;
+
+    std::vector<Record> records;
+    std::vector<size_t> stack; // children not yet emitted
+
+    // the next token to send
+    size_t tokenCursor = 0;
+
+    void emitTokens(size_t end) {
+        for (; tokenCursor < end; ++tokenCursor) {
+            sink.token(parser.tokenAt(tokenCursor));
+        }
+    }
+
+    void emit(size_t index) {
+        const Record& record = records[index];
+        emitTokens(record.first);
+        sink.enter(record.kind);
+
+        // the children precede the node, the last one is right before it
+        const size_t base = stack.size();
+        size_t child = index;
+        while (child > record.begin) {
+            stack.push_back(child - 1);
+            child = records[child - 1].begin;
+        }
+
+        while (stack.size() > base) {
+            const size_t next = stack.back();
+            stack.pop_back();
+            emit(next);
+        }
+
+        emitTokens(record.last + 1);
+        sink.leave(record.kind);
+    }
+};
+
+/// Parses the buffer 'file' owned by 'sourceManager' into events
+/// for 'sink' (see EventBuilder), without allocating any ast nodes
+/// The returned tree holds the diagnostics, has no tokens and its root
+/// is empty. After an unrecoverable error the root is null, the events
+/// of the declaration being parsed are dropped and Root is never left.
+template <typename Sink>
+std::unique_ptr<ast::Tree>
+parseEvents(ast::Tree::SourceManagerPtr sourceManager, support::FileID file,
+            Sink& sink, support::Timer* lexTimer = nullptr,
+            bool pipelined = false) {
+    support::MemoryScope memory(support::MemoryPhase::Parser);
+    DiagnosticsEngine diagnostics{};
+    std::vector<Token> tokens{};
+    std::unique_ptr<ast::Root> root = nullptr;
+    auto&& tree = std::make_unique<ast::Tree>(
+        std::move(sourceManager), file, std::move(root), std::move(tokens),
+        std::move(diagnostics));
+
+    {
+        Grammar<EventBuilder<Sink>> grammar(*tree, lexTimer, pipelined, sink);
+        try {
+            grammar.parseRoot();
+            tree->setRoot(std::make_unique<ast::Root>());
+        } catch (int) {
+            // parsing ended with an unrecoverable error,
+            // anything else was thrown by the sink and is passed on
+        }
+    }
+
+    tree->getTokensMut().clear();
+    tree->getTokensMut().shrink_to_fit();
+
+    return std::move(tree);
+}
+
+} // namespace parser
+} // namespace perun
+
+#endif // PERUN_PARSER_EVENTPARSER_HPP
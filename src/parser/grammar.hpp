@@ -0,0 +1,939 @@
+#ifndef PERUN_PARSER_GRAMMAR_HPP
+#define PERUN_PARSER_GRAMMAR_HPP
+
+#include <cstddef>
+#include <utility>
+
+#include "../ast/expr.hpp"
+#include "../ast/literal.hpp"
+#include "../ast/node.hpp"
+#include "../ast/stmt.hpp"
+
+#include "../support/trace.hpp"
+
+#include "parserbase.hpp"
+
+namespace perun {
+namespace parser {
+
+/// Result of a production for builders which keep track of the nodes
+/// on their own (see EventBuilder), only tells whether there is one
+class NodeHandle {
+public:
+    NodeHandle() = default;
+    NodeHandle(std::nullptr_t) {}
+
+    static NodeHandle made() {
+        NodeHandle handle{};
+        handle.valid = true;
+        return handle;
+    }
+
+    bool operator==(std::nullptr_t) const { return !valid; }
+    bool operator!=(std::nullptr_t) const { return valid; }
+
+private:
+    bool valid = false;
+};
+
+/// List of NodeHandle, keeps nothing
+struct NodeHandleList {
+    void push_back(NodeHandle&&) {}
+};
+
+/// Hand-made recursive descent parser, generic over what it produces
+///
+/// The grammar only decides what was parsed, 'Builder' decides what
+/// to make of it, see TreeBuilder (ast nodes) and EventBuilder
+/// (enter/leave/token events). A Builder provides:
+///   - 'Ptr<T>' and 'List<T>': results of productions of ast node 'T',
+///     comparable with nullptr, lists have push_back
+///   - 'Start start()': taken at the start of every production
+///   - 'Ptr<T> make<T>(Start, ...)': called with the arguments
+///     of the constructor of 'T' once its production is complete
+///   - 'makeIdentifier' and 'makeInteger', which take the token only
+///   - 'makeRoot', 'addDecl' and 'finishRoot' for the Root, and
+///     'releasesTokens' to drop the tokens of every finished declaration
+template <typename Builder> class Grammar : public ParserBase {
+public:
+    template <typename T> using Ptr = typename Builder::template Ptr<T>;
+    template <typename T> using List = typename Builder::template List<T>;
+
+    /// 'builderArgs' are passed to the Builder after the parser itself
+    template <typename... Args>
+    Grammar(ast::Tree& tree, support::Timer* lexTimer, bool pipelined,
+            Args&&... builderArgs)
+        : ParserBase(tree, lexTimer, pipelined),
+          builder(*this, std::forward<Args>(builderArgs)...) {}
+
+    /// Parses the tokens of 'window', see ParserBase
+    template <typename... Args>
+    Grammar(ast::Tree& tree, TokenWindow& window, Args&&... builderArgs)
+        : ParserBase(tree, window),
+          builder(*this, std::forward<Args>(builderArgs)...) {}
+
+    // top-level parsing function
+    Ptr<ast::Root> parseRoot();
+
+    /// Statements while the next token is not past 'last',
+    /// for parsing a part of a block again (see TokenWindow)
+    /// The last statement can end after 'last', a '}' ends them early
+    /// like the end of the block.
+    List<ast::Stmt> parseStmtsUntil(size_t last);
+
+    /// The same for top-level declarations, with the errors of parseRoot
+    List<ast::Stmt> parseDeclsUntil(size_t last);
+
+private:
+    Builder builder;
+
+    template <typename T, typename... Args>
+    Ptr<T> make(typename Builder::Start start, Args&&... args) {
+        return builder.template make<T>(start, std::forward<Args>(args)...);
+    }
+
+    // parsing functions for nodes:
+    Ptr<ast::Stmt> parseTopLevelDecl(bool mandatory);
+
+    // statements:
+    Ptr<ast::Stmt> parseStmt(bool mandatory);
+    Ptr<ast::Block> parseBlock(bool mandatory);
+    Ptr<ast::VarDecl> parseVarDecl(bool mandatory);
+    Ptr<ast::ParamDecl> parseParamDecl();
+    List<ast::ParamDecl> parseParamDeclList();
+    Ptr<ast::FnDecl> parseFnDecl(bool mandatory);
+    Ptr<ast::Return> parseReturn(bool mandatory);
+    Ptr<ast::IfStmt> parseIfStmt(bool mandatory);
+    Ptr<ast::AssignStmt> parseAssignStmt(bool mandatory);
+
+    // expressions:
+    Ptr<ast::Expr> parseExpr(bool mandatory);
+    Ptr<ast::GroupedExpr> parseGroupedExpr(bool mandatory);
+    Ptr<ast::Identifier> parseIdentifier(bool mandatory);
+    Ptr<ast::Expr> parsePrimaryExpr(bool mandatory);
+    Ptr<ast::Expr> parsePrefixExpr(bool mandatory);
+    Ptr<ast::Expr> parseMultExpr(bool mandatory);
+    Ptr<ast::Expr> parseAddExpr(bool mandatory);
+    Ptr<ast::Expr> parseShiftExpr(bool mandatory);
+    Ptr<ast::Expr> parseBitExpr(bool mandatory);
+    Ptr<ast::Expr> parseCompareExpr(bool mandatory);
+    Ptr<ast::Expr> parseSuffixExpr(bool mandatory);
+    bool parseExprList(List<ast::Expr>& args, bool mandatory);
+    Ptr<ast::CallExpr> parseCallExpr(bool mandatory);
+};
+
+// Note - TODO:
+// The parser now throws 42 on non-recoverable errors.
+// More errors should be made recoverable and
+// all other non-recoverable errors should be dealt with
+// properly without resorting to exceptions
+
+// Root := TLD* EOF
+template <typename Builder>
+auto Grammar<Builder>::parseRoot() -> Ptr<ast::Root> {
+    auto root = builder.makeRoot();
+
+    while (true) {
+        auto&& decl = parseTopLevelDecl(false);
+        if (decl == nullptr) {
+            break;
+        }
+
+        builder.addDecl(root, std::move(decl));
+        if (Builder::releasesTokens) {
+            releaseTokens();
+        }
+    }
+
+    if (consumeToken(Token::Kind::EndOfFile)) {
+        builder.finishRoot(root, tokenIndex);
+        return root;
+    } else {
+        auto&& tok = peekNextToken();
+        error(DiagID::InvalidTokenExpectedEOF, tok,
+              {DiagArg::token(tok.getKind())});
+        throw 42;
+    }
+}
+
+template <typename Builder>
+auto Grammar<Builder>::parseStmtsUntil(size_t last) -> List<ast::Stmt> {
+    List<ast::Stmt> stmts{};
+    while (getNextTokenIndex() <= last &&
+           peekNextToken().isNot(Token::Kind::RBrace)) {
+        stmts.push_back(parseStmt(true));
+    }
+    return stmts;
+}
+
+template <typename Builder>
+auto Grammar<Builder>::parseDeclsUntil(size_t last) -> List<ast::Stmt> {
+    List<ast::Stmt> decls{};
+    while (getNextTokenIndex() <= last) {
+        auto&& decl = parseTopLevelDecl(false);
+        if (decl == nullptr) {
+            // parseRoot wants the end of file after the declarations
+            auto&& tok = peekNextToken();
+            error(DiagID::InvalidTokenExpectedEOF, tok,
+                  {DiagArg::token(tok.getKind())});
+            throw 42;
+        }
+        decls.push_back(std::move(decl));
+    }
+    return decls;
+}
+
+// TLD := VarDecl | FnDecl
+template <typename Builder>
+auto Grammar<Builder>::parseTopLevelDecl(bool mandatory) -> Ptr<ast::Stmt> {
+    auto varDecl = parseVarDecl(false);
+    if (varDecl != nullptr) {
+        return varDecl;
+    }
+
+    auto fnDecl = parseFnDecl(false);
+    if (fnDecl != nullptr) {
+        return fnDecl;
+    }
+
+    if (!mandatory) {
+        return nullptr;
+    }
+
+    auto&& tok = peekNextToken();
+    error(DiagID::InvalidTokenExpectedTopLevelDecl, tok,
+          {DiagArg::token(tok.getKind())});
+    throw 42;
+}
+
+// statements:
+
+// Stmt := Return | IfStmt | VarDecl | AssignStmt
+template <typename Builder>
+auto Grammar<Builder>::parseStmt(bool mandatory) -> Ptr<ast::Stmt> {
+    auto returnStmt = parseReturn(false);
+    if (returnStmt != nullptr) {
+        return returnStmt;
+    }
+
+    auto ifStmt = parseIfStmt(false);
+    if (ifStmt != nullptr) {
+        return ifStmt;
+    }
+
+    auto varDecl = parseVarDecl(false);
+    if (varDecl != nullptr) {
+        return varDecl;
+    }
+
+    auto assign = parseAssignStmt(false);
+    if (assign != nullptr) {
+        return assign;
+    }
+
+    if (!mandatory) {
+        return nullptr;
+    }
+
+    auto&& tok = peekNextToken();
+    error(DiagID::InvalidTokenExpectedStmt, tok,
+          {DiagArg::token(tok.getKind())});
+    throw 42;
+}
+
+// Block := '{' Stmt* '}'
+template <typename Builder>
+auto Grammar<Builder>::parseBlock(bool mandatory) -> Ptr<ast::Block> {
+    auto&& start = builder.start();
+    List<ast::Stmt> stmts{};
+
+    auto lBrace = consumeToken(Token::Kind::LBrace);
+    if (lBrace == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedLBraceInBlock, tokenIndex);
+        throw 42;
+    }
+
+    size_t lBraceIndex = tokenIndex;
+    size_t rBraceIndex = 0;
+    while (true) {
+        auto rBrace = consumeToken(Token::Kind::RBrace);
+        if (rBrace != nullptr) {
+            rBraceIndex = tokenIndex;
+            break;
+        }
+
+        auto stmt = parseStmt(true);
+        if (stmt == nullptr) {
+            // we couldn't parse a statement
+            break;
+        }
+
+        stmts.push_back(std::move(stmt));
+    }
+
+    return make<ast::Block>(start, lBraceIndex, rBraceIndex, std::move(stmts));
+}
+
+// VarDecl := ('var' | 'const') Identifier (: Type)? '=' Expr ';'
+template <typename Builder>
+auto Grammar<Builder>::parseVarDecl(bool mandatory) -> Ptr<ast::VarDecl> {
+    auto&& start = builder.start();
+    bool isConst;
+    if (consumeToken(Token::Kind::KeywordVar)) {
+        isConst = false;
+    } else if (consumeToken(Token::Kind::KeywordConst)) {
+        isConst = true;
+    } else if (mandatory) {
+        error(DiagID::ExpectedVarOrConst, tokenIndex);
+        throw 42;
+    } else {
+        return nullptr;
+    }
+
+    size_t varToken = tokenIndex;
+
+    auto identifier = parseIdentifier(true);
+
+    Ptr<ast::Expr> typeExpr = nullptr;
+    if (consumeToken(Token::Kind::Colon)) {
+        typeExpr = parseExpr(true);
+    }
+
+    Ptr<ast::Expr> expr = nullptr;
+    if (consumeToken(Token::Kind::Eq)) {
+        expr = parseExpr(true);
+    }
+
+    size_t semicolonToken = tokenIndex;
+    if (!consumeToken(Token::Kind::Semicolon)) {
+        errorAtEnd(DiagID::ExpectedSemicolonAfterVarDecl, tokenIndex);
+        // continue as if we got a semicolon
+    }
+
+    return make<ast::VarDecl>(start, isConst, std::move(identifier),
+                              std::move(typeExpr), std::move(expr), varToken,
+                              semicolonToken);
+}
+
+// ParamDecl := (Identifier ':')? Type
+template <typename Builder>
+auto Grammar<Builder>::parseParamDecl() -> Ptr<ast::ParamDecl> {
+    auto&& start = builder.start();
+    auto identifier = parseIdentifier(false);
+    if (identifier != nullptr) {
+        if (consumeToken(Token::Kind::Colon) == nullptr) {
+            error(DiagID::ExpectedColon, tokenIndex);
+            throw 42;
+        }
+    }
+
+    auto typeExpr = parseExpr(true);
+
+    return make<ast::ParamDecl>(start, std::move(identifier),
+                                std::move(typeExpr));
+}
+
+// ParamDeclList := '(' (ParamDecl ',')* ParamDecl? ')'
+template <typename Builder>
+auto Grammar<Builder>::parseParamDeclList() -> List<ast::ParamDecl> {
+    List<ast::ParamDecl> params{};
+
+    if (!consumeToken(Token::Kind::LParen)) {
+        error(DiagID::ExpectedLParen, tokenIndex);
+        throw 42;
+    }
+
+    bool expectBreak = false;
+    while (true) {
+        if (consumeToken(Token::Kind::RParen)) {
+            break;
+        } else if (expectBreak) {
+            error(DiagID::ExpectedRParenInList, tokenIndex);
+            throw 42;
+        }
+
+        auto param = parseParamDecl();
+        params.push_back(std::move(param));
+
+        if (!consumeToken(Token::Kind::Comma)) {
+            expectBreak = true;
+        }
+    }
+
+    return params;
+}
+
+// FnDecl := 'pub'? ('extern' | 'export')? 'fn' Identifier?
+//           ParamDeclList ('->' Type)? (Block | ';')
+template <typename Builder>
+auto Grammar<Builder>::parseFnDecl(bool mandatory) -> Ptr<ast::FnDecl> {
+    auto&& start = builder.start();
+
+    // all the tokens that don't exist stay 0
+    size_t pubToken = 0, modifierToken = 0, fnToken = 0, semicolonToken = 0;
+    bool pub = false;
+    if (consumeToken(Token::Kind::KeywordPub)) {
+        pub = true;
+        pubToken = tokenIndex;
+    }
+
+    bool _extern = false;
+    bool _export = false;
+    if (consumeToken(Token::Kind::KeywordExtern)) {
+        _extern = true;
+        modifierToken = tokenIndex;
+    } else if (consumeToken(Token::Kind::KeywordExport)) {
+        _export = true;
+        modifierToken = tokenIndex;
+    }
+
+    if (!consumeToken(Token::Kind::KeywordFn)) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedFn, tokenIndex);
+        throw 42;
+    }
+    fnToken = tokenIndex;
+
+    // every function gets its own span in a trace
+    support::TraceScope scope("FnDecl");
+
+    auto identifier = parseIdentifier(true);
+    auto&& name = tokenAt(tokenIndex);
+    scope.setDetail(source.substr(name.start, name.length()));
+
+    auto params = parseParamDeclList();
+
+    Ptr<ast::Expr> returnType = nullptr;
+    if (consumeToken(Token::Kind::MinusGreater)) {
+        returnType = parseExpr(true);
+    }
+
+    auto body = parseBlock(false);
+
+    if (body == nullptr) { // empty body
+        semicolonToken = tokenIndex;
+
+        if (!consumeToken(Token::Kind::Semicolon)) {
+            errorAtEnd(DiagID::ExpectedSemicolonAfterFnDecl, tokenIndex);
+            // continue as if we got ';'
+        }
+    }
+
+    return make<ast::FnDecl>(start, std::move(identifier), std::move(params),
+                             std::move(returnType), std::move(body), pub,
+                             _extern, _export, fnToken, pubToken,
+                             modifierToken, semicolonToken);
+}
+
+// Return := 'return' Expr? ';'
+template <typename Builder>
+auto Grammar<Builder>::parseReturn(bool mandatory) -> Ptr<ast::Return> {
+    auto&& start = builder.start();
+    size_t returnToken;
+
+    if (consumeToken(Token::Kind::KeywordReturn) != nullptr) {
+        returnToken = tokenIndex;
+    } else if (!mandatory) {
+        return nullptr;
+    } else {
+        error(DiagID::ExpectedReturn, tokenIndex);
+        throw 42;
+    }
+
+    auto&& expr = parseExpr(false);
+
+    size_t semicolonToken = tokenIndex;
+    if (consumeToken(Token::Kind::Semicolon) == nullptr) {
+        errorAtEnd(DiagID::ExpectedSemicolonAfterReturn, tokenIndex);
+        // continue as if we got ';'
+    }
+
+    return make<ast::Return>(start, std::move(expr), returnToken,
+                             semicolonToken);
+}
+
+// IfStmt := 'if' Expr Block ('else' Block)?
+template <typename Builder>
+auto Grammar<Builder>::parseIfStmt(bool mandatory) -> Ptr<ast::IfStmt> {
+    auto&& start = builder.start();
+    size_t ifToken, elseToken = 0;
+
+    if (consumeToken(Token::Kind::KeywordIf) == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedIf, tokenIndex);
+        throw 42;
+    }
+
+    ifToken = tokenIndex;
+
+    auto&& expr = parseExpr(true);
+    auto&& then = parseBlock(true);
+
+    if (consumeToken(Token::Kind::KeywordElse) == nullptr) {
+        return make<ast::IfStmt>(start, std::move(expr), std::move(then),
+                                 /* otherwise = */ nullptr, ifToken,
+                                 elseToken);
+    }
+
+    elseToken = tokenIndex;
+
+    auto&& otherwise = parseBlock(true);
+    return make<ast::IfStmt>(start, std::move(expr), std::move(then),
+                             std::move(otherwise), ifToken, elseToken);
+}
+
+// AssignStmt := ('_' | Expr) AssignOp Expr ';'
+template <typename Builder>
+auto Grammar<Builder>::parseAssignStmt(bool mandatory)
+    -> Ptr<ast::AssignStmt> {
+    auto&& start = builder.start();
+    Ptr<ast::Expr> lhs = nullptr;
+    ast::AssignOp op = ast::AssignOp::Invalid;
+    if (consumeToken(Token::Kind::Underscore) == nullptr) {
+        lhs = std::move(parseExpr(false));
+        if (lhs == nullptr) {
+            if (!mandatory) {
+                return nullptr;
+            }
+
+            error(DiagID::ExpectedAssignLHS, tokenIndex);
+            throw 42;
+        }
+        op = parseAssignOp();
+        if (op == ast::AssignOp::Invalid) {
+            error(DiagID::ExpectedAssignOp, tokenIndex);
+            throw 42;
+        }
+    } else {
+        if (consumeToken(Token::Kind::Eq) == nullptr) {
+            error(DiagID::ExpectedEq, tokenIndex);
+            throw 42;
+        }
+        op = ast::AssignOp::Assign;
+    }
+    size_t opToken = tokenIndex;
+
+    auto&& rhs = parseExpr(true);
+
+    size_t semicolonToken = tokenIndex;
+    if (consumeToken(Token::Kind::Semicolon) == nullptr) {
+        errorAtEnd(DiagID::ExpectedSemicolonAfterAssign, tokenIndex);
+        // continue as if we got ';'
+    }
+
+    return make<ast::AssignStmt>(start, std::move(lhs), std::move(rhs), op,
+                                 opToken, semicolonToken);
+}
+
+// expressions:
+
+// Expr := CompareExpr
+template <typename Builder>
+auto Grammar<Builder>::parseExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto expr = parseCompareExpr(false);
+    if (expr != nullptr) {
+        return expr;
+    }
+
+    if (!mandatory) {
+        return nullptr;
+    }
+
+    error(DiagID::InvalidExpr, tokenIndex);
+    throw 42;
+}
+
+// GroupedExpr := '(' Expr ')'
+template <typename Builder>
+auto Grammar<Builder>::parseGroupedExpr(bool mandatory)
+    -> Ptr<ast::GroupedExpr> {
+    auto&& start = builder.start();
+    size_t lParenToken, rParenToken;
+    if (consumeToken(Token::Kind::LParen) == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedLParenInGroupedExpr, tokenIndex);
+        throw 42;
+    }
+    lParenToken = tokenIndex;
+
+    auto&& expr = parseExpr(true);
+
+    if (consumeToken(Token::Kind::RParen) == nullptr) {
+        errorAtEnd(DiagID::ExpectedRParenInGroupedExpr, tokenIndex);
+        // continue as if we got ')'
+    }
+    rParenToken = tokenIndex;
+
+    return make<ast::GroupedExpr>(start, std::move(expr), lParenToken,
+                                  rParenToken);
+}
+
+template <typename Builder>
+auto Grammar<Builder>::parseIdentifier(bool mandatory)
+    -> Ptr<ast::Identifier> {
+    auto&& start = builder.start();
+    if (consumeToken(Token::Kind::Identifier) != nullptr) {
+        return builder.makeIdentifier(start, tokenIndex);
+    }
+
+    if (!mandatory) {
+        return nullptr;
+    }
+
+    error(DiagID::ExpectedIdentifier, tokenIndex);
+    throw 42;
+}
+
+// PrimaryExpr := Integer | 'true' | 'false' | 'nil' | 'undefined'
+//              | GroupedExpr | Identifier
+template <typename Builder>
+auto Grammar<Builder>::parsePrimaryExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    if (consumeToken(Token::Kind::LiteralInteger) != nullptr) {
+        return builder.makeInteger(start, tokenIndex);
+    } else if (consumeToken(Token::Kind::KeywordTrue) != nullptr) {
+        return make<ast::LiteralBoolean>(start, true, tokenIndex);
+    } else if (consumeToken(Token::Kind::KeywordFalse) != nullptr) {
+        return make<ast::LiteralBoolean>(start, false, tokenIndex);
+    } else if (consumeToken(Token::Kind::KeywordNil) != nullptr) {
+        return make<ast::LiteralNil>(start, tokenIndex);
+    } else if (consumeToken(Token::Kind::KeywordUndefined) != nullptr) {
+        return make<ast::LiteralUndefined>(start, tokenIndex);
+    }
+
+    auto grouped = parseGroupedExpr(false);
+    if (grouped != nullptr) {
+        return grouped;
+    }
+
+    auto identifier = parseIdentifier(false);
+    if (identifier != nullptr) {
+        return identifier;
+    }
+
+    if (!mandatory) {
+        return nullptr;
+    }
+
+    error(DiagID::ExpectedPrimaryExpr, tokenIndex);
+    throw 42;
+}
+
+// PrefixExpr := PrefixOp PrefixExpr | SuffixExpr
+template <typename Builder>
+auto Grammar<Builder>::parsePrefixExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    auto op = parsePrefixOp();
+    if (op == ast::PrefixOp::Invalid) {
+        return parseSuffixExpr(mandatory);
+    }
+
+    auto&& expr = parsePrefixExpr(true);
+    size_t opToken = tokenIndex;
+    auto&& prefix_expr =
+        make<ast::PrefixExpr>(start, std::move(expr), op, opToken);
+
+    return std::move(prefix_expr);
+}
+
+// MultExpr := PrefixExpr (MultOp PrefixExpr)*
+template <typename Builder>
+auto Grammar<Builder>::parseMultExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    Ptr<ast::Expr> expr = parsePrefixExpr(false);
+    if (expr == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedPrefixExpr, tokenIndex);
+        throw 42;
+    }
+
+    while (true) {
+        auto op = parseMultOp();
+        if (op == ast::InfixOp::Invalid) {
+            break;
+        }
+
+        size_t opToken = tokenIndex;
+
+        // if we parsed the MultOp correctly,
+        // then the next thing must be a PrefixExpr
+        auto&& rhs = parsePrefixExpr(true);
+
+        auto&& newExpr = make<ast::InfixExpr>(start, std::move(expr),
+                                              std::move(rhs), op, opToken);
+
+        expr = std::move(newExpr);
+    }
+
+    return expr;
+}
+
+// AddExpr := MultExpr (AddOp MultExpr)*
+template <typename Builder>
+auto Grammar<Builder>::parseAddExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    Ptr<ast::Expr> expr = parseMultExpr(false);
+    if (expr == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedMultExpr, tokenIndex);
+        throw 42;
+    }
+
+    while (true) {
+        auto op = parseAddOp();
+        if (op == ast::InfixOp::Invalid) {
+            break;
+        }
+
+        size_t opToken = tokenIndex;
+
+        // if we parsed the AddOp correctly,
+        // then the next thing must be a MultExpr
+        auto&& rhs = parseMultExpr(true);
+
+        auto&& newExpr = make<ast::InfixExpr>(start, std::move(expr),
+                                              std::move(rhs), op, opToken);
+
+        expr = std::move(newExpr);
+    }
+
+    return expr;
+}
+
+// ShiftExpr := AddExpr (ShiftOp AddExpr)*
+template <typename Builder>
+auto Grammar<Builder>::parseShiftExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    Ptr<ast::Expr> expr = parseAddExpr(false);
+    if (expr == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedAddExpr, tokenIndex);
+        throw 42;
+    }
+
+    while (true) {
+        auto op = parseShiftOp();
+        if (op == ast::InfixOp::Invalid) {
+            break;
+        }
+
+        size_t opToken = tokenIndex;
+
+        // if we parsed the ShiftOp correctly,
+        // then the next thing must be a AddExpr
+        auto&& rhs = parseAddExpr(true);
+
+        auto&& newExpr = make<ast::InfixExpr>(start, std::move(expr),
+                                              std::move(rhs), op, opToken);
+
+        expr = std::move(newExpr);
+    }
+
+    return expr;
+}
+
+// BitExpr := ShiftExpr (BitOp ShiftExpr)*
+template <typename Builder>
+auto Grammar<Builder>::parseBitExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    Ptr<ast::Expr> expr = parseShiftExpr(false);
+    if (expr == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedShiftExpr, tokenIndex);
+        throw 42;
+    }
+
+    while (true) {
+        auto op = parseBitOp();
+        if (op == ast::InfixOp::Invalid) {
+            break;
+        }
+
+        size_t opToken = tokenIndex;
+
+        // if we parsed the BitOp correctly,
+        // then the next thing must be a ShiftExpr
+        auto&& rhs = parseShiftExpr(true);
+
+        auto&& newExpr = make<ast::InfixExpr>(start, std::move(expr),
+                                              std::move(rhs), op, opToken);
+
+        expr = std::move(newExpr);
+    }
+
+    return expr;
+}
+
+// CompareExpr := BitExpr (CompareOp BitExpr)*
+template <typename Builder>
+auto Grammar<Builder>::parseCompareExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    Ptr<ast::Expr> expr = parseBitExpr(false);
+    if (expr == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedBitExpr, tokenIndex);
+        throw 42;
+    }
+
+    while (true) {
+        auto op = parseCompareOp();
+        if (op == ast::InfixOp::Invalid) {
+            break;
+        }
+
+        size_t opToken = tokenIndex;
+
+        // if we parsed the CompareOp correctly,
+        // then the next thing must be a BitExpr
+        auto&& rhs = parseBitExpr(true);
+
+        auto&& newExpr = make<ast::InfixExpr>(start, std::move(expr),
+                                              std::move(rhs), op, opToken);
+
+        expr = std::move(newExpr);
+    }
+
+    return expr;
+}
+
+// SuffixExpr := PrimExpr (SuffixOp | CallExpr)*
+template <typename Builder>
+auto Grammar<Builder>::parseSuffixExpr(bool mandatory) -> Ptr<ast::Expr> {
+    auto&& start = builder.start();
+    Ptr<ast::Expr> expr = parsePrimaryExpr(false);
+    if (expr == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedPrimExpr, tokenIndex);
+        throw 42;
+    }
+
+    while (true) {
+        // either a suffix op
+        auto op = parseSuffixOp();
+        if (op != ast::SuffixOp::Invalid) {
+            size_t opToken = tokenIndex;
+            auto&& newExpr =
+                make<ast::SuffixExpr>(start, std::move(expr), op, opToken);
+            expr = std::move(newExpr);
+            continue;
+        }
+
+        // or a function call
+        size_t leftParenToken = tokenIndex;
+        List<ast::Expr> fnCallArgs{};
+        if (parseExprList(fnCallArgs, false)) {
+            size_t rightParenToken = tokenIndex;
+            auto&& newExpr =
+                make<ast::CallExpr>(start, std::move(expr),
+                                    std::move(fnCallArgs), leftParenToken,
+                                    rightParenToken);
+            expr = std::move(newExpr);
+            continue;
+        }
+
+        break;
+        // TODO: add array access, slice, member access
+    }
+
+    return expr;
+}
+
+// ExprList := '(' (Expr ',')* Expr? ')'
+// The arguments are appended to 'args', returns false if there is no list
+template <typename Builder>
+bool Grammar<Builder>::parseExprList(List<ast::Expr>& args, bool mandatory) {
+    // TODO: Generalize this and ParamDeclList?
+    if (!consumeToken(Token::Kind::LParen)) {
+        if (!mandatory) {
+            return false;
+        }
+
+        error(DiagID::ExpectedLParen, tokenIndex);
+        throw 42;
+    }
+
+    bool expectBreak = false;
+    while (true) {
+        if (consumeToken(Token::Kind::RParen)) {
+            break;
+        } else if (expectBreak) {
+            error(DiagID::ExpectedRParenInList, tokenIndex);
+            throw 42;
+        }
+
+        auto&& arg = parseExpr(false);
+        if (arg == nullptr) {
+            expectBreak = true;
+            continue;
+        }
+
+        args.push_back(std::move(arg));
+
+        if (!consumeToken(Token::Kind::Comma)) {
+            expectBreak = true;
+        }
+    }
+
+    return true;
+}
+
+// CallExpr := Expr ExprList
+template <typename Builder>
+auto Grammar<Builder>::parseCallExpr(bool mandatory) -> Ptr<ast::CallExpr> {
+    // Note: this is actually here just for completeness,
+    //       it is never called in the code (so far...)
+    auto&& start = builder.start();
+    Ptr<ast::Expr> expr = parseExpr(false);
+    if (expr == nullptr) {
+        if (!mandatory) {
+            return nullptr;
+        }
+
+        error(DiagID::ExpectedExprInCallExpr, tokenIndex);
+        throw 42;
+    }
+
+    size_t leftParenToken = tokenIndex;
+    List<ast::Expr> args{};
+    parseExprList(args, true);
+    size_t rightParenToken = tokenIndex;
+
+    return make<ast::CallExpr>(start, std::move(expr), std::move(args),
+                               leftParenToken, rightParenToken);
+}
+
+} // namespace parser
+} // namespace perun
+
+#endif // PERUN_PARSER_GRAMMAR_HPP
@@ -1,150 +1,178 @@
 #ifndef PERUN_PARSER_PARSER_HPP
 #define PERUN_PARSER_PARSER_HPP
 
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
-#include "../support/optional.hpp"
+#include "../ast/node.hpp"
+#include "../ast/stmt.hpp"
+#include "../support/memory.hpp"
+#include "../support/timer.hpp"
 
-#include "error.hpp"
+#include "grammar.hpp"
 #include "token.hpp"
-#include "tokenizer.hpp"
 
 namespace perun {
+namespace parser {
 
-// pre-declared as opaque to avoid unnecessary include
-namespace ast {
-class Tree;
-
-class Root;
-
-class Stmt;
-class Block;
-
-class VarDecl;
-class ParamDecl;
-class FnDecl;
-class Return;
-class IfStmt;
-class AssignStmt;
-
-class Expr;
-class GroupedExpr;
-class Identifier;
-class PrefixExpr;
-class InfixExpr;
-class SuffixExpr;
-class CallExpr;
-
-// pre-declared ops
-enum class AssignOp : short;
-enum class PrefixOp : short;
-enum class InfixOp : short;
-enum class SuffixOp : short;
-} // namespace ast
+/// Tokens of a single top-level declaration, handed out while streaming
+/// They are indexed by the same (global) indices the nodes refer to
+/// and are only valid during the call of the DeclConsumer.
+class DeclTokens {
+public:
+    DeclTokens(const Token* tokens, size_t firstIndex, size_t lastIndex)
+        : tokens(tokens), firstIndex(firstIndex), lastIndex(lastIndex) {}
 
-namespace parser {
+    size_t getFirstIndex() const { return firstIndex; }
+    size_t getLastIndex() const { return lastIndex; }
+    size_t size() const { return lastIndex - firstIndex + 1; }
+
+    const Token& operator[](size_t index) const {
+        assert(index >= firstIndex && index <= lastIndex);
+        return tokens[index - firstIndex];
+    }
+
+private:
+    const Token* tokens;
+    size_t firstIndex;
+    size_t lastIndex;
+};
+
+/// Receives every top-level declaration as soon as it is parsed
+using DeclConsumer = std::function<void(std::unique_ptr<ast::Stmt>&& decl,
+                                        const DeclTokens& tokens)>;
+
+/// Builder of parser::Grammar which makes the usual ast nodes
+/// The nodes are attributed to the ast memory phase by their kind.
+class TreeBuilder {
+public:
+    template <typename T> using Ptr = std::unique_ptr<T>;
+    template <typename T> using List = ast::NodeList<T>;
+
+    // nodes find their tokens on their own
+    struct Start {};
 
-/// Hand-made recursive descent parser
+    static constexpr bool releasesTokens = false;
+
+    explicit TreeBuilder(const ParserBase& parser) : parser(parser) {}
+
+    Start start() const { return Start(); }
+
+    template <typename T, typename... Args>
+    std::unique_ptr<T> make(Start, Args&&... args) {
+        support::MemoryScope scope(support::MemoryPhase::AST,
+                                   memoryDetail<T>());
+        return std::make_unique<T>(std::forward<Args>(args)...);
+    }
+
+    std::unique_ptr<ast::Identifier> makeIdentifier(Start, size_t token) {
+        support::MemoryScope scope(support::MemoryPhase::AST,
+                                   memoryDetail<ast::Identifier>());
+        return std::make_unique<ast::Identifier>(parser.tokenToString(token),
+                                                 token);
+    }
+
+    std::unique_ptr<ast::LiteralInteger> makeInteger(Start, size_t token) {
+        support::MemoryScope scope(support::MemoryPhase::AST,
+                                   memoryDetail<ast::LiteralInteger>());
+        return std::make_unique<ast::LiteralInteger>(
+            parser.parseNumber(token), token);
+    }
+
+    std::unique_ptr<ast::Root> makeRoot() {
+        support::MemoryScope scope(support::MemoryPhase::AST,
+                                   memoryDetail<ast::Root>());
+        return std::make_unique<ast::Root>();
+    }
+
+    void addDecl(std::unique_ptr<ast::Root>& root,
+                 std::unique_ptr<ast::Stmt>&& decl) {
+        support::MemoryScope scope(support::MemoryPhase::AST,
+                                   memoryDetail<ast::Root>());
+        root->addDecl(std::move(decl));
+    }
+
+    void finishRoot(std::unique_ptr<ast::Root>& root, size_t eofToken) {
+        root->setEOFToken(eofToken);
+    }
+
+protected:
+    const ParserBase& parser;
+
+    template <typename T> static size_t memoryDetail() {
+        return static_cast<size_t>(ast::NodeKindOf<T>::value);
+    }
+};
+
+/// Builder which hands every declaration to a DeclConsumer
+/// instead of adding it to the root
+class StreamBuilder : public TreeBuilder {
+public:
+    static constexpr bool releasesTokens = true;
+
+    StreamBuilder(const ParserBase& parser, const DeclConsumer& consumer)
+        : TreeBuilder(parser), consumer(consumer) {}
+
+    void addDecl(std::unique_ptr<ast::Root>&,
+                 std::unique_ptr<ast::Stmt>&& decl) {
+        const size_t first = decl->firstTokenIndex();
+        const size_t last = parser.getTokenIndex();
+        // the consumer's allocations are not the parser's
+        support::MemoryScope scope(support::MemoryPhase::Other);
+        consumer(std::move(decl),
+                 DeclTokens(&parser.tokenAt(first), first, last));
+    }
+
+    // the root stays empty, see Parser::parseRootStreaming
+    void finishRoot(std::unique_ptr<ast::Root>&, size_t) {}
+
+private:
+    const DeclConsumer& consumer;
+};
+
+extern template class Grammar<TreeBuilder>;
+extern template class Grammar<StreamBuilder>;
+
+/// Hand-made recursive descent parser building an ast::Root
+/// The grammar itself lives in parser::Grammar.
 class Parser {
 public:
     /// Expects a tree with an empty root
     /// -> see ast::Tree::get on how to call this properly
-    explicit Parser(ast::Tree& tree);
+    /// Time spent in the tokenizer is accumulated into 'lexTimer'
+    /// if it is not null
+    /// If 'pipelined' is set, the source is tokenized ahead on another
+    /// thread (see TokenPipeline) and 'lexTimer' only gets the time
+    /// the parser waited for tokens.
+    explicit Parser(ast::Tree& tree, support::Timer* lexTimer = nullptr,
+                    bool pipelined = false);
 
     // top-level parsing function
     std::unique_ptr<ast::Root> parseRoot();
 
-private:
-    ast::Tree& tree;
+    /// Parses like parseRoot, but hands each declaration to 'consumer'
+    /// and releases its tokens instead of keeping them in the tree
+    /// The returned root has no declarations.
+    std::unique_ptr<ast::Root> parseRootStreaming(const DeclConsumer& consumer);
 
-    const std::string& source;
-    std::vector<Token>& tokens;
-    std::vector<std::unique_ptr<support::Error>>& errors;
-
-    Tokenizer tokenizer;
-
-    size_t tokenIndex = 0;
-    bool hasTokens = false; // represents a dummy '-1' token index if false
-
-    // parsing functions for nodes:
-    std::unique_ptr<ast::Stmt> parseTopLevelDecl(bool mandatory);
-
-    // statements:
-    std::unique_ptr<ast::Stmt> parseStmt(bool mandatory);
-    std::unique_ptr<ast::Block> parseBlock(bool mandatory);
-    std::unique_ptr<ast::VarDecl> parseVarDecl(bool mandatory);
-    std::unique_ptr<ast::ParamDecl> parseParamDecl();
-    std::vector<std::unique_ptr<ast::ParamDecl>> parseParamDeclList();
-    std::unique_ptr<ast::FnDecl> parseFnDecl(bool mandatory);
-    std::unique_ptr<ast::Return> parseReturn(bool mandatory);
-    std::unique_ptr<ast::IfStmt> parseIfStmt(bool mandatory);
-    std::unique_ptr<ast::AssignStmt> parseAssignStmt(bool mandatory);
-
-    // expressions:
-    std::unique_ptr<ast::Expr> parseExpr(bool mandatory);
-    std::unique_ptr<ast::GroupedExpr> parseGroupedExpr(bool mandatory);
-    std::unique_ptr<ast::Identifier> parseIdentifier(bool mandatory);
-    std::unique_ptr<ast::Expr> parsePrimaryExpr(bool mandatory);
-    std::unique_ptr<ast::Expr> parsePrefixExpr(bool mandatory);
-    std::unique_ptr<ast::Expr> parseMultExpr(bool mandatory);
-    std::unique_ptr<ast::Expr> parseAddExpr(bool mandatory);
-    std::unique_ptr<ast::Expr> parseShiftExpr(bool mandatory);
-    std::unique_ptr<ast::Expr> parseBitExpr(bool mandatory);
-    std::unique_ptr<ast::Expr> parseCompareExpr(bool mandatory);
-    std::unique_ptr<ast::Expr> parseSuffixExpr(bool mandatory);
-    support::Optional<std::vector<std::unique_ptr<ast::Expr>>>
-    parseExprList(bool mandatory);
-    std::unique_ptr<ast::CallExpr> parseCallExpr(bool mandatory);
-
-    // operations:
-    ast::AssignOp parseAssignOp();
-    ast::PrefixOp parsePrefixOp();
-    ast::InfixOp parseMultOp();
-    ast::InfixOp parseAddOp();
-    ast::InfixOp parseShiftOp();
-    ast::InfixOp parseBitOp();
-    ast::InfixOp parseCompareOp();
-    ast::SuffixOp parseSuffixOp();
-
-    /// gets a token from the tokenizer and puts it into tokens
-    void fetchToken();
-
-    /// giving an iterator-like experience
-    // (peek, next, prev) for the streaming tokenizer
-    const Token& peekNextToken();
-    const Token& nextToken();
-    const Token& prevToken();
-
-    /// tries to consume a token of given kind, returns nullptr on fail
-    const Token* consumeToken(Token::Kind kind);
-
-    /// tries to consume a token which is one of given kinds,
-    /// returns nullptr on fail
-    template <typename... Ts> const Token* consumeOneOf(Ts... kinds);
-
-    /// Warning: this reference is only valid
-    /// until any new token is added into tokens
-    const Token& currentToken() { return tokens[tokenIndex]; }
-
-    const Token& getToken(size_t i) {
-        assert(i <= tokenIndex && hasTokens);
-        return tokens[i];
-    }
+    /// Parses the tokens of 'window' up to the one with the global index
+    /// 'last' again as the statements of a block, see ast::Tree::reparse
+    /// Returns false if they are not a sequence of whole statements,
+    /// throws like parseRoot on unrecoverable errors, which include
+    /// running out of the window.
+    bool reparseStmts(TokenWindow& window, size_t last,
+                      ast::NodeList<ast::Stmt>& stmts);
 
-    std::string tokenToString(size_t index) const;
-    uint64_t parseNumber(size_t index) const;
+    /// The same for top-level declarations
+    bool reparseDecls(TokenWindow& window, size_t last,
+                      ast::NodeList<ast::Stmt>& decls);
 
-    // Add error at the end of the specified token
-    void errorAtEnd(const std::string&& message, size_t token);
-
-    // Add error at the start of the specified token given byindex
-    void error(const std::string&& message, size_t token);
-
-    // Add error at the start of the specified token
-    void error(const std::string&& message, const Token& token);
-
-    // Add error to specific ast::Loc
-    void errorWithLoc(const std::string&& message, const ast::Loc&& loc);
+private:
+    ast::Tree& tree;
+    support::Timer* lexTimer;
+    bool pipelined;
 };
 
 } // namespace parser
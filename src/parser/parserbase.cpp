@@ -0,0 +1,449 @@
+#include "parserbase.hpp"
+
+#include <cstdlib>
+
+#include "../ast/expr.hpp"
+#include "../ast/stmt.hpp"
+#include "../ast/tree.hpp"
+
+#include "../support/memory.hpp"
+
+namespace perun {
+namespace parser {
+
+ParserBase::ParserBase(ast::Tree& tree, support::Timer* lexTimer,
+                       bool pipelined)
+    : tree(tree), source(tree.getSource()), tokens(tree.getTokensMut()),
+      diagnostics(tree.getDiagnosticsMut()), tokenizer(tree.getSource()),
+      lexTimer(lexTimer), pipeline(nullptr) {
+    if (pipelined) {
+        support::MemoryScope scope(support::MemoryPhase::Lexer);
+        pipeline = std::make_unique<TokenPipeline>(source, lexTimer);
+    }
+}
+
+ParserBase::ParserBase(ast::Tree& tree, TokenWindow& window)
+    : tree(tree), source(tree.getSource()), tokens(windowTokens),
+      diagnostics(tree.getDiagnosticsMut()), tokenizer(tree.getSource()),
+      lexTimer(nullptr), pipeline(nullptr), window(&window) {
+    // the token before the first one was already consumed
+    hasTokens = window.first > 0;
+    if (hasTokens) {
+        tokenBase = window.first - 1;
+        tokenIndex = tokenBase;
+        tokens.push_back(window.previous);
+    }
+}
+
+// AssignOp := '&=' | '=' | '>>=' | '<<=' | '-=' | '%=' | '|=' | '+=' | '/=' |
+//             '*='
+ast::AssignOp ParserBase::parseAssignOp() {
+    auto token = consumeOneOf(
+        Token::Kind::AmpersandEq, Token::Kind::Eq,
+        Token::Kind::GreaterGreaterEq, Token::Kind::LessLessEq,
+        Token::Kind::MinusEq, Token::Kind::PercentEq, Token::Kind::PipeEq,
+        Token::Kind::PlusEq, Token::Kind::SlashEq, Token::Kind::StarEq);
+
+    if (token == nullptr) {
+        return ast::AssignOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::AmpersandEq: {
+        return ast::AssignOp::AssignBitAnd;
+    }
+    case Token::Kind::Eq: {
+        return ast::AssignOp::Assign;
+    }
+    case Token::Kind::GreaterGreaterEq: {
+        return ast::AssignOp::AssignBitSHR;
+    }
+    case Token::Kind::LessLessEq: {
+        return ast::AssignOp::AssignBitSHL;
+    }
+    case Token::Kind::MinusEq: {
+        return ast::AssignOp::AssignSub;
+    }
+    case Token::Kind::PercentEq: {
+        return ast::AssignOp::AssignMod;
+    }
+    case Token::Kind::PipeEq: {
+        return ast::AssignOp::AssignBitOr;
+    }
+    case Token::Kind::PlusEq: {
+        return ast::AssignOp::AssignAdd;
+    }
+    case Token::Kind::SlashEq: {
+        return ast::AssignOp::AssignDiv;
+    }
+    case Token::Kind::StarEq: {
+        return ast::AssignOp::AssignMul;
+    }
+    default: { assert(false); }
+    }
+}
+
+// PrefixOp := '&' | '~' | '!' | '-' | '?'
+ast::PrefixOp ParserBase::parsePrefixOp() {
+    auto token = consumeOneOf(Token::Kind::Ampersand, Token::Kind::Tilde,
+                              Token::Kind::Bang, Token::Kind::Minus,
+                              Token::Kind::Question);
+    if (token == nullptr) {
+        return ast::PrefixOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::Ampersand: {
+        return ast::PrefixOp::Address;
+    }
+    case Token::Kind::Tilde: {
+        return ast::PrefixOp::BitNot;
+    }
+    case Token::Kind::Bang: {
+        return ast::PrefixOp::BoolNot;
+    }
+    case Token::Kind::Minus: {
+        return ast::PrefixOp::Negate;
+    }
+    case Token::Kind::Question: {
+        return ast::PrefixOp::OptionalType;
+    }
+    default: { assert(false); }
+    }
+}
+
+// MultOp := '/' | '%' | '*'
+ast::InfixOp ParserBase::parseMultOp() {
+    auto token = consumeOneOf(Token::Kind::Slash, Token::Kind::Percent,
+                              Token::Kind::Star);
+    if (token == nullptr) {
+        return ast::InfixOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::Slash: {
+        return ast::InfixOp::Div;
+    }
+    case Token::Kind::Percent: {
+        return ast::InfixOp::Mod;
+    }
+    case Token::Kind::Star: {
+        return ast::InfixOp::Mul;
+    }
+    default: { assert(false); }
+    }
+}
+
+// AddOp := '+' | '-'
+ast::InfixOp ParserBase::parseAddOp() {
+    auto token = consumeOneOf(Token::Kind::Plus, Token::Kind::Minus);
+    if (token == nullptr) {
+        return ast::InfixOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::Plus: {
+        return ast::InfixOp::Add;
+    }
+    case Token::Kind::Minus: {
+        return ast::InfixOp::Sub;
+    }
+    default: { assert(false); }
+    }
+}
+
+// ShiftOp := '>>' | '<<'
+ast::InfixOp ParserBase::parseShiftOp() {
+    auto token =
+        consumeOneOf(Token::Kind::GreaterGreater, Token::Kind::LessLess);
+    if (token == nullptr) {
+        return ast::InfixOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::GreaterGreater: {
+        return ast::InfixOp::BitSHR;
+    }
+    case Token::Kind::LessLess: {
+        return ast::InfixOp::BitSHL;
+    }
+    default: { assert(false); }
+    }
+}
+
+// BitOp := '&' | '|'
+ast::InfixOp ParserBase::parseBitOp() {
+    auto token = consumeOneOf(Token::Kind::Ampersand, Token::Kind::Pipe);
+    if (token == nullptr) {
+        return ast::InfixOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::Ampersand: {
+        return ast::InfixOp::BitAnd;
+    }
+    case Token::Kind::Pipe: {
+        return ast::InfixOp::BitOr;
+    }
+    default: { assert(false); }
+    }
+}
+
+// CompareOp := '==' | '>' | '>=' | '<' | '<=' | '!='
+ast::InfixOp ParserBase::parseCompareOp() {
+    auto token = consumeOneOf(Token::Kind::EqEq, Token::Kind::Greater,
+                              Token::Kind::GreaterEq, Token::Kind::Less,
+                              Token::Kind::LessEq, Token::Kind::BangEq);
+    if (token == nullptr) {
+        return ast::InfixOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::EqEq: {
+        return ast::InfixOp::EqualEqual;
+    }
+    case Token::Kind::Greater: {
+        return ast::InfixOp::Greater;
+    }
+    case Token::Kind::GreaterEq: {
+        return ast::InfixOp::GreaterEqual;
+    }
+    case Token::Kind::Less: {
+        return ast::InfixOp::Less;
+    }
+    case Token::Kind::LessEq: {
+        return ast::InfixOp::LessEqual;
+    }
+    case Token::Kind::BangEq: {
+        return ast::InfixOp::NotEqual;
+    }
+    default: { assert(false); }
+    }
+}
+
+// SuffixOp := '^' | '?'
+ast::SuffixOp ParserBase::parseSuffixOp() {
+    auto token = consumeOneOf(Token::Kind::Caret, Token::Kind::Question);
+    if (token == nullptr) {
+        return ast::SuffixOp::Invalid;
+    }
+
+    switch (token->getKind()) {
+    case Token::Kind::Caret: {
+        return ast::SuffixOp::Deref;
+    }
+    case Token::Kind::Question: {
+        return ast::SuffixOp::Unwrap;
+    }
+    default: { assert(false); }
+    }
+}
+
+void ParserBase::fetchToken() {
+    if (window != nullptr) {
+        fetchWindowToken();
+        return;
+    }
+
+    support::MemoryScope memory(support::MemoryPhase::Lexer);
+    Token token = lexToken();
+    while (token.is(Token::Kind::DocComment)) {
+        // belongs to the token after it, which gets the next index
+        tree.addDocComment(getTokensEnd(), token);
+        token = lexToken();
+    }
+
+    if (token.isNot(Token::Kind::Invalid)) {
+        // this possibly invalidates all ptrs/refs into tokens
+        tokens.push_back(token);
+        return;
+    }
+
+    // tokenizer had an error
+    if (pipeline != nullptr && pipeline->hasError()) {
+        error(pipeline->getError(), token);
+        throw 42;
+    }
+    if (pipeline == nullptr && tokenizer.hasError()) {
+        error(tokenizer.getError(), token);
+        throw 42;
+    }
+
+    // tokenizer produced a bad token
+    error(DiagID::InvalidToken, tokenIndex);
+    throw 42;
+}
+
+void ParserBase::fetchWindowToken() {
+    if (window->fetched < window->tokens.size()) {
+        tokens.push_back(window->tokens[window->fetched++]);
+        return;
+    }
+
+    // the same errors as a tokenizer stopping there, which counts
+    // as taking the invalid token
+    if (window->hasInvalid) {
+        window->fetched++;
+    }
+    if (window->hasInvalid && window->hasError) {
+        error(window->error, window->invalid);
+    } else if (window->hasInvalid) {
+        error(DiagID::InvalidToken, tokenIndex);
+    } else {
+        window->exceeded = true;
+    }
+    throw 42;
+}
+
+Token ParserBase::lexToken() {
+    if (pipeline != nullptr) {
+        return pipeline->nextToken();
+    }
+
+    support::TimerScope scope(lexTimer);
+    Token token = tokenizer.nextToken();
+    while (token.is(Token::Kind::LineComment)) {
+        token = tokenizer.nextToken();
+    }
+    return token;
+}
+
+void ParserBase::releaseTokens() {
+    if (!hasTokens) {
+        return;
+    }
+
+    // the current token stays, the parser may still step back onto it,
+    // so do the already fetched tokens after it
+    tokens.erase(tokens.begin(), tokens.begin() + (tokenIndex - tokenBase));
+    tokenBase = tokenIndex;
+}
+
+const Token& ParserBase::peekNextToken() {
+    if (!hasTokens) {
+        assert(tokenIndex == 0);
+        if (tokens.empty()) {
+            fetchToken();
+        }
+        return tokenAt(tokenIndex);
+    }
+
+    if ((tokenIndex + 1) < getTokensEnd()) {
+        return tokenAt(tokenIndex + 1);
+    }
+
+    // we need to stream a new token
+    fetchToken();
+
+    return tokenAt(tokenIndex + 1);
+}
+
+const Token& ParserBase::nextToken() {
+    if (!hasTokens) {
+        assert(tokenIndex == 0);
+        if (tokens.empty()) {
+            fetchToken();
+        }
+        hasTokens = true;
+        return tokenAt(tokenIndex);
+    }
+
+    tokenIndex++;
+
+    if (tokenIndex < getTokensEnd()) {
+        return tokenAt(tokenIndex);
+    }
+
+    // we need to stream a new token
+    fetchToken();
+
+    assert(tokenIndex < getTokensEnd() && "token index is out of bounds");
+
+    return tokenAt(tokenIndex);
+}
+
+const Token& ParserBase::prevToken() {
+    assert(tokenIndex > tokenBase && "token index is out of bounds");
+
+    tokenIndex--;
+    return tokenAt(tokenIndex);
+}
+
+const Token* ParserBase::consumeToken(Token::Kind kind) {
+    const Token& token = peekNextToken();
+
+    if (token.is(kind)) {
+        nextToken();
+        return &tokenAt(tokenIndex);
+    }
+
+    return nullptr;
+}
+
+template <typename... Ts> const Token* ParserBase::consumeOneOf(Ts... kinds) {
+    const Token& token = peekNextToken();
+
+    if (token.isOneOf(kinds...)) {
+        nextToken();
+        return &tokenAt(tokenIndex);
+    }
+
+    return nullptr;
+}
+
+// helper functions
+std::string ParserBase::tokenToString(size_t index) const {
+    assert(index >= tokenBase && index < getTokensEnd() &&
+           "cannot convert unbuffered token into string");
+
+    const Token& token = tokens[index - tokenBase];
+    return source.substr(token.start, token.length()).str();
+}
+
+uint64_t ParserBase::parseNumber(size_t index) const {
+    const std::string str = tokenToString(index);
+
+    // TODO: error handling
+    int radix = 10;
+    if (str[0] == '0' && str.size() >= 3) {
+        if (str[1] == 'b') {
+            radix = 2;
+        } else if (str[1] == 'o') {
+            radix = 8;
+        } else if (str[1] == 'x') {
+            radix = 16;
+        }
+    }
+
+    // TODO: this is an ugly hack - could we make it better?
+    const char* realStr = radix != 10 ? (str.c_str() + 2) : str.c_str();
+
+    return std::strtoll(realStr, nullptr, radix);
+}
+
+void ParserBase::errorAtEnd(DiagID id, size_t token) {
+    auto&& tok = getToken(token);
+    size_t endPos = tok.end;
+    ast::Loc loc = tree.getLocFromPos(endPos);
+    errorWithLoc(id, loc);
+}
+
+void ParserBase::error(DiagID id, size_t token,
+                       std::initializer_list<DiagArg> args) {
+    error(id, getToken(token), args);
+}
+
+void ParserBase::error(DiagID id, const Token& token,
+                       std::initializer_list<DiagArg> args) {
+    ast::Loc loc = tree.getLocFromToken(token);
+    errorWithLoc(id, loc, args);
+}
+
+void ParserBase::errorWithLoc(DiagID id, ast::Loc loc,
+                              std::initializer_list<DiagArg> args) {
+    // only a compact record is stored, the message is built when printed
+    diagnostics.report(id, loc, args);
+}
+
+} // namespace parser
+} // namespace perun
@@ -0,0 +1,181 @@
+#ifndef PERUN_PARSER_PARSERBASE_HPP
+#define PERUN_PARSER_PARSERBASE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../support/stringref.hpp"
+#include "../support/timer.hpp"
+
+#include "diagnostic.hpp"
+#include "token.hpp"
+#include "tokenizer.hpp"
+#include "tokenpipeline.hpp"
+
+namespace perun {
+
+// pre-declared as opaque to avoid unnecessary include
+namespace ast {
+class Tree;
+
+// pre-declared ops
+enum class AssignOp : short;
+enum class PrefixOp : short;
+enum class InfixOp : short;
+enum class SuffixOp : short;
+} // namespace ast
+
+namespace parser {
+
+/// Tokens lexed in advance for parsing a part of a source again,
+/// see ast::Tree::reparse
+/// The parser takes them instead of lexing and stops at their end.
+struct TokenWindow {
+    /// Global index of the first of 'tokens'
+    size_t first = 0;
+    /// The token before 'first', unless it is 0
+    Token previous{Token::Kind::Invalid, 0};
+    std::vector<Token> tokens{};
+
+    /// Set if lexing stopped at the bad token 'invalid' after 'tokens',
+    /// with the error of the tokenizer if it had one
+    bool hasInvalid = false;
+    Token invalid{Token::Kind::Invalid, 0};
+    bool hasError = false;
+    DiagID error = DiagID::InvalidToken;
+
+    /// Set by the parser: how many of 'tokens' it took,
+    /// reaching 'invalid' counts as one more
+    size_t fetched = 0;
+    /// ... and whether it needed more than there are
+    bool exceeded = false;
+};
+
+/// Token handling and error reporting of the recursive descent parser
+/// The grammar itself lives in parser::Grammar.
+class ParserBase {
+public:
+    /// Expects a tree with an empty root
+    /// Time spent in the tokenizer is accumulated into 'lexTimer'
+    /// if it is not null
+    /// If 'pipelined' is set, the source is tokenized ahead on another
+    /// thread (see TokenPipeline) and 'lexTimer' only gets the time
+    /// the parser waited for tokens.
+    ParserBase(ast::Tree& tree, support::Timer* lexTimer, bool pipelined);
+
+    /// Parses the tokens of 'window' instead of lexing the source of 'tree',
+    /// continuing after its 'previous' token
+    /// Running out of them is an unrecoverable error which marks
+    /// the window as exceeded.
+    ParserBase(ast::Tree& tree, TokenWindow& window);
+
+    /// Index of the last consumed token
+    size_t getTokenIndex() const { return tokenIndex; }
+
+    /// Index of the next token to be consumed
+    size_t getNextTokenIndex() const {
+        return hasTokens ? tokenIndex + 1 : 0;
+    }
+
+    /// Token indices are global, 'tokens' only holds the ones
+    /// from 'tokenBase' on (all of them unless streaming)
+    const Token& tokenAt(size_t i) const {
+        assert(i >= tokenBase && "token was already released");
+        return tokens[i - tokenBase];
+    }
+
+    std::string tokenToString(size_t index) const;
+    uint64_t parseNumber(size_t index) const;
+
+protected:
+    ast::Tree& tree;
+
+    const support::StringRef source;
+    // the tokens of the parser if it has a window, not of the tree
+    std::vector<Token> windowTokens;
+    std::vector<Token>& tokens;
+    DiagnosticsEngine& diagnostics;
+
+    Tokenizer tokenizer;
+    support::Timer* lexTimer;
+
+    // null unless pipelined, replaces 'tokenizer'
+    std::unique_ptr<TokenPipeline> pipeline;
+
+    // null unless parsing a part again, replaces both
+    TokenWindow* window = nullptr;
+
+    size_t tokenIndex = 0;
+    bool hasTokens = false; // represents a dummy '-1' token index if false
+
+    // global index of tokens[0]
+    size_t tokenBase = 0;
+
+    // operations:
+    ast::AssignOp parseAssignOp();
+    ast::PrefixOp parsePrefixOp();
+    ast::InfixOp parseMultOp();
+    ast::InfixOp parseAddOp();
+    ast::InfixOp parseShiftOp();
+    ast::InfixOp parseBitOp();
+    ast::InfixOp parseCompareOp();
+    ast::SuffixOp parseSuffixOp();
+
+    /// gets a token from the tokenizer and puts it into tokens
+    /// The doc comments in front of it are recorded in the tree.
+    void fetchToken();
+
+    /// fetchToken for a parser with a window
+    void fetchWindowToken();
+
+    /// next token of the tokenizer or the pipeline, line comments skipped
+    Token lexToken();
+
+    /// giving an iterator-like experience
+    // (peek, next, prev) for the streaming tokenizer
+    const Token& peekNextToken();
+    const Token& nextToken();
+    const Token& prevToken();
+
+    /// tries to consume a token of given kind, returns nullptr on fail
+    const Token* consumeToken(Token::Kind kind);
+
+    /// tries to consume a token which is one of given kinds,
+    /// returns nullptr on fail
+    template <typename... Ts> const Token* consumeOneOf(Ts... kinds);
+
+    /// Warning: this reference is only valid
+    /// until any new token is added into tokens
+    const Token& currentToken() { return tokenAt(tokenIndex); }
+
+    const Token& getToken(size_t i) {
+        assert(i <= tokenIndex && hasTokens);
+        return tokenAt(i);
+    }
+
+    size_t getTokensEnd() const { return tokenBase + tokens.size(); }
+
+    /// Drops the tokens before the current one
+    void releaseTokens();
+
+    // Add error at the end of the specified token
+    void errorAtEnd(DiagID id, size_t token);
+
+    // Add error at the start of the specified token given by index
+    void error(DiagID id, size_t token,
+               std::initializer_list<DiagArg> args = {});
+
+    // Add error at the start of the specified token
+    void error(DiagID id, const Token& token,
+               std::initializer_list<DiagArg> args = {});
+
+    // Add error to specific ast::Loc
+    void errorWithLoc(DiagID id, ast::Loc loc,
+                      std::initializer_list<DiagArg> args = {});
+};
+
+} // namespace parser
+} // namespace perun
+
+#endif // PERUN_PARSER_PARSERBASE_HPP
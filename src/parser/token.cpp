@@ -26,18 +26,18 @@ const char* getTokenName(Token::Kind kind) {
     }
 }
 
-bool isKeyword(const std::string& str) {
+bool isKeyword(support::StringRef str) {
     for (const Keyword& kw : keywords) {
-        if (kw.str == str) {
+        if (str == kw.str) {
             return true;
         }
     }
     return false;
 }
 
-Token::Kind getKeyword(const std::string& str) {
+Token::Kind getKeyword(support::StringRef str) {
     for (const Keyword& kw : keywords) {
-        if (kw.str == str) {
+        if (str == kw.str) {
             return kw.kind;
         }
     }
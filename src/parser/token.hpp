@@ -4,6 +4,8 @@
 #include <cassert>
 #include <string>
 
+#include "../support/stringref.hpp"
+
 namespace perun {
 namespace parser {
 
@@ -53,6 +55,19 @@ private:
 
 const char* getTokenName(Token::Kind kind);
 
+/// Number of token kinds, Token::Kind::Invalid excluded
+constexpr size_t tokenKindsCount = 0
+// This uses special macros defined in `tokenkinds.def`.
+// See that file for more details on how this works.
+#define TOKEN(kind, name) +1
+#define KEYWORD(kind, name) +1
+#define LITERAL(kind, name) +1
+#include "tokenkinds.def"
+#undef TOKEN
+#undef KEYWORD
+#undef LITERAL
+    ;
+
 // Thin wrapper to allow a keyword table
 struct Keyword {
     const char* str;
@@ -71,11 +86,11 @@ static const Keyword keywords[] = {
 #undef LITERAL
 };
 
-bool isKeyword(const std::string& str);
+bool isKeyword(support::StringRef str);
 
 /// Returns a keyword token kind if string is a keyword
 /// otherwise returns Token::Kind::Invalid
-Token::Kind getKeyword(const std::string& str);
+Token::Kind getKeyword(support::StringRef str);
 
 } // namespace parser
 } // namespace perun
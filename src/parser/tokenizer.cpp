@@ -20,7 +20,7 @@ inline bool isNumeric(const char c) { return c >= '0' && c <= '9'; }
 namespace perun {
 namespace parser {
 
-Tokenizer::Tokenizer(const std::string& input, size_t pos)
+Tokenizer::Tokenizer(support::StringRef input, size_t pos)
     : input(input), state(State::Invalid), pos(pos) {}
 
 Token Tokenizer::nextToken() {
@@ -33,10 +33,10 @@ Token Tokenizer::nextToken() {
     // - indicates when a token is complete so we can stop this loop
     bool complete = false;
 
-    // Note: this.error is for the very same purpose as complete
-    while (pos < input.size() && !complete && error.empty()) {
+    // Note: the error is for the very same purpose as complete
+    while (pos < input.size() && !complete && !hasError()) {
         // current char
-        const char c = input.at(pos);
+        const char c = input[pos];
 
         switch (state) {
         case State::Start: {
@@ -282,7 +282,7 @@ Token Tokenizer::nextToken() {
                 break;
             }
             case '\n': {
-                error = "newline is not allowed in a string!";
+                setError(DiagID::NewlineInString);
                 pos--;
                 break;
             }
@@ -301,7 +301,7 @@ Token Tokenizer::nextToken() {
             // TODO: handle escapes properly
             switch (c) {
             case '\n': {
-                error = "newline is not allowed in a string!";
+                setError(DiagID::NewlineInString);
                 pos--;
                 break;
             }
@@ -455,7 +455,7 @@ Token Tokenizer::nextToken() {
         }
         case State::GreaterGreater: {
             switch (c) {
-            case '>': { // >>=
+            case '=': { // >>=
                 token.setKind(Token::Kind::GreaterGreaterEq);
                 pos++;
                 complete = true;
@@ -493,7 +493,7 @@ Token Tokenizer::nextToken() {
         }
         case State::LessLess: {
             switch (c) {
-            case '<': { // <<=
+            case '=': { // <<=
                 token.setKind(Token::Kind::LessLessEq);
                 pos++;
                 complete = true;
@@ -708,10 +708,8 @@ Token Tokenizer::nextToken() {
                 break;
             }
 
-            // TODO: figure out a way to make a slice / a reference to input
-            const std::string& buffer =
-                input.substr(token.start, pos - token.start);
-            const auto keywordKind = getKeyword(buffer);
+            const auto keywordKind =
+                getKeyword(input.substr(token.start, pos - token.start));
 
             if (keywordKind != Token::Kind::Invalid) {
                 token.setKind(keywordKind);
@@ -789,7 +787,7 @@ Token Tokenizer::nextToken() {
             break;
         }
         case State::OctalInteger: {
-            constexpr auto isOctal = [](const char c) -> bool {
+            const auto isOctal = [](const char c) -> bool {
                 return c >= '0' && c <= '7';
             };
 
@@ -801,7 +799,7 @@ Token Tokenizer::nextToken() {
             break;
         }
         case State::HexInteger: {
-            constexpr auto isHexadecimal = [](const char c) -> bool {
+            const auto isHexadecimal = [](const char c) -> bool {
                 return isNumeric(c) || (c >= 'A' && c <= 'F');
             };
 
@@ -825,7 +823,7 @@ Token Tokenizer::nextToken() {
 
     // if we have reached the end of the input and still haven't finalized a
     // single token:
-    if (pos == input.size() && !complete && error.empty()) {
+    if (pos == input.size() && !complete && !hasError()) {
         // finalize tokens
         switch (state) {
 
@@ -926,10 +924,8 @@ Token Tokenizer::nextToken() {
 
         case State::Identifier: {
             // TODO: deduplicate this?
-            // TODO: figure out a way to make a slice / a reference to input
-            const std::string& buffer =
-                input.substr(token.start, pos - token.start);
-            const auto keywordKind = getKeyword(buffer);
+            const auto keywordKind =
+                getKeyword(input.substr(token.start, pos - token.start));
 
             if (keywordKind != Token::Kind::Invalid) {
                 token.setKind(keywordKind);
@@ -949,7 +945,7 @@ Token Tokenizer::nextToken() {
 
         // error cases
         case State::StringEscape: {
-            error = "trailing escape in string!";
+            setError(DiagID::TrailingEscapeInString);
             pos--;
             break;
         }
@@ -959,7 +955,7 @@ Token Tokenizer::nextToken() {
         }
     }
 
-    if (!error.empty()) {
+    if (hasError()) {
         Token invalidToken = Token(Token::Kind::Invalid, pos);
         invalidToken.end = pos;
         return invalidToken;
@@ -970,10 +966,11 @@ Token Tokenizer::nextToken() {
 }
 
 void Tokenizer::dumpToken(const Token& token) const {
-    // TODO: this copies for no real reason
-    const std::string source = input.substr(token.start, token.length());
-    std::cerr << getTokenName(token.getKind()) << " \"" << source << "\""
-              << std::endl;
+    const support::StringRef source =
+        input.substr(token.start, token.length());
+    std::cerr << getTokenName(token.getKind()) << " \"";
+    std::cerr.write(source.data(), source.size());
+    std::cerr << "\"" << std::endl;
 }
 
 } // namespace parser
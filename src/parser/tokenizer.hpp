@@ -5,8 +5,11 @@
 #include <memory>
 #include <vector>
 
+#include "diagnostic.hpp"
 #include "token.hpp"
 
+#include "../support/stringref.hpp"
+
 namespace perun {
 namespace parser {
 
@@ -14,7 +17,7 @@ namespace parser {
 class Tokenizer {
 
 public:
-    explicit Tokenizer(const std::string& input, size_t pos = 0);
+    explicit Tokenizer(support::StringRef input, size_t pos = 0);
 
     /// Returns next found token
     /// Last token will have kind 'Token::Kind::EndOfFile'
@@ -25,10 +28,16 @@ public:
     // from this 'input'
     void dumpToken(const Token& token) const;
 
-    const std::string& getError() const { return error; }
+    bool hasError() const { return _hasError; }
+
+    /// Asserts there is an error
+    DiagID getError() const {
+        assert(_hasError);
+        return error;
+    }
 
 private:
-    const std::string& input;
+    const support::StringRef input;
 
     enum class State {
         Invalid = -1,
@@ -79,8 +88,14 @@ private:
     /// current position in the input
     size_t pos;
 
+    void setError(DiagID id) {
+        error = id;
+        _hasError = true;
+    }
+
     /// current error
-    std::string error = "";
+    DiagID error = DiagID::InvalidToken;
+    bool _hasError = false;
 };
 
 } // namespace parser
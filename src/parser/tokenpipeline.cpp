@@ -0,0 +1,117 @@
+#include "tokenpipeline.hpp"
+
+#include "tokenizer.hpp"
+
+#include "../support/memory.hpp"
+#include "../support/trace.hpp"
+
+namespace perun {
+namespace parser {
+
+namespace {
+
+/// Spins for a while before giving the core away,
+/// the other side is usually just a few tokens behind
+void backoff(size_t& spins) {
+    if (++spins < 64) {
+        return;
+    }
+    std::this_thread::yield();
+}
+
+} // namespace
+
+TokenPipeline::TokenPipeline(support::StringRef input,
+                             support::Timer* waitTimer)
+    : input(input), waitTimer(waitTimer),
+      ring(ringCapacity, Token(Token::Kind::Invalid, 0)) {
+    batch.reserve(batchSize);
+    producer = std::thread([this]() { produce(); });
+}
+
+TokenPipeline::~TokenPipeline() {
+    stopping.store(true, std::memory_order_relaxed);
+    producer.join();
+}
+
+void TokenPipeline::produce() {
+    support::TraceScope trace("lex ahead");
+    support::MemoryScope memory(support::MemoryPhase::Lexer);
+    Tokenizer tokenizer(input);
+    std::vector<Token> pending{};
+    pending.reserve(batchSize);
+
+    bool last = false;
+    while (!last) {
+        Token token = tokenizer.nextToken();
+
+        // line comments are skipped here instead of in the parser,
+        // doc comments are recorded by it
+        if (token.is(Token::Kind::LineComment)) {
+            continue;
+        }
+
+        last = token.isOneOf(Token::Kind::EndOfFile, Token::Kind::Invalid);
+        if (token.is(Token::Kind::Invalid) && tokenizer.hasError()) {
+            // the release in SPSCRing::push publishes these
+            error = tokenizer.getError();
+            _hasError = true;
+        }
+
+        pending.push_back(token);
+        if (pending.size() < batchSize && !last) {
+            continue;
+        }
+
+        size_t pushed = 0;
+        size_t spins = 0;
+        while (pushed < pending.size()) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                return;
+            }
+
+            size_t count =
+                ring.push(pending.data() + pushed, pending.size() - pushed);
+            if (count == 0) {
+                backoff(spins);
+            }
+            pushed += count;
+        }
+        pending.clear();
+    }
+}
+
+void TokenPipeline::refill() {
+    batch.resize(batchSize, Token(Token::Kind::Invalid, 0));
+    size_t popped = ring.pop(batch.data(), batchSize);
+    if (popped == 0) {
+        // the producer has fallen behind, this is the lexing
+        // that didn't overlap with parsing
+        support::TimerScope scope(waitTimer);
+        size_t spins = 0;
+        while (popped == 0) {
+            backoff(spins);
+            popped = ring.pop(batch.data(), batchSize);
+        }
+    }
+
+    batch.resize(popped, Token(Token::Kind::Invalid, 0));
+    batchPos = 0;
+}
+
+Token TokenPipeline::nextToken() {
+    if (finished) {
+        return batch[batchPos - 1];
+    }
+
+    if (batchPos == batch.size()) {
+        refill();
+    }
+
+    const Token& token = batch[batchPos++];
+    finished = token.isOneOf(Token::Kind::EndOfFile, Token::Kind::Invalid);
+    return token;
+}
+
+} // namespace parser
+} // namespace perun
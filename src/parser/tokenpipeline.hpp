@@ -0,0 +1,74 @@
+#ifndef PERUN_PARSER_TOKENPIPELINE_HPP
+#define PERUN_PARSER_TOKENPIPELINE_HPP
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "diagnostic.hpp"
+#include "token.hpp"
+
+#include "../support/spscring.hpp"
+#include "../support/stringref.hpp"
+#include "../support/timer.hpp"
+
+namespace perun {
+namespace parser {
+
+/// Tokenizes 'input' on its own thread ahead of the parser
+///
+/// The tokens (without line comments) are handed over through
+/// a support::SPSCRing, so lexing overlaps with parsing.
+/// The producer stops after the EndOfFile or the first Invalid token,
+/// or when the pipeline is destroyed.
+class TokenPipeline {
+public:
+    /// Time the consumer spends waiting for tokens is added to 'waitTimer'
+    /// if it is not null
+    explicit TokenPipeline(support::StringRef input,
+                           support::Timer* waitTimer = nullptr);
+    ~TokenPipeline();
+
+    TokenPipeline(const TokenPipeline&) = delete;
+    TokenPipeline& operator=(const TokenPipeline&) = delete;
+
+    /// Returns the next token, waits for the producer if there is none
+    /// The last token is returned again once it was reached.
+    Token nextToken();
+
+    /// Valid after the Invalid token was returned
+    bool hasError() const { return _hasError; }
+    DiagID getError() const {
+        assert(_hasError);
+        return error;
+    }
+
+private:
+    static constexpr size_t ringCapacity = 4096;
+    static constexpr size_t batchSize = 256;
+
+    const support::StringRef input;
+    support::Timer* waitTimer;
+
+    support::SPSCRing<Token> ring;
+    std::atomic<bool> stopping{false};
+
+    // published together with the last token
+    DiagID error = DiagID::InvalidToken;
+    bool _hasError = false;
+
+    // consumer side
+    std::vector<Token> batch;
+    size_t batchPos = 0;
+    bool finished = false;
+
+    std::thread producer;
+
+    void produce();
+    void refill();
+};
+
+} // namespace parser
+} // namespace perun
+
+#endif // PERUN_PARSER_TOKENPIPELINE_HPP
@@ -1,16 +1,27 @@
+#include "../driver/daemon.hpp"
 #include "../driver/driver.hpp"
-#include "../driver/error.hpp"
+#include "../driver/watch.hpp"
 
-#include "../support/error.hpp"
-
-#include <cassert>
 #include <iostream>
-#include <utility>
+#include <string>
+#include <vector>
 
 using namespace perun;
 
 static void printUsage() {
-    std::cout << "Usage: perun [-h/--help] [-v/--verbose] <input>" << std::endl;
+    std::cout << "Usage: perun [-h/--help] [-v/--verbose] [--stats]\n"
+                 "             [--time-report[=table|json]]\n"
+                 "             [--trace=<out.json>] [--memory-report]\n"
+                 "             [--pipeline] [--cache-dir=<dir>]\n"
+                 "             [--cache-size=<bytes>] [--error-limit=<n>]\n"
+                 "             [--dump-ast=json|binary]\n"
+                 "             [--dump-tokens[=json|binary]]\n"
+                 "             [--jobs=<n>] <inputs...|@file>\n"
+                 "       perun --watch=<dir> [options]\n"
+                 "       perun --daemon=<socket>\n"
+                 "       perun --connect=<socket> [options] <inputs...>\n"
+                 "       perun --connect=<socket> --shutdown"
+              << std::endl;
 }
 
 int main(int argc, char* argv[]) {
@@ -23,29 +34,31 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    auto&& result = driver::build(args);
-
-    switch (result.getKind()) {
-    case driver::BuildResult::Kind::Invalid: {
-        assert(false);
-    }
-    case driver::BuildResult::Kind::DError: {
-        auto&& err = result.moveError();
-        std::cerr << err->getMessage();
-        return 1;
-    }
-    case driver::BuildResult::Kind::Tree: {
-        auto&& tree = result.moveTree();
-        assert(tree != nullptr);
-        if (tree->hasErrors()) {
-            for (auto&& err : tree->getErrors()) {
-                std::cerr << err->getMessage() << std::endl;
+    // the daemon, its client and the watch mode are handled before anything
+    // else, the rest of the arguments are passed to them as they are
+    const std::string daemonPrefix = "--daemon=";
+    const std::string connectPrefix = "--connect=";
+    const std::string watchPrefix = "--watch=";
+    for (auto&& it = args.begin(); it != args.end(); ++it) {
+        if (it->compare(0, daemonPrefix.size(), daemonPrefix) == 0) {
+            if (args.size() != 1) {
+                std::cerr << "perun: error: '--daemon' takes no other "
+                             "arguments\n";
+                return 1;
             }
-            return 1;
+            return driver::runDaemon(it->substr(daemonPrefix.size()));
+        }
+        if (it->compare(0, connectPrefix.size(), connectPrefix) == 0) {
+            const std::string socketPath = it->substr(connectPrefix.size());
+            args.erase(it);
+            return driver::runClient(socketPath, args);
+        }
+        if (it->compare(0, watchPrefix.size(), watchPrefix) == 0) {
+            const std::string directory = it->substr(watchPrefix.size());
+            args.erase(it);
+            return driver::runWatch(directory, args);
         }
-        return 0;
-    }
     }
 
-    return 1;
+    return driver::run(args);
 }
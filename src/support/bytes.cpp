@@ -0,0 +1,69 @@
+#include "bytes.hpp"
+
+namespace perun {
+namespace support {
+
+void ByteWriter::writeVarint(uint64_t value) {
+    while (value >= 0x80) {
+        writeByte(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    writeByte(static_cast<uint8_t>(value));
+}
+
+void ByteWriter::writeFixed64(uint64_t value) {
+    for (size_t i = 0; i < 8; ++i) {
+        writeByte(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+void ByteWriter::writeString(const std::string& str) {
+    writeVarint(str.size());
+    out.append(str);
+}
+
+uint8_t ByteReader::readByte() {
+    if (_failed || pos >= length) {
+        _failed = true;
+        return 0;
+    }
+    return static_cast<uint8_t>(data[pos++]);
+}
+
+uint64_t ByteReader::readVarint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        uint8_t byte = readByte();
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+
+    // too many continuation bytes
+    _failed = true;
+    return 0;
+}
+
+uint64_t ByteReader::readFixed64() {
+    uint64_t value = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(readByte()) << (8 * i);
+    }
+    return value;
+}
+
+std::string ByteReader::readString() {
+    uint64_t size = readVarint();
+    if (_failed || size > length - pos) {
+        _failed = true;
+        return "";
+    }
+
+    std::string str(data + pos, size);
+    pos += size;
+    return str;
+}
+
+} // namespace support
+} // namespace perun
@@ -0,0 +1,60 @@
+#ifndef PERUN_SUPPORT_BYTES_HPP
+#define PERUN_SUPPORT_BYTES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace perun {
+namespace support {
+
+/// Appends a compact binary encoding into a string
+/// Integers are stored as LEB128 varints
+class ByteWriter {
+public:
+    explicit ByteWriter(std::string& out) : out(out) {}
+
+    void writeByte(uint8_t byte) { out.push_back(static_cast<char>(byte)); }
+    void writeBool(bool value) { writeByte(value ? 1 : 0); }
+    void writeVarint(uint64_t value);
+    void writeFixed64(uint64_t value);
+    void writeString(const std::string& str);
+    void writeBytes(const char* data, size_t length) {
+        out.append(data, length);
+    }
+
+    size_t size() const { return out.size(); }
+
+private:
+    std::string& out;
+};
+
+/// Reads what ByteWriter wrote
+/// Never reads out of bounds, after the first malformed read
+/// all other reads return zeroes and 'failed()' is true
+class ByteReader {
+public:
+    ByteReader(const char* data, size_t length)
+        : data(data), length(length), pos(0), _failed(false) {}
+
+    uint8_t readByte();
+    bool readBool() { return readByte() != 0; }
+    uint64_t readVarint();
+    uint64_t readFixed64();
+    std::string readString();
+
+    bool failed() const { return _failed; }
+    bool atEnd() const { return pos == length; }
+    size_t remaining() const { return length - pos; }
+
+private:
+    const char* data;
+    size_t length;
+    size_t pos;
+    bool _failed;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_BYTES_HPP
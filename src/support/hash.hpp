@@ -0,0 +1,50 @@
+#ifndef PERUN_SUPPORT_HASH_HPP
+#define PERUN_SUPPORT_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace perun {
+namespace support {
+
+/// 64-bit non-cryptographic hash of a byte range (XXH64 algorithm)
+uint64_t hash64(const void* data, size_t length, uint64_t seed = 0);
+
+inline uint64_t hash64(const std::string& str, uint64_t seed = 0) {
+    return hash64(str.data(), str.size(), seed);
+}
+
+/// Mixes two hashes together, the order matters
+inline uint64_t hashCombine(uint64_t h, uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+/// Formats a hash as 16 lowercase hex digits
+std::string hashToHex(uint64_t hash);
+
+struct Hash128 {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const Hash128& other) const {
+        return low == other.low && high == other.high;
+    }
+    bool operator!=(const Hash128& other) const { return !(*this == other); }
+    bool operator<(const Hash128& other) const {
+        return high != other.high ? high < other.high : low < other.low;
+    }
+};
+
+/// 128-bit hash of a byte range, two XXH64 runs with independent seeds
+/// For telling contents apart, where 64 bits collide too soon.
+Hash128 hash128(const void* data, size_t length);
+
+/// Formats a hash as 32 lowercase hex digits
+std::string hashToHex(const Hash128& hash);
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_HASH_HPP
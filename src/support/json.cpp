@@ -0,0 +1,399 @@
+#include "json.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+namespace perun {
+namespace support {
+
+namespace {
+
+const char hexDigits[] = "0123456789abcdef";
+
+} // namespace
+
+void writeJSONString(OutputBuffer& out, StringRef str) {
+    out << '"';
+
+    // copy runs of characters that don't need escaping at once
+    size_t runStart = 0;
+    for (size_t i = 0; i < str.size(); ++i) {
+        auto c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        out.write(str.data() + runStart, i - runStart);
+        runStart = i + 1;
+
+        switch (c) {
+        case '"': {
+            out << "\\\"";
+            break;
+        }
+        case '\\': {
+            out << "\\\\";
+            break;
+        }
+        case '\n': {
+            out << "\\n";
+            break;
+        }
+        case '\t': {
+            out << "\\t";
+            break;
+        }
+        default: {
+            const char escape[] = {'\\', 'u', '0', '0', hexDigits[c >> 4],
+                                   hexDigits[c & 0xf]};
+            out.write(escape, sizeof(escape));
+            break;
+        }
+        }
+    }
+    out.write(str.data() + runStart, str.size() - runStart);
+
+    out << '"';
+}
+
+JSONValue JSONValue::makeBool(bool value) {
+    JSONValue result{};
+    result.kind = Kind::Bool;
+    result.boolean = value;
+    return result;
+}
+
+JSONValue JSONValue::makeNumber(double value) {
+    JSONValue result{};
+    result.kind = Kind::Number;
+    result.number = value;
+    return result;
+}
+
+JSONValue JSONValue::makeString(std::string value) {
+    JSONValue result{};
+    result.kind = Kind::String;
+    result.string = std::move(value);
+    return result;
+}
+
+const std::string& JSONValue::getString() const {
+    static const std::string empty{};
+    return kind == Kind::String ? string : empty;
+}
+
+const std::vector<JSONValue>& JSONValue::getArray() const {
+    static const std::vector<JSONValue> empty{};
+    return kind == Kind::Array ? array : empty;
+}
+
+const std::vector<JSONValue::Member>& JSONValue::getMembers() const {
+    static const std::vector<Member> empty{};
+    return kind == Kind::Object ? members : empty;
+}
+
+const JSONValue& JSONValue::get(StringRef key) const {
+    static const JSONValue null{};
+    for (auto&& member : getMembers()) {
+        if (StringRef(member.first) == key) {
+            return member.second;
+        }
+    }
+    return null;
+}
+
+void JSONValue::write(OutputBuffer& out) const {
+    switch (kind) {
+    case Kind::Null: {
+        out << "null";
+        break;
+    }
+    case Kind::Bool: {
+        out << (boolean ? "true" : "false");
+        break;
+    }
+    case Kind::Number: {
+        // protocol numbers are mostly integers (ids, positions)
+        if (number == std::floor(number) && std::fabs(number) < 1e15) {
+            if (number < 0) {
+                out << '-';
+            }
+            out.writeUnsigned(static_cast<uint64_t>(std::fabs(number)));
+        } else {
+            out << std::to_string(number);
+        }
+        break;
+    }
+    case Kind::String: {
+        writeJSONString(out, string);
+        break;
+    }
+    case Kind::Array: {
+        out << '[';
+        for (size_t i = 0; i < array.size(); ++i) {
+            out << (i == 0 ? "" : ",");
+            array[i].write(out);
+        }
+        out << ']';
+        break;
+    }
+    case Kind::Object: {
+        out << '{';
+        for (size_t i = 0; i < members.size(); ++i) {
+            out << (i == 0 ? "" : ",");
+            writeJSONString(out, members[i].first);
+            out << ':';
+            members[i].second.write(out);
+        }
+        out << '}';
+        break;
+    }
+    }
+}
+
+/// Recursive descent parser of JSONValue
+class JSONParser {
+public:
+    explicit JSONParser(StringRef text) : text(text) {}
+
+    bool parseDocument(JSONValue& result) {
+        if (!parseValue(result, 0)) {
+            return false;
+        }
+        skipWhitespace();
+        return pos == text.size();
+    }
+
+private:
+    // guards the stack against deeply nested input
+    static constexpr size_t maxDepth = 256;
+
+    void skipWhitespace() {
+        while (pos < text.size() &&
+               (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' ||
+                text[pos] == '\r')) {
+            ++pos;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (pos < text.size() && text[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeWord(const char* word) {
+        StringRef ref(word);
+        if (text.substr(pos, ref.size()) != ref) {
+            return false;
+        }
+        pos += ref.size();
+        return true;
+    }
+
+    bool parseValue(JSONValue& result, size_t depth) {
+        skipWhitespace();
+        if (pos >= text.size() || depth > maxDepth) {
+            return false;
+        }
+
+        switch (text[pos]) {
+        case 'n': {
+            result.kind = JSONValue::Kind::Null;
+            return consumeWord("null");
+        }
+        case 't': {
+            result = JSONValue::makeBool(true);
+            return consumeWord("true");
+        }
+        case 'f': {
+            result = JSONValue::makeBool(false);
+            return consumeWord("false");
+        }
+        case '"': {
+            result.kind = JSONValue::Kind::String;
+            return parseString(result.string);
+        }
+        case '[': {
+            ++pos;
+            result.kind = JSONValue::Kind::Array;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                result.array.emplace_back();
+                if (!parseValue(result.array.back(), depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+        case '{': {
+            ++pos;
+            result.kind = JSONValue::Kind::Object;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                result.members.emplace_back();
+                auto&& member = result.members.back();
+                skipWhitespace();
+                if (!parseString(member.first) || !consume(':') ||
+                    !parseValue(member.second, depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+        default: { return parseNumber(result); }
+        }
+    }
+
+    bool parseNumber(JSONValue& result) {
+        // strtod would accept more than JSON does, check the characters first
+        size_t end = pos;
+        while (end < text.size() &&
+               ((text[end] >= '0' && text[end] <= '9') || text[end] == '-' ||
+                text[end] == '+' || text[end] == '.' || text[end] == 'e' ||
+                text[end] == 'E')) {
+            ++end;
+        }
+        if (end == pos) {
+            return false;
+        }
+
+        const std::string digits = text.substr(pos, end - pos).str();
+        char* parsedEnd = nullptr;
+        result = JSONValue::makeNumber(std::strtod(digits.c_str(), &parsedEnd));
+        pos = end;
+        return *parsedEnd == '\0';
+    }
+
+    bool parseHex4(uint32_t& value) {
+        if (pos + 4 > text.size()) {
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            char c = text[pos++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                value |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                value |= c - 'A' + 10;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void appendUTF8(std::string& out, uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        } else if (codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else if (codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        if (pos >= text.size() || text[pos] != '"') {
+            return false;
+        }
+        ++pos;
+
+        for (;;) {
+            // copy runs of plain characters at once
+            size_t runStart = pos;
+            while (pos < text.size() && text[pos] != '"' && text[pos] != '\\') {
+                ++pos;
+            }
+            out.append(text.data() + runStart, pos - runStart);
+
+            if (pos >= text.size()) {
+                return false;
+            }
+            if (text[pos++] == '"') {
+                return true;
+            }
+            if (pos >= text.size()) {
+                return false;
+            }
+
+            char escaped = text[pos++];
+            switch (escaped) {
+            case '"':
+            case '\\':
+            case '/': {
+                out += escaped;
+                break;
+            }
+            case 'b': {
+                out += '\b';
+                break;
+            }
+            case 'f': {
+                out += '\f';
+                break;
+            }
+            case 'n': {
+                out += '\n';
+                break;
+            }
+            case 'r': {
+                out += '\r';
+                break;
+            }
+            case 't': {
+                out += '\t';
+                break;
+            }
+            case 'u': {
+                uint32_t codePoint = 0;
+                if (!parseHex4(codePoint)) {
+                    return false;
+                }
+                // a surrogate pair encodes a code point outside of the BMP
+                if (codePoint >= 0xD800 && codePoint < 0xDC00 &&
+                    consumeWord("\\u")) {
+                    uint32_t low = 0;
+                    if (!parseHex4(low) || low < 0xDC00 || low >= 0xE000) {
+                        return false;
+                    }
+                    codePoint =
+                        0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                }
+                appendUTF8(out, codePoint);
+                break;
+            }
+            default: { return false; }
+            }
+        }
+    }
+
+    StringRef text;
+    size_t pos = 0;
+};
+
+bool JSONValue::parse(StringRef text, JSONValue& result) {
+    result = JSONValue();
+    return JSONParser(text).parseDocument(result);
+}
+
+} // namespace support
+} // namespace perun
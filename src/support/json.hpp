@@ -0,0 +1,68 @@
+#ifndef PERUN_SUPPORT_JSON_HPP
+#define PERUN_SUPPORT_JSON_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "output.hpp"
+#include "stringref.hpp"
+
+namespace perun {
+namespace support {
+
+/// Writes 'str' as a quoted JSON string, escaping what has to be escaped
+void writeJSONString(OutputBuffer& out, StringRef str);
+
+/// A parsed JSON document, meant for small protocol messages
+///
+/// Objects keep their members in the order of the input and are
+/// searched linearly. Accessors of a wrong kind return an empty value
+/// instead of failing, so optional members can be read without checks.
+class JSONValue {
+public:
+    enum class Kind : uint8_t { Null, Bool, Number, String, Array, Object };
+
+    using Member = std::pair<std::string, JSONValue>;
+
+    JSONValue() : kind(Kind::Null) {}
+
+    static JSONValue makeBool(bool value);
+    static JSONValue makeNumber(double value);
+    static JSONValue makeString(std::string value);
+
+    Kind getKind() const { return kind; }
+    bool is(Kind k) const { return kind == k; }
+
+    bool getBool() const { return kind == Kind::Bool && boolean; }
+    double getNumber() const { return kind == Kind::Number ? number : 0; }
+    int64_t getInteger() const { return static_cast<int64_t>(getNumber()); }
+    const std::string& getString() const;
+    const std::vector<JSONValue>& getArray() const;
+    const std::vector<Member>& getMembers() const;
+
+    /// Returns the member 'key' of an object, a null value if there's none
+    const JSONValue& get(StringRef key) const;
+
+    /// Parses a complete JSON document, returns false on malformed input
+    static bool parse(StringRef text, JSONValue& result);
+
+    /// Writes the value back as compact JSON
+    void write(OutputBuffer& out) const;
+
+private:
+    friend class JSONParser;
+
+    Kind kind;
+    bool boolean = false;
+    double number = 0;
+    std::string string{};
+    std::vector<JSONValue> array{};
+    std::vector<Member> members{};
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_JSON_HPP
@@ -0,0 +1,190 @@
+#include "memory.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <new>
+
+namespace perun {
+namespace support {
+
+const char* getMemoryPhaseName(MemoryPhase phase) {
+    switch (phase) {
+// This uses special macros defined in `memoryphases.def`.
+// See that file for more details on how this works.
+#define MEMORY_PHASE(kind, name)                                               \
+    case MemoryPhase::kind:                                                    \
+        return name;
+#include "memoryphases.def"
+#undef MEMORY_PHASE
+    }
+    assert(false);
+    return "";
+}
+
+#ifdef PERUN_MEMORY_TRACKING
+
+namespace {
+
+struct Slot {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> live{0};
+    std::atomic<uint64_t> peak{0};
+
+    void add(uint64_t size) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        uint64_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+        uint64_t max = peak.load(std::memory_order_relaxed);
+        while (now > max &&
+               !peak.compare_exchange_weak(max, now,
+                                           std::memory_order_relaxed)) {
+        }
+    }
+
+    void remove(uint64_t size) {
+        live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    MemoryTracker::Counters get() const {
+        MemoryTracker::Counters counters{};
+        counters.count = count.load(std::memory_order_relaxed);
+        counters.bytes = bytes.load(std::memory_order_relaxed);
+        counters.peak = peak.load(std::memory_order_relaxed);
+        return counters;
+    }
+};
+
+// a tag is 'phase * detailCount + detail'
+constexpr size_t tagCount =
+    MemoryTracker::phaseCount * MemoryTracker::detailCount;
+
+Slot totalSlot;
+Slot phaseSlots[MemoryTracker::phaseCount];
+Slot tagSlots[tagCount];
+
+thread_local uint16_t currentTag = 0;
+
+// keeps the returned memory aligned like malloc's
+struct alignas(alignof(std::max_align_t)) Header {
+    size_t size;
+    uint16_t tag;
+};
+
+void* allocate(size_t size) {
+    auto header = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+    if (header == nullptr) {
+        return nullptr;
+    }
+
+    header->size = size;
+    header->tag = currentTag;
+    totalSlot.add(size);
+    phaseSlots[currentTag / MemoryTracker::detailCount].add(size);
+    tagSlots[currentTag].add(size);
+    return header + 1;
+}
+
+void deallocate(void* pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+
+    auto header = static_cast<Header*>(pointer) - 1;
+    totalSlot.remove(header->size);
+    phaseSlots[header->tag / MemoryTracker::detailCount].remove(header->size);
+    tagSlots[header->tag].remove(header->size);
+    std::free(header);
+}
+
+} // namespace
+
+MemoryScope::MemoryScope(MemoryPhase phase, size_t detail)
+    : previous(currentTag) {
+    assert(detail < MemoryTracker::detailCount);
+    currentTag = static_cast<uint16_t>(static_cast<size_t>(phase) *
+                                           MemoryTracker::detailCount +
+                                       detail);
+}
+
+MemoryScope::~MemoryScope() { currentTag = previous; }
+
+bool MemoryTracker::isEnabled() { return true; }
+
+MemoryTracker::Counters MemoryTracker::getTotal() { return totalSlot.get(); }
+
+MemoryTracker::Counters MemoryTracker::get(MemoryPhase phase) {
+    return phaseSlots[static_cast<size_t>(phase)].get();
+}
+
+MemoryTracker::Counters MemoryTracker::get(MemoryPhase phase, size_t detail) {
+    assert(detail < detailCount);
+    return tagSlots[static_cast<size_t>(phase) * detailCount + detail].get();
+}
+
+} // namespace support
+} // namespace perun
+
+void* operator new(size_t size) {
+    if (void* pointer = perun::support::allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* pointer = perun::support::allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return perun::support::allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return perun::support::allocate(size);
+}
+
+void operator delete(void* pointer) noexcept {
+    perun::support::deallocate(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+    perun::support::deallocate(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    perun::support::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept {
+    perun::support::deallocate(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    perun::support::deallocate(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    perun::support::deallocate(pointer);
+}
+
+#else
+
+bool MemoryTracker::isEnabled() { return false; }
+
+MemoryTracker::Counters MemoryTracker::getTotal() { return Counters(); }
+
+MemoryTracker::Counters MemoryTracker::get(MemoryPhase) { return Counters(); }
+
+MemoryTracker::Counters MemoryTracker::get(MemoryPhase, size_t) {
+    return Counters();
+}
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_MEMORY_TRACKING
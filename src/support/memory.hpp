@@ -0,0 +1,82 @@
+#ifndef PERUN_SUPPORT_MEMORY_HPP
+#define PERUN_SUPPORT_MEMORY_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace perun {
+namespace support {
+
+/// Parts of perun the allocations are attributed to
+enum class MemoryPhase : uint8_t {
+// This uses special macros defined in `memoryphases.def`.
+// See that file for more details on how this works.
+#define MEMORY_PHASE(kind, name) kind,
+#include "memoryphases.def"
+#undef MEMORY_PHASE
+};
+
+/// Returns the name of a memory phase, e.g. "lexer"
+const char* getMemoryPhaseName(MemoryPhase phase);
+
+/// Allocation counters of the whole process
+///
+/// Only counts when perun is built with PERUN_MEMORY_TRACKING
+/// (cmake -DPERUN_MEMORY_TRACKING=ON), which replaces the global
+/// operator new and delete. Every allocation then carries a small header
+/// with its size and the phase of the thread that made it (see
+/// MemoryScope), so that its release is subtracted from the same phase.
+/// The counters run from the start of the process.
+class MemoryTracker {
+public:
+    static constexpr size_t phaseCount =
+// This uses special macros defined in `memoryphases.def`.
+// See that file for more details on how this works.
+#define MEMORY_PHASE(kind, name) 1 +
+#include "memoryphases.def"
+#undef MEMORY_PHASE
+        0;
+
+    /// A phase is split further by a detail below this,
+    /// the ast phase uses ast::Node::Kind
+    static constexpr size_t detailCount = 32;
+
+    struct Counters {
+        uint64_t count = 0; // number of allocations
+        uint64_t bytes = 0; // allocated in total
+        uint64_t peak = 0;  // most bytes alive at once
+    };
+
+    /// True if built with PERUN_MEMORY_TRACKING
+    static bool isEnabled();
+
+    static Counters getTotal();
+    static Counters get(MemoryPhase phase);
+    static Counters get(MemoryPhase phase, size_t detail);
+};
+
+/// Attributes the allocations of the current thread to 'phase'
+/// (and its 'detail') for its own lifetime
+/// Compiles to nothing without PERUN_MEMORY_TRACKING.
+class MemoryScope {
+public:
+#ifdef PERUN_MEMORY_TRACKING
+    explicit MemoryScope(MemoryPhase phase, size_t detail = 0);
+    ~MemoryScope();
+#else
+    explicit MemoryScope(MemoryPhase, size_t = 0) {}
+#endif
+
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+#ifdef PERUN_MEMORY_TRACKING
+private:
+    uint16_t previous;
+#endif
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_MEMORY_HPP
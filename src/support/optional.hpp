@@ -1,11 +1,12 @@
 #ifndef PERUN_SUPPORT_OPTIONAL_HPP
 #define PERUN_SUPPORT_OPTIONAL_HPP
 
+#include <cassert>
+#include <utility>
+
 namespace perun {
 namespace support {
 
-#include <cassert>
-
 template <typename T>
 /// Basic optional storage
 class Optional {
@@ -0,0 +1,79 @@
+#include "output.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+namespace perun {
+namespace support {
+
+namespace {
+
+const char spaces[] = "                                                  "
+                      "                                                  ";
+constexpr size_t spacesSize = sizeof(spaces) - 1;
+
+} // namespace
+
+OutputBuffer::OutputBuffer(int fd, size_t flushThreshold)
+    : fd(fd), flushThreshold(flushThreshold) {
+    if (fd != noFd) {
+        // leave some space for the last write before flushing
+        buffer.reserve(flushThreshold + flushThreshold / 4);
+    }
+}
+
+void OutputBuffer::writeSpaces(size_t count) {
+    while (count > spacesSize) {
+        buffer.append(spaces, spacesSize);
+        count -= spacesSize;
+    }
+    buffer.append(spaces, count);
+    maybeFlush();
+}
+
+void OutputBuffer::writeUnsigned(uint64_t value) {
+    // digits are written backwards into a small stack buffer
+    char digits[20];
+    size_t i = sizeof(digits);
+    do {
+        digits[--i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+
+    write(digits + i, sizeof(digits) - i);
+}
+
+OutputBuffer& OutputBuffer::operator<<(const char* str) {
+    write(str, std::strlen(str));
+    return *this;
+}
+
+void OutputBuffer::flush() {
+    if (fd == noFd) {
+        return;
+    }
+
+    const char* data = buffer.data();
+    size_t remaining = buffer.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // nothing sensible to do, e.g. a closed pipe
+            break;
+        }
+
+        data += written;
+        remaining -= written;
+    }
+
+    flushedBytes += buffer.size();
+    buffer.clear();
+}
+
+} // namespace support
+} // namespace perun
@@ -0,0 +1,77 @@
+#ifndef PERUN_SUPPORT_OUTPUT_HPP
+#define PERUN_SUPPORT_OUTPUT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace perun {
+namespace support {
+
+/// Growable byte buffer for bulk output
+///
+/// Bypasses iostreams (locale, stdio sync, sentries) completely.
+/// If constructed with a file descriptor, the buffer is flushed into it
+/// with write(2) whenever it grows over 'flushThreshold' bytes,
+/// otherwise everything stays in memory and can be taken by 'getData'.
+class OutputBuffer {
+public:
+    static constexpr int noFd = -1;
+    static constexpr size_t defaultFlushThreshold = 64 * 1024;
+
+    explicit OutputBuffer(int fd = noFd,
+                          size_t flushThreshold = defaultFlushThreshold);
+    ~OutputBuffer() { flush(); }
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void write(const char* data, size_t size) {
+        buffer.append(data, size);
+        maybeFlush();
+    }
+
+    void writeSpaces(size_t count);
+    void writeUnsigned(uint64_t value);
+
+    OutputBuffer& operator<<(char c) {
+        buffer.push_back(c);
+        maybeFlush();
+        return *this;
+    }
+    OutputBuffer& operator<<(const char* str);
+    OutputBuffer& operator<<(const std::string& str) {
+        write(str.data(), str.size());
+        return *this;
+    }
+    OutputBuffer& operator<<(uint64_t value) {
+        writeUnsigned(value);
+        return *this;
+    }
+
+    /// Writes out the buffered data if there's a file descriptor
+    void flush();
+
+    /// Bytes written so far, including the flushed ones
+    size_t getBytesWritten() const { return flushedBytes + buffer.size(); }
+
+    /// Buffered data that haven't been flushed yet
+    const std::string& getData() const { return buffer; }
+
+private:
+    void maybeFlush() {
+        if (buffer.size() >= flushThreshold && fd != noFd) {
+            flush();
+        }
+    }
+
+    int fd;
+    size_t flushThreshold;
+    size_t flushedBytes = 0;
+    std::string buffer;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_OUTPUT_HPP
@@ -0,0 +1,194 @@
+#ifndef PERUN_SUPPORT_SMALLVECTOR_HPP
+#define PERUN_SUPPORT_SMALLVECTOR_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace perun {
+namespace support {
+
+/// Vector which keeps its first 'N' elements inline
+///
+/// Only allocates once it grows past 'N', after that it behaves like
+/// std::vector. Moving a small vector moves the elements one by one,
+/// a large one hands over its buffer.
+/// Supports the subset of the std::vector interface the ast needs.
+template <typename T, size_t N> class SmallVector {
+    static_assert(N > 0, "use std::vector for no inline elements");
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() : elements(inlineElements()), count(0), capacity_(N) {}
+
+    SmallVector(SmallVector&& other) noexcept : SmallVector() {
+        takeFrom(other);
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            clear();
+            release();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator=(const SmallVector&) = delete;
+
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return capacity_; }
+
+    /// True while the elements are inline
+    bool isSmall() const { return elements == inlineElements(); }
+
+    iterator begin() { return elements; }
+    iterator end() { return elements + count; }
+    const_iterator begin() const { return elements; }
+    const_iterator end() const { return elements + count; }
+
+    T& operator[](size_t i) {
+        assert(i < count);
+        return elements[i];
+    }
+    const T& operator[](size_t i) const {
+        assert(i < count);
+        return elements[i];
+    }
+
+    T& back() {
+        assert(count != 0);
+        return elements[count - 1];
+    }
+    const T& back() const {
+        assert(count != 0);
+        return elements[count - 1];
+    }
+
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    template <typename... Args> T& emplace_back(Args&&... args) {
+        if (count != capacity_) {
+            new (elements + count) T(std::forward<Args>(args)...);
+            return elements[count++];
+        }
+
+        // 'args' can refer to an element, so the new element is built
+        // before the old ones are moved away (like std::vector does)
+        size_t newCapacity = getGrownCapacity(count + 1);
+        T* newElements = allocate(newCapacity);
+        try {
+            new (newElements + count) T(std::forward<Args>(args)...);
+        } catch (...) {
+            ::operator delete(newElements);
+            throw;
+        }
+        moveTo(newElements, newCapacity);
+        return elements[count++];
+    }
+
+    void pop_back() {
+        assert(count != 0);
+        elements[--count].~T();
+    }
+
+    void clear() {
+        for (size_t i = 0; i < count; ++i) {
+            elements[i].~T();
+        }
+        count = 0;
+    }
+
+    void reserve(size_t n) {
+        if (n > capacity_) {
+            grow(n);
+        }
+    }
+
+private:
+    T* elements;
+    uint32_t count;
+    uint32_t capacity_;
+
+    alignas(T) unsigned char storage[N * sizeof(T)];
+
+    T* inlineElements() { return reinterpret_cast<T*>(storage); }
+    const T* inlineElements() const {
+        return reinterpret_cast<const T*>(storage);
+    }
+
+    size_t getGrownCapacity(size_t minCapacity) const {
+        size_t newCapacity = 2 * static_cast<size_t>(capacity_);
+        if (newCapacity < minCapacity) {
+            newCapacity = minCapacity;
+        }
+        assert(newCapacity <= UINT32_MAX);
+        return newCapacity;
+    }
+
+    static T* allocate(size_t capacity) {
+        return static_cast<T*>(::operator new(capacity * sizeof(T)));
+    }
+
+    /// Moves the elements into 'newElements' and takes it as the buffer
+    void moveTo(T* newElements, size_t newCapacity) {
+        for (size_t i = 0; i < count; ++i) {
+            new (newElements + i) T(std::move(elements[i]));
+            elements[i].~T();
+        }
+
+        release();
+        elements = newElements;
+        capacity_ = static_cast<uint32_t>(newCapacity);
+    }
+
+    void grow(size_t minCapacity) {
+        size_t newCapacity = getGrownCapacity(minCapacity);
+        moveTo(allocate(newCapacity), newCapacity);
+    }
+
+    /// Frees the buffer if it is on the heap, expects no elements
+    void release() {
+        if (!isSmall()) {
+            ::operator delete(elements);
+            elements = inlineElements();
+            capacity_ = N;
+        }
+    }
+
+    /// Expects this to be empty and inline, leaves 'other' so
+    void takeFrom(SmallVector& other) {
+        if (!other.isSmall()) {
+            elements = other.elements;
+            count = other.count;
+            capacity_ = other.capacity_;
+            other.elements = other.inlineElements();
+            other.count = 0;
+            other.capacity_ = N;
+            return;
+        }
+
+        for (size_t i = 0; i < other.count; ++i) {
+            new (elements + i) T(std::move(other.elements[i]));
+        }
+        count = other.count;
+        other.clear();
+    }
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_SMALLVECTOR_HPP
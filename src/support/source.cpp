@@ -0,0 +1,111 @@
+#include "source.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace perun {
+namespace support {
+
+FileID SourceManager::addBuffer(std::string filename,
+                                std::unique_ptr<SourceBuffer> buffer) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // + 1 for the end-of-file position
+    uint64_t end = nextStart + buffer->getSize() + 1;
+    if (end > UINT32_MAX) {
+        return invalidFileID;
+    }
+
+    auto&& entry = std::make_unique<Entry>();
+    entry->filename = std::move(filename);
+    entry->buffer = std::move(buffer);
+    entry->start = static_cast<uint32_t>(nextStart);
+
+    nextStart = end;
+    entries.push_back(std::move(entry));
+    return static_cast<FileID>(entries.size() - 1);
+}
+
+const SourceManager::Entry& SourceManager::getEntry(FileID file) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(file < entries.size() && "invalid file id");
+    return *entries[file];
+}
+
+const std::string& SourceManager::getFilename(FileID file) const {
+    return getEntry(file).filename;
+}
+
+StringRef SourceManager::getBuffer(FileID file) const {
+    return getEntry(file).buffer->getRef();
+}
+
+SourceLoc SourceManager::getLoc(FileID file, size_t pos) const {
+    auto&& entry = getEntry(file);
+    assert(pos <= entry.buffer->getSize());
+    return SourceLoc(entry.start + static_cast<uint32_t>(pos));
+}
+
+FileID SourceManager::getFileID(SourceLoc loc) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(loc.isValid() && !entries.empty());
+
+    // last entry which starts before or at the location
+    auto&& it = std::upper_bound(
+        entries.begin(), entries.end(), loc.getOffset(),
+        [](uint32_t offset, const std::unique_ptr<Entry>& entry) {
+            return offset < entry->start;
+        });
+    assert(it != entries.begin());
+
+    return static_cast<FileID>(it - entries.begin() - 1);
+}
+
+size_t SourceManager::getFilePos(SourceLoc loc) const {
+    return loc.getOffset() - getEntry(getFileID(loc)).start;
+}
+
+const std::vector<uint32_t>&
+SourceManager::getLineStarts(const Entry& entry) const {
+    std::call_once(entry.lineStartsFlag, [&entry]() {
+        auto&& buffer = entry.buffer->getRef();
+        entry.lineStarts.push_back(0);
+
+        const char* begin = buffer.data();
+        const char* end = begin + buffer.size();
+        const char* p = begin;
+        while ((p = static_cast<const char*>(
+                    std::memchr(p, '\n', end - p))) != nullptr) {
+            ++p;
+            entry.lineStarts.push_back(static_cast<uint32_t>(p - begin));
+        }
+    });
+
+    return entry.lineStarts;
+}
+
+PresumedLoc SourceManager::getPresumedLoc(SourceLoc loc) const {
+    FileID file = getFileID(loc);
+    auto&& entry = getEntry(file);
+    auto&& lineStarts = getLineStarts(entry);
+
+    size_t pos = loc.getOffset() - entry.start;
+
+    // last line which starts before or at the position
+    auto&& it = std::upper_bound(lineStarts.begin(), lineStarts.end(), pos);
+    size_t line = it - lineStarts.begin() - 1;
+    size_t lineStartPos = lineStarts[line];
+
+    // the line ends at the newline or at the end of the buffer
+    size_t lineEndPos = entry.buffer->getSize();
+    if (line + 1 < lineStarts.size()) {
+        lineEndPos = lineStarts[line + 1] - 1;
+    }
+
+    return PresumedLoc{file, line, pos - lineStartPos, lineStartPos,
+                       lineEndPos};
+}
+
+} // namespace support
+} // namespace perun
@@ -0,0 +1,124 @@
+#ifndef PERUN_SUPPORT_SOURCE_HPP
+#define PERUN_SUPPORT_SOURCE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "sourcebuffer.hpp"
+#include "stringref.hpp"
+
+namespace perun {
+namespace support {
+
+/// Compact source location -- a single 32-bit offset into the global
+/// address space of a SourceManager, which covers all of its buffers.
+/// Use SourceManager::getPresumedLoc to get the file, line and column.
+class SourceLoc {
+public:
+    constexpr SourceLoc() : offset(0) {}
+    explicit constexpr SourceLoc(uint32_t offset) : offset(offset) {}
+
+    /// The default location is invalid
+    constexpr bool isValid() const { return offset != 0; }
+
+    constexpr uint32_t getOffset() const { return offset; }
+
+    constexpr bool operator==(SourceLoc other) const {
+        return offset == other.offset;
+    }
+    constexpr bool operator!=(SourceLoc other) const {
+        return offset != other.offset;
+    }
+    constexpr bool operator<(SourceLoc other) const {
+        return offset < other.offset;
+    }
+
+private:
+    uint32_t offset;
+};
+
+/// Index of a buffer in a SourceManager
+using FileID = uint32_t;
+
+/// Decoded SourceLoc
+struct PresumedLoc {
+    FileID file;
+
+    // Note: line and column are 0-indexed, not 1-indexed!
+    size_t line, column;
+
+    // position of the start and end of the line in the buffer
+    size_t lineStartPos, lineEndPos;
+
+    /// Get the length of the line
+    size_t lineLength() const { return lineEndPos - lineStartPos; }
+};
+
+/// Owner of all loaded source buffers
+///
+/// Every buffer gets a range of the 32-bit SourceLoc address space
+/// (one extra offset for its end-of-file position), so any position
+/// in any file is a single integer. Line tables are built lazily on the
+/// first lookup into a file.
+/// All methods are thread-safe, buffers can be added while other threads
+/// look up locations.
+class SourceManager {
+public:
+    static constexpr FileID invalidFileID = UINT32_MAX;
+
+    /// Returns invalidFileID if the 32-bit address space is exhausted
+    FileID addBuffer(std::string filename,
+                     std::unique_ptr<SourceBuffer> buffer);
+    FileID addBuffer(std::string filename, std::string buffer) {
+        return addBuffer(std::move(filename),
+                         SourceBuffer::getMemory(std::move(buffer)));
+    }
+
+    const std::string& getFilename(FileID file) const;
+    StringRef getBuffer(FileID file) const;
+
+    /// Returns a location from a position in the buffer,
+    /// 'pos' can be equal to the buffer size (end of file)
+    SourceLoc getLoc(FileID file, size_t pos) const;
+
+    /// Asserts the location is valid
+    FileID getFileID(SourceLoc loc) const;
+
+    /// Position of the location in its buffer
+    size_t getFilePos(SourceLoc loc) const;
+
+    /// Decodes the location using the line table of its file
+    PresumedLoc getPresumedLoc(SourceLoc loc) const;
+
+private:
+    struct Entry {
+        std::string filename;
+        std::unique_ptr<SourceBuffer> buffer;
+        uint32_t start;
+
+        // start positions of all lines, built lazily
+        mutable std::vector<uint32_t> lineStarts;
+        mutable std::once_flag lineStartsFlag;
+    };
+
+    const Entry& getEntry(FileID file) const;
+    const std::vector<uint32_t>& getLineStarts(const Entry& entry) const;
+
+    // guards 'entries' and 'nextStart' but not the entries themselves,
+    // they are immutable apart from the lazily built line tables
+    mutable std::mutex mutex;
+
+    // entries are behind a pointer so they don't move around
+    std::vector<std::unique_ptr<Entry>> entries;
+
+    // offset 0 is reserved for the invalid location
+    uint64_t nextStart = 1;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_SOURCE_HPP
@@ -0,0 +1,106 @@
+#include "sourcebuffer.hpp"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace perun {
+namespace support {
+
+namespace {
+
+// closes the file descriptor on every return path
+struct FileDescriptor {
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    ~FileDescriptor() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    int fd;
+};
+
+/// Reads everything from 'fd', returns false on an error
+bool readAll(int fd, std::string& out) {
+    char chunk[64 * 1024];
+    while (true) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        out.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+} // namespace
+
+SourceBuffer::~SourceBuffer() {
+    if (mapped) {
+        ::munmap(const_cast<char*>(data), size);
+    }
+}
+
+std::unique_ptr<SourceBuffer>
+SourceBuffer::getFile(const std::string& filename, bool mayMap) {
+    FileDescriptor file(::open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(file.fd, &st) != 0) {
+        return nullptr;
+    }
+
+    // empty files can't be mapped
+    if (mayMap && S_ISREG(st.st_mode) && st.st_size > 0) {
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        // the whole file is going to be read anyway, fault it in at once
+        flags |= MAP_POPULATE;
+#endif
+        size_t size = static_cast<size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, size, PROT_READ, flags, file.fd, 0);
+        if (addr != MAP_FAILED) {
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+
+            std::unique_ptr<SourceBuffer> buffer(new SourceBuffer());
+            buffer->data = static_cast<const char*>(addr);
+            buffer->size = size;
+            buffer->mapped = true;
+            return buffer;
+        }
+        // fall back to reading
+    }
+
+    std::string contents{};
+    if (S_ISREG(st.st_mode)) {
+        contents.reserve(static_cast<size_t>(st.st_size));
+    }
+    if (!readAll(file.fd, contents)) {
+        return nullptr;
+    }
+
+    return getMemory(std::move(contents));
+}
+
+std::unique_ptr<SourceBuffer> SourceBuffer::getMemory(std::string buffer) {
+    std::unique_ptr<SourceBuffer> result(new SourceBuffer());
+    result->owned = std::move(buffer);
+    result->data = result->owned.data();
+    result->size = result->owned.size();
+    return result;
+}
+
+} // namespace support
+} // namespace perun
@@ -0,0 +1,55 @@
+#ifndef PERUN_SUPPORT_SOURCEBUFFER_HPP
+#define PERUN_SUPPORT_SOURCEBUFFER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "stringref.hpp"
+
+namespace perun {
+namespace support {
+
+/// Immutable contents of a source file
+///
+/// Regular files are memory-mapped (read-only, pre-faulted and advised
+/// for sequential access), so loading a file copies nothing.
+/// Anything which can't be mapped (pipes, character devices) is read
+/// with read(2) into an owned string.
+/// A mapping raises SIGBUS once the file is truncated, so buffers which
+/// are kept beyond a single run (daemon, watch mode) should be read.
+class SourceBuffer {
+public:
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    /// Returns nullptr if the file couldn't be opened or read
+    /// The file is always read if 'mayMap' is false
+    static std::unique_ptr<SourceBuffer> getFile(const std::string& filename,
+                                                 bool mayMap = true);
+
+    /// Takes ownership of an in-memory buffer
+    static std::unique_ptr<SourceBuffer> getMemory(std::string buffer);
+
+    StringRef getRef() const { return StringRef(data, size); }
+    size_t getSize() const { return size; }
+
+    bool isMapped() const { return mapped; }
+
+private:
+    SourceBuffer() = default;
+
+    const char* data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+
+    // storage of non-mapped buffers
+    std::string owned;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_SOURCEBUFFER_HPP
@@ -0,0 +1,93 @@
+#ifndef PERUN_SUPPORT_SPSCRING_HPP
+#define PERUN_SUPPORT_SPSCRING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace perun {
+namespace support {
+
+/// Lock-free bounded queue between exactly one producer thread
+/// and exactly one consumer thread
+///
+/// Both sides move whole batches, so the shared indices are touched
+/// once per batch instead of once per value. Each side keeps a copy
+/// of the other side's index and reloads it only when the ring seems
+/// full (or empty), the indices live on separate cache lines.
+template <typename T> class SPSCRing {
+public:
+    /// 'capacity' must be a power of two, the slots start as 'filler'
+    SPSCRing(size_t capacity, const T& filler)
+        : slots(capacity, filler), mask(capacity - 1) {
+        assert(capacity != 0 && (capacity & mask) == 0 &&
+               "capacity must be a power of two");
+    }
+
+    SPSCRing(const SPSCRing&) = delete;
+    SPSCRing& operator=(const SPSCRing&) = delete;
+
+    size_t getCapacity() const { return slots.size(); }
+
+    /// Producer only, pushes as many of 'values' as fit
+    /// Returns how many were pushed.
+    size_t push(const T* values, size_t count) {
+        const size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - cachedHead + count > slots.size()) {
+            cachedHead = head.load(std::memory_order_acquire);
+        }
+
+        const size_t pushed =
+            std::min(count, slots.size() - (tail - cachedHead));
+        for (size_t i = 0; i < pushed; ++i) {
+            slots[(tail + i) & mask] = values[i];
+        }
+        if (pushed != 0) {
+            this->tail.store(tail + pushed, std::memory_order_release);
+        }
+        return pushed;
+    }
+
+    /// Consumer only, pops at most 'count' values into 'out'
+    /// Returns how many were popped.
+    size_t pop(T* out, size_t count) {
+        const size_t head = this->head.load(std::memory_order_relaxed);
+        if (cachedTail == head) {
+            cachedTail = tail.load(std::memory_order_acquire);
+        }
+
+        const size_t popped = std::min(count, cachedTail - head);
+        for (size_t i = 0; i < popped; ++i) {
+            out[i] = slots[(head + i) & mask];
+        }
+        if (popped != 0) {
+            this->head.store(head + popped, std::memory_order_release);
+        }
+        return popped;
+    }
+
+private:
+    static constexpr size_t cacheLineSize = 64;
+
+    std::vector<T> slots;
+    const size_t mask;
+
+    // written by the consumer
+    char headPadding[cacheLineSize];
+    std::atomic<size_t> head{0};
+    size_t cachedTail = 0;
+
+    // written by the producer
+    char tailPadding[cacheLineSize];
+    std::atomic<size_t> tail{0};
+    size_t cachedHead = 0;
+
+    char endPadding[cacheLineSize];
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_SPSCRING_HPP
@@ -0,0 +1,60 @@
+#ifndef PERUN_SUPPORT_STRINGREF_HPP
+#define PERUN_SUPPORT_STRINGREF_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace perun {
+namespace support {
+
+/// Non-owning reference to a string, a slice of some buffer
+/// The referenced data must outlive the StringRef.
+class StringRef {
+public:
+    constexpr StringRef() : _data(nullptr), _size(0) {}
+    constexpr StringRef(const char* data, size_t size)
+        : _data(data), _size(size) {}
+    StringRef(const char* str) : _data(str), _size(std::strlen(str)) {}
+    StringRef(const std::string& str) : _data(str.data()), _size(str.size()) {}
+
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    const char* begin() const { return _data; }
+    const char* end() const { return _data + _size; }
+
+    char operator[](size_t i) const {
+        assert(i < _size && "index out of bounds");
+        return _data[i];
+    }
+
+    /// Clamped like std::string::substr, but never copies
+    StringRef substr(size_t start, size_t length = std::string::npos) const {
+        assert(start <= _size && "index out of bounds");
+        if (length > _size - start) {
+            length = _size - start;
+        }
+        return StringRef(_data + start, length);
+    }
+
+    /// Copies the data into a new string
+    std::string str() const { return std::string(_data, _size); }
+
+    bool operator==(StringRef other) const {
+        return _size == other._size &&
+               (_size == 0 || std::memcmp(_data, other._data, _size) == 0);
+    }
+    bool operator!=(StringRef other) const { return !(*this == other); }
+
+private:
+    const char* _data;
+    size_t _size;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_STRINGREF_HPP
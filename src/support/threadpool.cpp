@@ -0,0 +1,79 @@
+#include "threadpool.hpp"
+
+namespace perun {
+namespace support {
+
+size_t ThreadPool::getHardwareThreads() {
+    // can be 0 if it is not computable
+    size_t threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    if (threads == 0) {
+        threads = getHardwareThreads();
+    }
+
+    // the thread which waits runs tasks as well
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    hasTask.notify_all();
+    for (auto&& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::async(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    hasTask.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!tasks.empty()) {
+        runTask(lock);
+    }
+    allDone.wait(lock, [this]() { return tasks.empty() && running == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        hasTask.wait(lock, [this]() { return stopping || !tasks.empty(); });
+        if (tasks.empty()) {
+            // stopping
+            return;
+        }
+        runTask(lock);
+    }
+}
+
+void ThreadPool::runTask(std::unique_lock<std::mutex>& lock) {
+    std::function<void()> task = std::move(tasks.front());
+    tasks.pop_front();
+    running++;
+
+    lock.unlock();
+    task();
+    lock.lock();
+
+    running--;
+    if (tasks.empty() && running == 0) {
+        allDone.notify_all();
+    }
+}
+
+} // namespace support
+} // namespace perun
@@ -0,0 +1,78 @@
+#ifndef PERUN_SUPPORT_THREADPOOL_HPP
+#define PERUN_SUPPORT_THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace perun {
+namespace support {
+
+/// Fixed-size pool of worker threads
+///
+/// A pool with zero workers is valid, all tasks then run on the thread
+/// which calls 'wait'. The destructor waits for all pending tasks.
+class ThreadPool {
+public:
+    /// Sized to the machine if 'threads' is 0
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Number of threads running tasks, including the waiting thread
+    size_t getThreadCount() const { return workers.size() + 1; }
+
+    void async(std::function<void()> task);
+
+    /// Waits until all tasks are done, helps with running them meanwhile
+    void wait();
+
+    /// Calls 'f(i)' for every i in [0, count) on the pool and waits
+    /// Indices are handed out one by one, so uneven work is balanced.
+    template <typename F> void parallelFor(size_t count, F&& f) {
+        std::atomic<size_t> next(0);
+        auto&& worker = [&]() {
+            for (size_t i = next++; i < count; i = next++) {
+                f(i);
+            }
+        };
+
+        size_t tasks = std::min(count, getThreadCount());
+        for (size_t i = 1; i < tasks; ++i) {
+            async(worker);
+        }
+        worker();
+        wait();
+    }
+
+    /// Default size of the pool
+    static size_t getHardwareThreads();
+
+private:
+    void workerLoop();
+
+    /// Pops and runs one task, expects 'lock' to be held
+    void runTask(std::unique_lock<std::mutex>& lock);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable hasTask;
+    std::condition_variable allDone;
+    std::deque<std::function<void()>> tasks;
+    size_t running = 0;
+    bool stopping = false;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_THREADPOOL_HPP
@@ -0,0 +1,53 @@
+#ifndef PERUN_SUPPORT_TIMER_HPP
+#define PERUN_SUPPORT_TIMER_HPP
+
+#include <chrono>
+
+namespace perun {
+namespace support {
+
+/// Accumulating monotonic timer
+/// Can be started and stopped repeatedly, the elapsed times add up.
+class Timer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void start() { startTime = Clock::now(); }
+    void stop() { elapsed += Clock::now() - startTime; }
+
+    double getSeconds() const {
+        return std::chrono::duration<double>(elapsed).count();
+    }
+
+private:
+    Clock::time_point startTime;
+    Clock::duration elapsed = Clock::duration::zero();
+};
+
+/// Times its own lifetime into a Timer
+/// Does nothing (doesn't even read the clock) for a null timer,
+/// so it can be left in hot paths.
+class TimerScope {
+public:
+    explicit TimerScope(Timer* timer) : timer(timer) {
+        if (timer != nullptr) {
+            timer->start();
+        }
+    }
+    ~TimerScope() {
+        if (timer != nullptr) {
+            timer->stop();
+        }
+    }
+
+    TimerScope(const TimerScope&) = delete;
+    TimerScope& operator=(const TimerScope&) = delete;
+
+private:
+    Timer* timer;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_TIMER_HPP
@@ -0,0 +1,172 @@
+#include "trace.hpp"
+
+#include "json.hpp"
+#include "output.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace perun {
+namespace support {
+
+namespace {
+
+struct Span {
+    const char* name;
+    std::string detail;
+    uint64_t start;
+    uint64_t end;
+    const char* argName;
+    uint64_t arg;
+};
+
+struct ThreadBuffer {
+    uint32_t tid;
+    std::vector<Span> spans;
+};
+
+/// State of the current recording
+struct Recording {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::chrono::steady_clock::time_point epoch;
+
+    // bumped by every start() and stop(),
+    // invalidates the cached thread buffers
+    std::atomic<uint64_t> generation{0};
+};
+
+Recording& getRecording() {
+    static Recording recording;
+    return recording;
+}
+
+struct CachedBuffer {
+    uint64_t generation = 0;
+    ThreadBuffer* buffer = nullptr;
+};
+
+thread_local CachedBuffer cachedBuffer;
+
+ThreadBuffer& getThreadBuffer() {
+    auto&& recording = getRecording();
+    if (cachedBuffer.buffer != nullptr &&
+        cachedBuffer.generation == recording.generation) {
+        return *cachedBuffer.buffer;
+    }
+
+    std::lock_guard<std::mutex> lock(recording.mutex);
+    auto&& buffer = std::make_unique<ThreadBuffer>();
+    buffer->tid = static_cast<uint32_t>(recording.buffers.size());
+
+    cachedBuffer.generation = recording.generation;
+    cachedBuffer.buffer = buffer.get();
+    recording.buffers.push_back(std::move(buffer));
+    return *cachedBuffer.buffer;
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::enabled(false);
+
+void Tracer::start() {
+    auto&& recording = getRecording();
+    {
+        std::lock_guard<std::mutex> lock(recording.mutex);
+        recording.buffers.clear();
+        recording.epoch = std::chrono::steady_clock::now();
+        recording.generation++;
+    }
+    enabled.store(true, std::memory_order_release);
+}
+
+uint64_t Tracer::now() {
+    auto&& elapsed = std::chrono::steady_clock::now() - getRecording().epoch;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+        .count();
+}
+
+void Tracer::addSpan(const char* name, StringRef detail, uint64_t start,
+                     uint64_t end, const char* argName, uint64_t arg) {
+    getThreadBuffer().spans.push_back(
+        {name, detail.str(), start, end, argName, arg});
+}
+
+bool Tracer::stop(const std::string& path) {
+    enabled.store(false, std::memory_order_release);
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                    0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    // writes a time in microseconds with nanosecond precision
+    auto&& writeMicros = [](OutputBuffer& out, uint64_t ns) {
+        out << ns / 1000 << '.';
+        const char digits[] = {static_cast<char>('0' + ns % 1000 / 100),
+                               static_cast<char>('0' + ns % 100 / 10),
+                               static_cast<char>('0' + ns % 10)};
+        out.write(digits, sizeof(digits));
+    };
+
+    {
+        OutputBuffer out(fd);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+        auto&& recording = getRecording();
+        std::lock_guard<std::mutex> lock(recording.mutex);
+
+        bool first = true;
+        for (auto&& buffer : recording.buffers) {
+            // thread names are shown instead of the raw ids
+            const uint64_t tid = buffer->tid;
+            out << (first ? "" : ",\n")
+                << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+                << "\"tid\":" << tid << ",\"args\":{\"name\":\"thread "
+                << tid << "\"}}";
+            first = false;
+
+            for (auto&& span : buffer->spans) {
+                out << ",\n{\"ph\":\"X\",\"cat\":\"perun\",\"name\":\""
+                    << span.name << "\",\"pid\":1,\"tid\":"
+                    << tid << ",\"ts\":";
+                writeMicros(out, span.start);
+                out << ",\"dur\":";
+                writeMicros(out, span.end - span.start);
+                out << ",\"args\":{\"detail\":";
+                writeJSONString(out, span.detail);
+                if (span.argName != nullptr) {
+                    out << ",\"" << span.argName << "\":" << span.arg;
+                }
+                out << '}';
+                out << '}';
+            }
+        }
+
+        out << "\n]}\n";
+        // scopes which are still open must not use the freed buffers
+        recording.buffers.clear();
+        recording.generation++;
+    }
+
+    return ::close(fd) == 0;
+}
+
+void Tracer::cancel() {
+    enabled.store(false, std::memory_order_release);
+
+    auto&& recording = getRecording();
+    std::lock_guard<std::mutex> lock(recording.mutex);
+    // scopes which are still open must not use the freed buffers
+    recording.buffers.clear();
+    recording.generation++;
+}
+
+} // namespace support
+} // namespace perun
@@ -0,0 +1,92 @@
+#ifndef PERUN_SUPPORT_TRACE_HPP
+#define PERUN_SUPPORT_TRACE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "stringref.hpp"
+
+namespace perun {
+namespace support {
+
+/// Process-wide recorder of timed spans
+///
+/// Every thread appends into its own buffer, the only lock is taken
+/// the first time a thread records a span. The spans are written
+/// in the Chrome Trace Event format, which chrome://tracing
+/// and Perfetto can open.
+/// Recording is off by default, in which case a TraceScope costs
+/// a single relaxed load.
+class Tracer {
+public:
+    /// Starts recording, drops the spans of a previous recording
+    static void start();
+
+    /// Stops recording and writes all spans into 'path'
+    /// Expects that no other thread is recording at the moment.
+    /// Returns false if the file couldn't be written.
+    static bool stop(const std::string& path);
+
+    /// Stops recording and drops the spans
+    /// Expects that no other thread is recording at the moment.
+    static void cancel();
+
+    static bool isEnabled() { return enabled.load(std::memory_order_acquire); }
+
+    /// Nanoseconds since the recording started
+    static uint64_t now();
+
+    /// Records a span [start, end) on the current thread
+    /// 'name' and 'argName' must be string literals, 'detail' is copied,
+    /// the argument is written only if 'argName' is not null
+    static void addSpan(const char* name, StringRef detail, uint64_t start,
+                        uint64_t end, const char* argName = nullptr,
+                        uint64_t arg = 0);
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+/// Records a span for its own lifetime
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, StringRef detail = StringRef())
+        : name(name), detail(detail), active(Tracer::isEnabled()),
+          start(active ? Tracer::now() : 0) {}
+    ~TraceScope() {
+        if (active) {
+            Tracer::addSpan(name, detail, start, Tracer::now(), argName, arg);
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    /// Changes the detail, the referenced string must outlive the scope
+    void setDetail(StringRef d) { detail = d; }
+
+    /// Adds a numeric argument, 'key' must be a string literal
+    void setArg(const char* key, uint64_t value) {
+        argName = key;
+        arg = value;
+    }
+
+    /// The span won't be recorded
+    void cancel() { active = false; }
+
+    bool isActive() const { return active; }
+
+private:
+    const char* name;
+    StringRef detail;
+    bool active;
+    uint64_t start;
+    const char* argName = nullptr;
+    uint64_t arg = 0;
+};
+
+} // namespace support
+} // namespace perun
+
+#endif // PERUN_SUPPORT_TRACE_HPP
@@ -1,22 +1,17 @@
-#include <fstream>
-#include <iostream>
-#include <sstream>
-#include <string>
+#include "util.hpp"
+
+#include "sourcebuffer.hpp"
 
 namespace perun {
 namespace support {
 
 std::string readFile(const std::string& filename) {
-    std::ifstream in(filename);
-
-    if (in) {
-        std::stringstream buffer;
-        buffer << in.rdbuf();
-        in.close();
-        return buffer.str();
+    auto&& buffer = SourceBuffer::getFile(filename);
+    if (buffer == nullptr) {
+        return "";
     }
 
-    return "";
+    return buffer->getRef().str();
 }
 
 } // namespace support